@@ -0,0 +1,164 @@
+// AutoSave.h
+#ifndef AUTO_SAVE_H // Start of include guard
+#define AUTO_SAVE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MazeSave.h" // SaveSnapshot + atomic writeSaveFile
+#include "MazeSim.h"  // Source of the snapshots
+
+// Background save service. The game thread only takes a snapshot (MazeSim::snapshot(),
+// O(items + enemies) thanks to the copy-on-write wall plane) and drops it in a mailbox; a
+// writer thread does the CRC and the file I/O, writing to a temp file and renaming it over
+// the old save. The game loop never waits for the disk.
+// The mailbox keeps only the newest snapshot per file: if the disk falls behind, older
+// unwritten snapshots are replaced (counted as superseded) rather than queued up.
+class AutoSaver {
+public:
+    struct Stats {
+        std::uint64_t written;    // Saves that reached the disk
+        std::uint64_t superseded; // Snapshots replaced by a newer one before they were written
+        std::uint64_t failed;     // Writes that failed (see takeError)
+        double lastWriteSeconds;  // Writer-thread time of the most recent save
+    };
+
+private:
+    struct Job {
+        std::string filename;
+        SaveSnapshot snapshot;
+    };
+
+    std::string autosaveFile;
+    int everyMoves;      // Autosave after this many moves (0 = never by moves)
+    double everySeconds; // ...or after this long, if anything moved since (0 = never by time)
+    int lastMoves;
+    std::chrono::steady_clock::time_point lastTime;
+
+    std::mutex lock;
+    std::condition_variable wake, idle;
+    std::vector<Job> pending; // Newest unwritten snapshot per file
+    bool writing;
+    bool stopping;
+    Stats stats;
+    std::string lastError;
+    std::thread writer; // Declared last: started once everything above is initialised
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            wake.wait(guard, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) break; // Stopping, and everything has been written
+            Job job = std::move(pending.front());
+            pending.erase(pending.begin());
+            writing = true;
+            guard.unlock();
+
+            std::string error;
+            auto start = std::chrono::steady_clock::now();
+            const bool ok = writeSaveFile(job.snapshot, job.filename, &error);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            job = Job(); // Release the snapshot (and its share of the wall plane) before reporting
+
+            guard.lock();
+            writing = false;
+            stats.lastWriteSeconds = seconds;
+            if (ok) stats.written++;
+            else {
+                stats.failed++;
+                lastError = error;
+            }
+            if (pending.empty()) idle.notify_all();
+        }
+    }
+
+public:
+    explicit AutoSaver(const std::string& filename = "maze_autosave.dat", int moves = 100, double seconds = 60.0)
+        : autosaveFile(filename), everyMoves(moves), everySeconds(seconds), lastMoves(0),
+          lastTime(std::chrono::steady_clock::now()), writing(false), stopping(false), stats(),
+          writer(&AutoSaver::writerLoop, this) {}
+
+    // Anything still queued is written before the thread exits
+    ~AutoSaver() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    // Autosave every 'moves' moves or every 'seconds' seconds, whichever comes first (0 turns a trigger off)
+    void setInterval(int moves, double seconds) {
+        everyMoves = moves;
+        everySeconds = seconds;
+    }
+    const std::string& getFilename() const { return autosaveFile; }
+
+    // Call once per game-loop iteration. Queues a snapshot of 'sim' when an interval has
+    // passed; returns true if it did. Costs a snapshot and a mutex hand-off, never I/O.
+    bool poll(const MazeSim& sim) {
+        const int moves = sim.getMoves();
+        if (moves < lastMoves) lastMoves = moves; // New game: the counter started over
+        if (moves == lastMoves) return false;     // Nothing happened since the last autosave
+        const auto now = std::chrono::steady_clock::now();
+        const bool byMoves = everyMoves > 0 && moves - lastMoves >= everyMoves;
+        const bool byTime = everySeconds > 0 && std::chrono::duration<double>(now - lastTime).count() >= everySeconds;
+        if (!byMoves && !byTime) return false;
+        lastMoves = moves;
+        lastTime = now;
+        submit(sim.snapshot(), autosaveFile);
+        return true;
+    }
+
+    // Queue 'snapshot' for 'filename' and return at once. An unwritten snapshot for the same
+    // file is replaced.
+    void submit(SaveSnapshot snapshot, const std::string& filename) {
+        Job replaced; // Destroyed after the lock is released
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            bool queued = false;
+            for (Job& job : pending) {
+                if (job.filename != filename) continue;
+                std::swap(replaced.snapshot, job.snapshot);
+                job.snapshot = std::move(snapshot);
+                stats.superseded++;
+                queued = true;
+                break;
+            }
+            if (!queued) pending.push_back(Job{ filename, std::move(snapshot) });
+        }
+        wake.notify_one();
+    }
+
+    // Block until everything queued so far is on disk (before loading a save, or in tests)
+    void flush() {
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [this] { return pending.empty() && !writing; });
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+    // Most recent write error since the last call, if any
+    bool takeError(std::string& error) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (lastError.empty()) return false;
+        error.swap(lastError);
+        lastError.clear();
+        return true;
+    }
+};
+
+#endif // AUTO_SAVE_H
@@ -0,0 +1,367 @@
+// ChunkedWorld.h
+#ifndef CHUNKED_WORLD_H // Start of include guard
+#define CHUNKED_WORLD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MazeGenerator.h" // EllerRowStream writes a world one row at a time
+#include "MazeRandom.h"    // Item placement while writing
+
+// Mazes too big for memory (POSIX only: mmap). A 100k x 100k world is 10^10 squares; even at
+// MazeGrid's 1 byte + 1 bit per square that is 11 GB, so a world lives in a file instead and
+// only the tiles around the player are ever resident.
+//
+// The file is a 4 KB header followed by fixed-size tiles, WORLD_TILE x WORLD_TILE squares
+// each, row-major by tile. A tile is two bit-planes laid out like MazeGrid's wall plane
+// (WORLD_TILE_WORDS_PER_ROW words per row): walls, then items. That is exactly 4 KB, so
+// every tile is one page and the OS pages it in and out whole. Squares past the world's
+// edge in the last row/column of tiles are walls.
+//
+// ChunkedWorld maps the file (MAP_SHARED: taking an item writes straight through to it) and
+// keeps an LRU list of the tiles it considers resident, at most 'cacheTiles' of them. Every
+// lookup goes through tileFor(), which moves the tile to the front of the list (or admits
+// it, evicting the least recently used tile with MADV_DONTNEED so its page leaves the
+// process). The previous lookup's tile is remembered, so runs of lookups in one tile - the
+// common case - skip the list entirely. prefetch() admits a whole window of tiles ahead of
+// time with MADV_WILLNEED, so the disk reads for tiles the player is about to enter are
+// already in flight.
+
+const int WORLD_TILE = 128;                                            // Tile side, in squares
+const std::size_t WORLD_TILE_WORDS_PER_ROW = WORLD_TILE / 64;          // Words per tile row, per plane
+const std::size_t WORLD_PLANE_WORDS = WORLD_TILE * WORLD_TILE_WORDS_PER_ROW;
+const std::size_t WORLD_TILE_BYTES = 2 * WORLD_PLANE_WORDS * sizeof(std::uint64_t); // Walls + items: 4 KB
+const std::size_t WORLD_HEADER_BYTES = 4096;                           // Keeps tiles page-aligned
+
+const char WORLD_MAGIC[8] = { 'M', 'A', 'Z', 'E', 'W', 'R', 'L', 'D' };
+const std::uint32_t WORLD_VERSION = 1;
+const int MAX_WORLD_SIZE = 1 << 22; // Rows / columns; keeps tile ids in 32 bits
+
+struct WorldHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t tileSize;    // WORLD_TILE when written
+    std::uint64_t rows, cols;
+    std::uint64_t tileRows, tileCols;
+    std::uint64_t seed;
+    std::uint64_t itemCount;   // Items when the world was created
+    std::uint64_t tileOffset;  // WORLD_HEADER_BYTES
+    std::uint64_t fileBytes;
+};
+
+// Write a rows x cols perfect maze (Eller's algorithm, streamed, so memory stays at one row
+// of tiles however big the world is) with roughly one item per 'itemEvery' open squares.
+// Returns false and fills 'error' on failure (the partial file is removed).
+inline bool createWorldFile(const std::string& filename, int rows, int cols, std::uint64_t seed, int itemEvery = 64,
+                            std::string* error = nullptr) {
+    if (rows < 3 || cols < 3 || rows > MAX_WORLD_SIZE || cols > MAX_WORLD_SIZE) {
+        if (error) *error = "World size must be between 3 and " + std::to_string(MAX_WORLD_SIZE) + ".";
+        return false;
+    }
+    if (itemEvery < 1) itemEvery = 1;
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        if (error) *error = "Could not open file " + filename + " for writing!";
+        return false;
+    }
+    WorldHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, WORLD_MAGIC, sizeof(WORLD_MAGIC));
+    header.version = WORLD_VERSION;
+    header.tileSize = WORLD_TILE;
+    header.rows = static_cast<std::uint64_t>(rows);
+    header.cols = static_cast<std::uint64_t>(cols);
+    header.tileRows = (header.rows + WORLD_TILE - 1) / WORLD_TILE;
+    header.tileCols = (header.cols + WORLD_TILE - 1) / WORLD_TILE;
+    header.seed = seed;
+    header.tileOffset = WORLD_HEADER_BYTES;
+    header.fileBytes = WORLD_HEADER_BYTES + header.tileRows * header.tileCols * WORLD_TILE_BYTES;
+
+    std::vector<unsigned char> headerBlock(WORLD_HEADER_BYTES, 0); // Header, rewritten at the end with the item count
+    bool ok = std::fwrite(headerBlock.data(), 1, headerBlock.size(), file) == headerBlock.size();
+
+    // One row of tiles at a time: filled as the stream emits grid rows, then written out
+    const std::size_t tileWords = WORLD_TILE_BYTES / sizeof(std::uint64_t);
+    std::vector<std::uint64_t> band(static_cast<std::size_t>(header.tileCols) * tileWords);
+    std::vector<char> line(static_cast<std::size_t>(cols));
+    EllerRowStream stream(rows, cols, seed);
+    for (int bandStart = 0; ok && bandStart < rows; bandStart += WORLD_TILE) {
+        // Walls everywhere to start with: squares past the edge stay that way
+        for (std::size_t t = 0; t < header.tileCols; t++) {
+            std::uint64_t* tile = &band[t * tileWords];
+            for (std::size_t w = 0; w < WORLD_PLANE_WORDS; w++) tile[w] = ~std::uint64_t(0);
+            for (std::size_t w = 0; w < WORLD_PLANE_WORDS; w++) tile[WORLD_PLANE_WORDS + w] = 0;
+        }
+        for (int r = 0; r < WORLD_TILE && bandStart + r < rows; r++) {
+            const int x = bandStart + r;
+            stream.nextRow(line.data());
+            // Items: a countdown over the row's open squares, from a per-row generator, so a
+            // (seed, row) always gets the same items
+            SplitMix64 rowRng(mix64(seed ^ (static_cast<std::uint64_t>(x) * 0x9E3779B97F4A7C15ull)));
+            std::uint32_t untilItem = rowRng.below(2 * static_cast<std::uint32_t>(itemEvery));
+            for (int y = 0; y < cols; y++) {
+                std::uint64_t* tile = &band[static_cast<std::size_t>(y / WORLD_TILE) * tileWords];
+                const std::size_t word = static_cast<std::size_t>(r) * WORLD_TILE_WORDS_PER_ROW + (y % WORLD_TILE) / 64;
+                const std::uint64_t bit = std::uint64_t(1) << (y & 63);
+                if (line[y] == '#') continue;
+                tile[word] &= ~bit;
+                if (x == 1 && y == 1) continue; // The start stays clear
+                if (untilItem-- == 0) {
+                    tile[WORLD_PLANE_WORDS + word] |= bit;
+                    header.itemCount++;
+                    untilItem = rowRng.below(2 * static_cast<std::uint32_t>(itemEvery));
+                }
+            }
+        }
+        ok = std::fwrite(band.data(), sizeof(std::uint64_t), band.size(), file) == band.size();
+    }
+
+    std::memcpy(headerBlock.data(), &header, sizeof(header));
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 &&
+         std::fwrite(headerBlock.data(), 1, headerBlock.size(), file) == headerBlock.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(filename.c_str());
+        if (error) *error = "Error writing world file " + filename + ".";
+        return false;
+    }
+    return true;
+}
+
+class ChunkedWorld {
+private:
+    static constexpr std::uint32_t NONE = ~std::uint32_t(0);
+
+    unsigned char* base;  // Whole file, mapped
+    std::size_t length;
+    WorldHeader header;
+    int rows, cols;
+    std::uint32_t tileCols;
+    std::size_t tileCount;
+
+    // LRU bookkeeping over tile ids (mutable: lookups are logically const)
+    mutable std::vector<std::uint32_t> newer, older; // Doubly linked list, NONE-terminated
+    mutable std::vector<std::uint8_t> resident;
+    mutable std::uint32_t newest, oldest;
+    mutable std::size_t residentCount;
+    std::size_t capacity;
+    mutable std::uint32_t lastTile;          // Tile of the previous lookup (already at the front)
+    mutable std::uint64_t* lastTileWords;
+    mutable std::uint64_t tileLoads, tileEvictions, lookups;
+
+    std::uint64_t* wordsOf(std::uint32_t tile) const {
+        return reinterpret_cast<std::uint64_t*>(base + header.tileOffset + static_cast<std::size_t>(tile) * WORLD_TILE_BYTES);
+    }
+
+    void unlink(std::uint32_t tile) const {
+        if (newer[tile] != NONE) older[newer[tile]] = older[tile];
+        else newest = older[tile];
+        if (older[tile] != NONE) newer[older[tile]] = newer[tile];
+        else oldest = newer[tile];
+    }
+
+    void pushNewest(std::uint32_t tile) const {
+        newer[tile] = NONE;
+        older[tile] = newest;
+        if (newest != NONE) newer[newest] = tile;
+        newest = tile;
+        if (oldest == NONE) oldest = tile;
+    }
+
+    void evictOldest() const {
+        const std::uint32_t victim = oldest;
+        unlink(victim);
+        resident[victim] = 0;
+        residentCount--;
+        tileEvictions++;
+        ::madvise(wordsOf(victim), WORLD_TILE_BYTES, MADV_DONTNEED); // Page leaves the process; data stays in the file
+        if (victim == lastTile) lastTile = NONE;
+    }
+
+    // Make 'tile' the most recently used, admitting it (and evicting the oldest) if needed
+    void touch(std::uint32_t tile, bool willNeed) const {
+        if (resident[tile]) {
+            if (newest != tile) {
+                unlink(tile);
+                pushNewest(tile);
+            }
+            return;
+        }
+        if (residentCount >= capacity) evictOldest();
+        resident[tile] = 1;
+        residentCount++;
+        tileLoads++;
+        pushNewest(tile);
+        if (willNeed) ::madvise(wordsOf(tile), WORLD_TILE_BYTES, MADV_WILLNEED);
+    }
+
+    std::uint32_t tileOf(int x, int y) const {
+        return static_cast<std::uint32_t>(x / WORLD_TILE) * tileCols + static_cast<std::uint32_t>(y / WORLD_TILE);
+    }
+
+    // Tile words holding (x, y), through the cache. (x, y) must be inside the world.
+    std::uint64_t* tileFor(int x, int y) const {
+        lookups++;
+        const std::uint32_t tile = tileOf(x, y);
+        if (tile == lastTile) return lastTileWords;
+        touch(tile, false);
+        lastTile = tile;
+        lastTileWords = wordsOf(tile);
+        return lastTileWords;
+    }
+
+    static std::size_t wordIn(int x, int y) {
+        return static_cast<std::size_t>(x % WORLD_TILE) * WORLD_TILE_WORDS_PER_ROW + (y % WORLD_TILE) / 64;
+    }
+
+public:
+    ChunkedWorld()
+        : base(nullptr), length(0), rows(0), cols(0), tileCols(0), tileCount(0), newest(NONE), oldest(NONE),
+          residentCount(0), capacity(1024), lastTile(NONE), lastTileWords(nullptr), tileLoads(0), tileEvictions(0),
+          lookups(0) {
+        std::memset(&header, 0, sizeof(header));
+    }
+    ~ChunkedWorld() { close(); }
+    ChunkedWorld(const ChunkedWorld&) = delete;
+    ChunkedWorld& operator=(const ChunkedWorld&) = delete;
+
+    // Map a world written by createWorldFile. Malformed files are refused with a reason.
+    bool open(const std::string& filename, std::string* error = nullptr) {
+        close();
+        const int fd = ::open(filename.c_str(), O_RDWR);
+        if (fd < 0) {
+            if (error) *error = "Could not open world file " + filename + "!";
+            return false;
+        }
+        struct stat info;
+        WorldHeader h;
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < WORLD_HEADER_BYTES ||
+            ::pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+            ::close(fd);
+            if (error) *error = "World file " + filename + " is too short.";
+            return false;
+        }
+        const bool valid = std::memcmp(h.magic, WORLD_MAGIC, sizeof(WORLD_MAGIC)) == 0 && h.version == WORLD_VERSION &&
+                           h.tileSize == WORLD_TILE && h.rows >= 3 && h.cols >= 3 && h.rows <= MAX_WORLD_SIZE &&
+                           h.cols <= MAX_WORLD_SIZE && h.tileRows == (h.rows + WORLD_TILE - 1) / WORLD_TILE &&
+                           h.tileCols == (h.cols + WORLD_TILE - 1) / WORLD_TILE && h.tileOffset == WORLD_HEADER_BYTES &&
+                           h.fileBytes == WORLD_HEADER_BYTES + h.tileRows * h.tileCols * WORLD_TILE_BYTES &&
+                           h.fileBytes == static_cast<std::uint64_t>(info.st_size);
+        if (!valid) {
+            ::close(fd);
+            if (error) *error = filename + " is not a maze world file (or was written by a newer version).";
+            return false;
+        }
+        void* mapped = ::mmap(nullptr, static_cast<std::size_t>(h.fileBytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping stays valid without the descriptor
+        if (mapped == MAP_FAILED) {
+            if (error) *error = "Could not map world file " + filename + ".";
+            return false;
+        }
+        ::madvise(mapped, static_cast<std::size_t>(h.fileBytes), MADV_RANDOM); // 2D access: no read-ahead along the file
+
+        base = static_cast<unsigned char*>(mapped);
+        length = static_cast<std::size_t>(h.fileBytes);
+        header = h;
+        rows = static_cast<int>(h.rows);
+        cols = static_cast<int>(h.cols);
+        tileCols = static_cast<std::uint32_t>(h.tileCols);
+        tileCount = static_cast<std::size_t>(h.tileRows * h.tileCols);
+        newer.assign(tileCount, NONE);
+        older.assign(tileCount, NONE);
+        resident.assign(tileCount, 0);
+        newest = oldest = lastTile = NONE;
+        residentCount = 0;
+        tileLoads = tileEvictions = lookups = 0;
+        return true;
+    }
+
+    // Write taken items back to the file and unmap it
+    void close() {
+        if (!base) return;
+        ::msync(base, length, MS_SYNC);
+        ::munmap(base, length);
+        base = nullptr;
+        length = 0;
+        rows = cols = 0;
+        lastTile = NONE;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    std::uint64_t getSeed() const { return header.seed; }
+    std::uint64_t getItemCount() const { return header.itemCount; } // At creation
+    std::size_t getFileBytes() const { return length; }
+    std::size_t getTileCount() const { return tileCount; }
+
+    // Most tiles kept resident (at least 16; the window around the player must fit)
+    void setCacheTiles(std::size_t tiles) {
+        capacity = tiles < 16 ? 16 : tiles;
+        while (residentCount > capacity) evictOldest();
+    }
+    std::size_t getCacheTiles() const { return capacity; }
+
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < rows && y < cols; }
+
+    // Same contract as MazeGrid: outside the world is wall
+    bool isWall(int x, int y) const {
+        if (!inBounds(x, y)) return true;
+        return (tileFor(x, y)[wordIn(x, y)] >> (y & 63)) & 1;
+    }
+
+    bool hasItem(int x, int y) const {
+        if (!inBounds(x, y)) return false;
+        return (tileFor(x, y)[WORLD_PLANE_WORDS + wordIn(x, y)] >> (y & 63)) & 1;
+    }
+
+    // '#', '*' or ' ' (MazeGrid glyphs)
+    char getCell(int x, int y) const {
+        if (!inBounds(x, y)) return '#';
+        const std::uint64_t* words = tileFor(x, y);
+        const std::size_t w = wordIn(x, y);
+        if ((words[w] >> (y & 63)) & 1) return '#';
+        return (words[WORLD_PLANE_WORDS + w] >> (y & 63)) & 1 ? '*' : ' ';
+    }
+
+    // Remove the item on (x, y); false if there was none. Goes straight to the file.
+    bool takeItem(int x, int y) {
+        if (!inBounds(x, y)) return false;
+        std::uint64_t& word = tileFor(x, y)[WORLD_PLANE_WORDS + wordIn(x, y)];
+        const std::uint64_t bit = std::uint64_t(1) << (y & 63);
+        if (!(word & bit)) return false;
+        word &= ~bit;
+        return true;
+    }
+
+    // Admit every tile within 'radius' tiles of the one holding (x, y), asking the OS to
+    // start reading the ones that weren't resident
+    void prefetch(int x, int y, int radius) const {
+        if (!inBounds(x, y)) return;
+        const int tx = x / WORLD_TILE, ty = y / WORLD_TILE;
+        const int tileRows = static_cast<int>(header.tileRows);
+        for (int i = tx - radius; i <= tx + radius; i++) {
+            for (int j = ty - radius; j <= ty + radius; j++) {
+                if (i < 0 || j < 0 || i >= tileRows || j >= static_cast<int>(tileCols)) continue;
+                touch(static_cast<std::uint32_t>(i) * tileCols + static_cast<std::uint32_t>(j), true);
+            }
+        }
+    }
+
+    std::size_t residentTiles() const { return residentCount; }
+    std::size_t residentBytes() const { return residentCount * WORLD_TILE_BYTES; } // Upper bound on mapped pages
+    std::uint64_t getTileLoads() const { return tileLoads; }
+    std::uint64_t getTileEvictions() const { return tileEvictions; }
+    std::uint64_t getLookups() const { return lookups; }
+};
+
+#endif // CHUNKED_WORLD_H
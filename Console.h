@@ -0,0 +1,85 @@
+// Console.h
+#ifndef CONSOLE_H // Start of include guard
+#define CONSOLE_H
+
+// The console calls Maze.cpp makes: Sleep(), color attributes and _getch(). On Windows these
+// are the real windows.h / conio.h; elsewhere the same names are provided on top of POSIX
+// (ANSI colors, termios raw keyboard input), so the game builds and plays on Linux unchanged.
+
+#if defined(_WIN32)
+
+#include <windows.h> // For Sleep() and console handles
+#include <conio.h>   // For _getch()
+
+#else
+
+#include <chrono>
+#include <cstdio>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+typedef void* HANDLE;
+typedef unsigned long DWORD;
+typedef unsigned short WORD;
+typedef int BOOL;
+
+struct CONSOLE_SCREEN_BUFFER_INFO {
+    WORD wAttributes;
+};
+
+#define STD_OUTPUT_HANDLE ((DWORD)-11)
+#define FOREGROUND_BLUE 0x0001
+#define FOREGROUND_GREEN 0x0002
+#define FOREGROUND_RED 0x0004
+#define FOREGROUND_INTENSITY 0x0008
+#define BACKGROUND_BLUE 0x0010
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+
+inline void Sleep(DWORD milliseconds) { std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds)); }
+
+inline HANDLE GetStdHandle(DWORD) { return nullptr; }
+
+// There is no way to ask a terminal for its current colors: report failure so callers keep
+// their default of 7, which SetConsoleTextAttribute below treats as "terminal default"
+inline BOOL GetConsoleScreenBufferInfo(HANDLE, CONSOLE_SCREEN_BUFFER_INFO*) { return 0; }
+inline BOOL GetConsoleMode(HANDLE, DWORD*) { return 0; } // Terminals speak ANSI already
+inline BOOL SetConsoleMode(HANDLE, DWORD) { return 0; }
+
+// Windows attribute -> SGR, same mapping as FrameRenderer::applyColor. Goes through stdout,
+// which std::cout stays in sync with.
+inline BOOL SetConsoleTextAttribute(HANDLE, WORD attributes) {
+    if (attributes == 7) { // Light grey on black: the Windows console default
+        std::fputs("\x1b[0m", stdout);
+        return 1;
+    }
+    static const int ANSI_ORDER[8] = { 0, 4, 2, 6, 1, 5, 3, 7 }; // Windows is B=1, G=2, R=4
+    const int fg = attributes & 0x0F;
+    const int bg = (attributes >> 4) & 0x0F;
+    if (bg != 0) std::printf("\x1b[0;%d;%dm", (fg & 8 ? 90 : 30) + ANSI_ORDER[fg & 7], (bg & 8 ? 100 : 40) + ANSI_ORDER[bg & 7]);
+    else std::printf("\x1b[0;%dm", (fg & 8 ? 90 : 30) + ANSI_ORDER[fg & 7]);
+    return 1;
+}
+
+// One key, unbuffered and unechoed. End of input reads as 'q', so a game fed from a pipe
+// quits instead of spinning on EOF.
+inline int _getch() {
+    std::fflush(stdout); // Show any prompt before waiting
+    termios saved;
+    const bool terminal = tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (terminal) {
+        termios raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    unsigned char key = 0;
+    const ssize_t got = read(STDIN_FILENO, &key, 1);
+    if (terminal) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    return got == 1 ? key : 'q';
+}
+
+#endif
+
+#endif // CONSOLE_H
@@ -0,0 +1,383 @@
+// EnemyStore.h
+#ifndef ENEMY_STORE_H // Start of include guard
+#define ENEMY_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "MazeGrid.h"      // Wall bitmap the move kernel validates against
+#include "OccupancyGrid.h" // Index updated for every committed move
+#include "MazeRandom.h"    // Counter-based per-enemy random numbers
+#include "TaskPool.h"      // Work-stealing pool for the parallel phases
+#include "FlowField.h"     // Shared distance field for chasing enemies
+#include "FreeCellIndex.h" // Squares free for placement, updated as enemies move
+
+const char ENEMY_SYMBOL = 'X';
+
+// Enemy state flags (one byte per enemy)
+const std::uint8_t ENEMY_ACTIVE = 1 << 0; // Takes part in moveEnemies()
+
+// What happens when two enemies want the same cell in one tick
+enum EnemyConflictPolicy {
+    ENEMIES_STACK,    // Classic rules: enemies may share cells, every valid move goes through
+    ENEMIES_EXCLUSIVE // One enemy per cell: targets must be empty, lowest id wins a contested cell
+};
+
+// Struct-of-arrays enemy storage.
+// Instead of one heap object (and vtable pointer) per enemy, all enemies live in a single
+// arena block laid out as [ x[] | y[] | state[] ], each section 32-byte aligned so the move
+// kernel can load 8 positions at a time. Ids are indices into these arrays and never change
+// while the enemy exists. The arena grows by doubling, so adding enemies is amortised O(1)
+// and there is exactly one allocation for the whole population.
+class EnemyStore {
+private:
+    static constexpr std::size_t ALIGN = 32;
+
+    unsigned char* arena;
+    std::size_t count, capacity;
+    std::int32_t* xs;
+    std::int32_t* ys;
+    std::uint8_t* states;
+
+    static std::size_t alignUp(std::size_t n) { return (n + ALIGN - 1) & ~(ALIGN - 1); }
+
+    void reserveArena(std::size_t newCapacity) {
+        const std::size_t xBytes = alignUp(newCapacity * sizeof(std::int32_t));
+        const std::size_t stateBytes = alignUp(newCapacity);
+        unsigned char* block = static_cast<unsigned char*>(
+            ::operator new(2 * xBytes + stateBytes, std::align_val_t(ALIGN)));
+        std::int32_t* newXs = reinterpret_cast<std::int32_t*>(block);
+        std::int32_t* newYs = reinterpret_cast<std::int32_t*>(block + xBytes);
+        std::uint8_t* newStates = block + 2 * xBytes;
+        if (count) {
+            std::memcpy(newXs, xs, count * sizeof(std::int32_t));
+            std::memcpy(newYs, ys, count * sizeof(std::int32_t));
+            std::memcpy(newStates, states, count);
+        }
+        release();
+        arena = block;
+        xs = newXs;
+        ys = newYs;
+        states = newStates;
+        capacity = newCapacity;
+    }
+
+    void release() {
+        if (arena) ::operator delete(arena, std::align_val_t(ALIGN));
+        arena = nullptr;
+    }
+
+public:
+    EnemyStore()
+        : arena(nullptr), count(0), capacity(0), xs(nullptr), ys(nullptr), states(nullptr),
+          claimCells(0), claimCols(0) {}
+    ~EnemyStore() { release(); }
+    EnemyStore(const EnemyStore&) = delete;
+    EnemyStore& operator=(const EnemyStore&) = delete;
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+
+    void reserve(std::size_t n) {
+        if (n > capacity) reserveArena(n);
+    }
+
+    // Append an enemy; returns its id
+    std::uint32_t add(int x, int y, std::uint8_t state = ENEMY_ACTIVE) {
+        if (count == capacity) reserveArena(capacity ? capacity * 2 : 16);
+        xs[count] = x;
+        ys[count] = y;
+        states[count] = state;
+        return static_cast<std::uint32_t>(count++);
+    }
+
+    int getX(std::size_t id) const { return xs[id]; }
+    int getY(std::size_t id) const { return ys[id]; }
+    std::uint8_t getState(std::size_t id) const { return states[id]; }
+    void setPosition(std::size_t id, int x, int y) { xs[id] = x; ys[id] = y; }
+
+    const std::int32_t* xData() const { return xs; }
+    const std::int32_t* yData() const { return ys; }
+
+    std::size_t memoryBytes() const {
+        return capacity ? 2 * alignUp(capacity * sizeof(std::int32_t)) + alignUp(capacity) : 0;
+    }
+
+    // Name of the move kernel compiled in, for benchmark output
+    static const char* kernelName() {
+#if defined(__AVX2__)
+        return "avx2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Random-walk every active enemy by one of the 8 neighbouring cells (diagonals allowed).
+    // Each enemy gets up to 'maxAttempts' (at most 10) random directions and takes the first
+    // one whose target is inside the board, not a wall and not the exit. All randomness comes
+    // from counterRandom32(seed, tick, id): one 32-bit value per enemy per tick, 3 bits per
+    // attempt, so the outcome never depends on thread count or scheduling.
+    // With a 'chase' field, enemies inside it first try to step downhill towards the player
+    // (4-neighbour moves, ties broken by the same random value) and only wander when that
+    // step is impossible or they are out of the field's reach.
+    // Runs as data-parallel phases over contiguous arrays, spread over 'pool' if given:
+    //   1. PROPOSE + VALIDATE (parallel)  - pick each enemy's target against the wall bitmap
+    //   2. CLAIM (parallel, EXCLUSIVE)    - lowest id wins each contested cell (atomic min)
+    //   3. COMMIT (parallel)              - winners write their new position
+    //   4. INDEX (serial, id order)       - occupancy updates, deterministic list order; a
+    //                                       'freeCells' index gets the squares enemies vacate or enter
+    void moveAll(const MazeGrid& maze, int exitX, int exitY, OccupancyGrid& occupancy,
+                 std::uint64_t seed, std::uint32_t tick, TaskPool* pool = nullptr,
+                 EnemyConflictPolicy policy = ENEMIES_STACK, const FlowField* chase = nullptr,
+                 FreeCellIndex* freeCells = nullptr, int maxAttempts = 10) {
+        if (count == 0) return;
+        if (maxAttempts > 10) maxAttempts = 10; // 10 attempts x 3 bits fit in one 32-bit draw
+        targetX.resize(count + 8);
+        targetY.resize(count + 8);
+        const bool exclusive = policy == ENEMIES_EXCLUSIVE;
+        if (exclusive) prepareClaims(maze);
+
+        MoveContext ctx;
+        ctx.walls = maze.wallRow(0);
+        ctx.stride = maze.getWordsPerRow();
+        ctx.rows = maze.getRows();
+        ctx.cols = maze.getCols();
+        ctx.exitX = exitX;
+        ctx.exitY = exitY;
+        ctx.seedKey = seedKey32(seed);
+        ctx.tick = tick;
+        ctx.maxAttempts = maxAttempts;
+        ctx.occupancy = exclusive ? &occupancy : nullptr;
+        ctx.field = chase && chase->isValid() ? chase : nullptr;
+
+        auto run = [&](const TaskPool::RangeFn& fn) {
+            if (pool && count >= PARALLEL_THRESHOLD) pool->parallelFor(count, CHUNK_SIZE, fn);
+            else fn(0, count);
+        };
+
+        run([&](std::size_t begin, std::size_t end) { proposeRange(ctx, begin, end); });
+        if (exclusive) {
+            run([&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++) {
+                    if (targetX[i] < 0) continue;
+                    std::atomic<std::uint32_t>& claim = claims[cellIndex(targetX[i], targetY[i])];
+                    std::uint32_t current = claim.load(std::memory_order_relaxed);
+                    while (i < current && !claim.compare_exchange_weak(current, static_cast<std::uint32_t>(i),
+                                                                      std::memory_order_relaxed)) {}
+                }
+            });
+        }
+        run([&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                if (targetX[i] < 0) continue;
+                if (exclusive && claims[cellIndex(targetX[i], targetY[i])].load(std::memory_order_relaxed) != i) {
+                    targetX[i] = -1; // Lost the cell to a lower id - stays put this tick
+                    continue;
+                }
+                xs[i] = targetX[i];
+                ys[i] = targetY[i];
+            }
+        });
+        for (std::size_t i = 0; i < count; i++) {
+            if (targetX[i] < 0) continue;
+            if (freeCells) {
+                const std::uint64_t from = occupancy.cellKeyOf(static_cast<int>(i));
+                occupancy.relocate(static_cast<int>(i), targetX[i], targetY[i]);
+                // Last one out of an open square frees it; arriving takes the target square
+                if (!occupancy.occupiedCell(from) && maze.atIndex(static_cast<std::size_t>(from)) == ' ')
+                    freeCells->insertCell(static_cast<std::uint32_t>(from));
+                freeCells->eraseCell(static_cast<std::uint32_t>(occupancy.cellKeyOf(static_cast<int>(i))));
+            } else {
+                occupancy.relocate(static_cast<int>(i), targetX[i], targetY[i]);
+            }
+            if (exclusive) claims[cellIndex(targetX[i], targetY[i])].store(NO_CLAIM, std::memory_order_relaxed);
+        }
+    }
+
+    // moveAll() for the classic case on a Rows x Cols board known at compile time: ENEMIES_STACK,
+    // no chase field, one thread, exit on (Rows - 2, Cols - 2). Under those rules no enemy's
+    // target depends on another enemy, so the four phases collapse into one pass per enemy
+    // with the bounds, wall-plane stride and exit folded into constants, and no target
+    // arrays. Moves, occupancy order and free squares come out exactly as moveAll()'s.
+    template <int Rows, int Cols>
+    void wanderFixed(const MazeGrid& maze, OccupancyGrid& occupancy, std::uint64_t seed, std::uint32_t tick,
+                     FreeCellIndex* freeCells = nullptr) {
+        constexpr std::size_t STRIDE = (static_cast<std::size_t>(Cols) + 63) / 64;
+        constexpr int EXIT_X = Rows - 2, EXIT_Y = Cols - 2;
+        const std::uint64_t* walls = maze.wallRow(0);
+        const std::uint32_t key = seedKey32(seed);
+        for (std::size_t i = 0; i < count; i++) {
+            if (!(states[i] & ENEMY_ACTIVE)) continue;
+            const std::uint32_t h = counterRandom32(key, tick, static_cast<std::uint32_t>(i));
+            for (int a = 0; a < 10; a++) {
+                const int code = (h >> (3 * a)) & 7;
+                const int nx = xs[i] + dirX(code);
+                const int ny = ys[i] + dirY(code);
+                if (static_cast<unsigned>(nx) >= static_cast<unsigned>(Rows) ||
+                    static_cast<unsigned>(ny) >= static_cast<unsigned>(Cols) ||
+                    ((walls[nx * STRIDE + (ny >> 6)] >> (ny & 63)) & 1) || (nx == EXIT_X && ny == EXIT_Y))
+                    continue;
+                xs[i] = nx;
+                ys[i] = ny;
+                if (freeCells) {
+                    const std::uint64_t from = occupancy.cellKeyOf(static_cast<int>(i));
+                    occupancy.relocate(static_cast<int>(i), nx, ny);
+                    if (!occupancy.occupiedCell(from) && maze.atIndex(static_cast<std::size_t>(from)) == ' ')
+                        freeCells->insertCell(static_cast<std::uint32_t>(from));
+                    freeCells->eraseCell(static_cast<std::uint32_t>(nx * Cols + ny));
+                } else {
+                    occupancy.relocate(static_cast<int>(i), nx, ny);
+                }
+                break;
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t PARALLEL_THRESHOLD = 8192; // Below this, threads cost more than they save
+    static constexpr std::size_t CHUNK_SIZE = 4096;         // Enemies per work item (multiple of 8)
+    static constexpr std::uint32_t NO_CLAIM = ~std::uint32_t(0);
+
+    struct MoveContext {
+        const std::uint64_t* walls;
+        std::size_t stride;
+        int rows, cols;
+        int exitX, exitY;
+        std::uint32_t seedKey, tick;
+        int maxAttempts;
+        const OccupancyGrid* occupancy; // Set in EXCLUSIVE mode: targets must be empty at tick start
+        const FlowField* field;         // Set when chasing
+    };
+
+    std::vector<std::int32_t> targetX, targetY;         // Chosen target per enemy (-1 = stays)
+    std::unique_ptr<std::atomic<std::uint32_t>[]> claims; // EXCLUSIVE mode: lowest claimant per cell
+    std::size_t claimCells;
+    int claimCols;
+
+    std::size_t cellIndex(int x, int y) const { return static_cast<std::size_t>(x) * claimCols + y; }
+
+    void prepareClaims(const MazeGrid& maze) {
+        std::size_t cells = maze.cellCount();
+        if (claims && claimCells == cells && claimCols == maze.getCols()) return;
+        claims.reset(new std::atomic<std::uint32_t>[cells]);
+        for (std::size_t c = 0; c < cells; c++) claims[c].store(NO_CLAIM, std::memory_order_relaxed);
+        claimCells = cells;
+        claimCols = maze.getCols();
+    }
+
+    // Direction code -> (dx, dy): the 8 neighbours, never (0, 0)
+    static int dirX(int code) { static const int DX[8] = { -1, -1, -1, 0, 0, 1, 1, 1 }; return DX[code]; }
+    static int dirY(int code) { static const int DY[8] = { -1, 0, 1, -1, 1, -1, 0, 1 }; return DY[code]; }
+
+    // Phase 1 for enemies [begin, end): writes targetX/targetY
+    void proposeRange(const MoveContext& ctx, std::size_t begin, std::size_t end) {
+        std::size_t i = begin;
+#if defined(__AVX2__)
+        // 8 enemies per iteration: hash all 8 counters at once, then try attempts lane-parallel
+        // (deltas via permute, wall words via masked gather) until every lane has a target or
+        // the attempts run out. The occupancy test of EXCLUSIVE mode and the flow field lookups
+        // of chasing are scalar, so those take the scalar loop below.
+        if (!ctx.occupancy && !ctx.field) {
+            const __m256i DX = _mm256_setr_epi32(-1, -1, -1, 0, 0, 1, 1, 1);
+            const __m256i DY = _mm256_setr_epi32(-1, 0, 1, -1, 1, -1, 0, 1);
+            const __m256i vRows = _mm256_set1_epi32(ctx.rows);
+            const __m256i vCols = _mm256_set1_epi32(ctx.cols);
+            // The gather reads the wall plane as 32-bit words (little-endian halves of the 64-bit ones)
+            const __m256i vStride = _mm256_set1_epi32(static_cast<int>(ctx.stride * 2));
+            const __m256i vExitX = _mm256_set1_epi32(ctx.exitX);
+            const __m256i vExitY = _mm256_set1_epi32(ctx.exitY);
+            const __m256i minusOne = _mm256_set1_epi32(-1);
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i one = _mm256_set1_epi32(1);
+            const __m256i seven = _mm256_set1_epi32(7);
+            const __m256i thirtyOne = _mm256_set1_epi32(31);
+            const __m256i laneIds = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256i activeBit = _mm256_set1_epi32(ENEMY_ACTIVE);
+            for (; i + 8 <= end; i += 8) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i));
+                __m256i st = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(states + i)));
+                __m256i ids = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), laneIds);
+                __m256i h = mix32x8(_mm256_xor_si256(
+                    _mm256_set1_epi32(static_cast<int>(ctx.seedKey)),
+                    mix32x8(_mm256_xor_si256(
+                        _mm256_set1_epi32(static_cast<int>(ctx.tick * 0x9E3779B1u)),
+                        _mm256_add_epi32(_mm256_mullo_epi32(ids, _mm256_set1_epi32(static_cast<int>(0x85EBCA77u))),
+                                         _mm256_set1_epi32(0x165667B1))))));
+                __m256i open = _mm256_cmpeq_epi32(_mm256_and_si256(st, activeBit), activeBit); // Lanes still searching
+                __m256i tx = minusOne, ty = minusOne;
+                for (int a = 0; a < ctx.maxAttempts && !_mm256_testz_si256(open, open); a++) {
+                    __m256i code = _mm256_and_si256(_mm256_srli_epi32(h, 3 * a), seven);
+                    __m256i nx = _mm256_add_epi32(x, _mm256_permutevar8x32_epi32(DX, code));
+                    __m256i ny = _mm256_add_epi32(y, _mm256_permutevar8x32_epi32(DY, code));
+                    __m256i inX = _mm256_and_si256(_mm256_cmpgt_epi32(nx, minusOne), _mm256_cmpgt_epi32(vRows, nx));
+                    __m256i inY = _mm256_and_si256(_mm256_cmpgt_epi32(ny, minusOne), _mm256_cmpgt_epi32(vCols, ny));
+                    __m256i look = _mm256_and_si256(open, _mm256_and_si256(inX, inY));
+                    __m256i wordIdx = _mm256_and_si256(_mm256_add_epi32(_mm256_mullo_epi32(nx, vStride), _mm256_srli_epi32(ny, 5)), look);
+                    __m256i words = _mm256_mask_i32gather_epi32(zero, reinterpret_cast<const int*>(ctx.walls), wordIdx, look, 4);
+                    __m256i wallBit = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(ny, thirtyOne)), one);
+                    __m256i isExit = _mm256_and_si256(_mm256_cmpeq_epi32(nx, vExitX), _mm256_cmpeq_epi32(ny, vExitY));
+                    __m256i ok = _mm256_andnot_si256(isExit, _mm256_and_si256(look, _mm256_cmpeq_epi32(wallBit, zero)));
+                    tx = _mm256_blendv_epi8(tx, nx, ok);
+                    ty = _mm256_blendv_epi8(ty, ny, ok);
+                    open = _mm256_andnot_si256(ok, open);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&targetX[i]), tx);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&targetY[i]), ty);
+            }
+        }
+#endif
+        // Scalar loop: the tail of an AVX2 range, EXCLUSIVE mode, chasing, or everything without AVX2
+        for (; i < end; i++) {
+            targetX[i] = targetY[i] = -1;
+            if (!(states[i] & ENEMY_ACTIVE)) continue;
+            std::uint32_t h = counterRandom32(ctx.seedKey, ctx.tick, static_cast<std::uint32_t>(i));
+            int cx, cy;
+            if (ctx.field && ctx.field->nextStep(xs[i], ys[i], h >> 30, ctx.exitX, ctx.exitY, cx, cy) &&
+                !(ctx.occupancy && ctx.occupancy->occupied(cx, cy))) {
+                targetX[i] = cx;
+                targetY[i] = cy;
+                continue;
+            }
+            for (int a = 0; a < ctx.maxAttempts; a++) {
+                int code = (h >> (3 * a)) & 7;
+                int nx = xs[i] + dirX(code);
+                int ny = ys[i] + dirY(code);
+                bool ok = static_cast<unsigned>(nx) < static_cast<unsigned>(ctx.rows) &&
+                          static_cast<unsigned>(ny) < static_cast<unsigned>(ctx.cols) &&
+                          !((ctx.walls[nx * ctx.stride + (ny >> 6)] >> (ny & 63)) & 1) &&
+                          !(nx == ctx.exitX && ny == ctx.exitY) &&
+                          !(ctx.occupancy && ctx.occupancy->occupied(nx, ny));
+                if (ok) {
+                    targetX[i] = nx;
+                    targetY[i] = ny;
+                    break;
+                }
+            }
+        }
+    }
+
+#if defined(__AVX2__)
+    // mix32() on 8 lanes
+    static __m256i mix32x8(__m256i h) {
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0x85EBCA6Bu)));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+        h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0xC2B2AE35u)));
+        h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+        return h;
+    }
+#endif
+};
+
+#endif // ENEMY_STORE_H
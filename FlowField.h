@@ -0,0 +1,348 @@
+// FlowField.h
+#ifndef FLOW_FIELD_H // Start of include guard
+#define FLOW_FIELD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "MazeGrid.h" // Passable cells come from the wall bitmap
+
+// Shared distance field for chasing enemies.
+// One BFS from the player over the passable cells (4-neighbour moves) gives every cell its
+// distance to the player; any number of enemies then chase by stepping "downhill" to a
+// neighbour one step closer - O(1) per enemy instead of a path search per enemy.
+//
+// When the player moves to an adjacent cell the field is REPAIRED, not rebuilt:
+//   1. Decrease: the new cell becomes a second source (distance 0) and a BFS wave lowers
+//      every cell that is now closer. The field is now "distance to old OR new cell".
+//   2. Raise: the old cell stops being a source. Cells whose every shortest path led
+//      through it lose their support; they are found level by level (a cell is affected
+//      when none of its unaffected neighbours is one step closer).
+//   3. Repair: only the affected cells are recomputed, seeded from their unaffected
+//      neighbours, with a two-queue unit-weight Dijkstra.
+// Only cells whose distance actually changes (plus their neighbours) are touched. That can
+// be most of the field: in a perfect maze (no loops) a one-cell move changes every
+// distance, and a repair costs more per cell than a plain BFS. So a repair gives up and
+// rebuilds once it has touched a quarter as many cells as the last rebuild reached. After
+// a give-up the next moves rebuild straight away (1, 2, 4 ... up to MAX_BACKOFF moves while
+// repairs keep failing), so boards where repairs never pay cost about a rebuild per move.
+//
+// An optional radius caps the field: cells farther than 'radius' steps stay UNREACHED and
+// enemies there just wander. With a cap the cost per move is bounded by the area around the
+// player, independent of the maze size - that is what keeps 10k x 10k boards affordable.
+class FlowField {
+public:
+    static constexpr std::uint32_t UNREACHED = 0xFFFFFFFFu;
+
+private:
+    static constexpr std::uint8_t RAISED = 1;    // Lost support while removing the old source
+    static constexpr std::uint8_t CANDIDATE = 2; // Queued for the support check of the next level
+    static constexpr std::size_t MAX_BACKOFF = 64; // Most moves rebuilt outright after a failed repair
+
+    int rows, cols;
+    std::uint32_t radius;             // Max distance stored (UNREACHED = unlimited)
+    std::vector<std::uint32_t> dist;  // Per cell, row-major
+    std::vector<std::uint8_t> flags;  // Per cell scratch for the raise phase (all zero between updates)
+    int sourceX, sourceY;
+    bool valid;
+    std::size_t touched;              // Cells examined by the last update
+    std::size_t reached;              // Cells with a distance after the last rebuild
+    std::size_t budget;               // Repair work allowed before falling back to a rebuild
+    std::size_t fallbacks;            // Repairs abandoned for a rebuild
+    std::size_t backoff;              // Moves to rebuild outright after the next failed repair (0 = last repair held)
+    std::size_t skipRepairs;          // Moves left that rebuild without trying a repair
+
+    // Scratch lists reused between updates
+    std::vector<std::uint32_t> queue, level, nextLevel, raised;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> seeds, fifo, sorted; // (distance, cell)
+    std::vector<std::uint32_t> bucketStart;
+
+    // Counting sort of 'seeds' by distance: the values span at most the raised region's depth,
+    // so this is linear where std::sort would dominate large repairs
+    void sortSeeds() {
+        if (seeds.size() < 2) return;
+        std::uint32_t lo = UNREACHED, hi = 0;
+        for (const auto& e : seeds) {
+            lo = std::min(lo, e.first);
+            hi = std::max(hi, e.first);
+        }
+        bucketStart.assign(static_cast<std::size_t>(hi - lo) + 2, 0);
+        for (const auto& e : seeds) bucketStart[e.first - lo + 1]++;
+        for (std::size_t b = 1; b < bucketStart.size(); b++) bucketStart[b] += bucketStart[b - 1];
+        sorted.resize(seeds.size());
+        for (const auto& e : seeds) sorted[bucketStart[e.first - lo]++] = e;
+        seeds.swap(sorted);
+    }
+
+    // Up to 4 passable neighbours of 'cell'; returns how many were written
+    int neighbours(const MazeGrid& maze, std::uint32_t cell, std::uint32_t out[4]) const {
+        const int x = static_cast<int>(cell / cols), y = static_cast<int>(cell % cols);
+        int n = 0;
+        if (!maze.isWall(x - 1, y)) out[n++] = cell - cols;
+        if (!maze.isWall(x + 1, y)) out[n++] = cell + cols;
+        if (!maze.isWall(x, y - 1)) out[n++] = cell - 1;
+        if (!maze.isWall(x, y + 1)) out[n++] = cell + 1;
+        return n;
+    }
+
+    std::uint32_t cellOf(int x, int y) const { return static_cast<std::uint32_t>(x) * cols + y; }
+
+    // Reset every cell that has a distance back to UNREACHED without sweeping the whole board.
+    // Cells with a distance always form one connected region around the source (each got its
+    // value from a neighbour), so a flood over them from the source finds them all - even
+    // if the walls have changed since. Costs O(reached) instead of O(rows * cols).
+    void clearReached() {
+        queue.clear();
+        const std::uint32_t start = cellOf(sourceX, sourceY);
+        if (dist[start] != UNREACHED) {
+            dist[start] = UNREACHED;
+            queue.push_back(start);
+        }
+        for (std::size_t head = 0; head < queue.size(); head++) {
+            const std::uint32_t u = queue[head];
+            const int x = static_cast<int>(u / cols), y = static_cast<int>(u % cols);
+            const std::uint32_t around[4] = { u - cols, u + cols, u - 1, u + 1 };
+            const bool inside[4] = { x > 0, x + 1 < rows, y > 0, y + 1 < cols };
+            for (int k = 0; k < 4; k++) {
+                if (inside[k] && dist[around[k]] != UNREACHED) {
+                    dist[around[k]] = UNREACHED;
+                    queue.push_back(around[k]);
+                }
+            }
+        }
+        touched += queue.size();
+    }
+
+    // BFS from everything already in 'queue', lowering distances (used by rebuild and step 1).
+    // Returns false if the wave grew past 'budget'.
+    bool decreaseWave(const MazeGrid& maze) {
+        std::uint32_t nb[4];
+        for (std::size_t head = 0; head < queue.size(); head++) {
+            if (queue.size() > budget) return false;
+            const std::uint32_t u = queue[head];
+            const std::uint32_t next = dist[u] + 1;
+            if (next > radius) continue;
+            const int n = neighbours(maze, u, nb);
+            for (int k = 0; k < n; k++) {
+                if (dist[nb[k]] > next) {
+                    if (dist[nb[k]] == UNREACHED) reached++;
+                    dist[nb[k]] = next;
+                    queue.push_back(nb[k]);
+                }
+            }
+        }
+        touched += queue.size();
+        return true;
+    }
+
+    // Steps 2 + 3: remove 'oldCell' as a source. Returns false (leaving the field and flags
+    // half-updated - the caller rebuilds) if the affected region grew past 'budget'.
+    bool removeSource(const MazeGrid& maze, std::uint32_t oldCell) {
+        std::uint32_t nb[4], nb2[4];
+        raised.clear();
+        level.clear();
+        flags[oldCell] |= RAISED;
+        raised.push_back(oldCell);
+        level.push_back(oldCell);
+
+        // Raise, level by level: all affected cells of distance k are known before any
+        // cell of distance k + 1 is judged, so a support check never trusts a cell that is
+        // about to be raised itself.
+        while (!level.empty()) {
+            nextLevel.clear();
+            for (std::uint32_t u : level) {
+                const int n = neighbours(maze, u, nb);
+                for (int k = 0; k < n; k++) {
+                    const std::uint32_t v = nb[k];
+                    if (flags[v] || dist[v] == UNREACHED || dist[v] != dist[u] + 1) continue;
+                    flags[v] |= CANDIDATE;
+                    nextLevel.push_back(v);
+                }
+            }
+            touched += nextLevel.size();
+            if (touched + raised.size() > budget) return false; // Caller cleans up and rebuilds
+            level.clear();
+            for (std::uint32_t v : nextLevel) {
+                flags[v] &= ~CANDIDATE;
+                bool supported = false;
+                const int n = neighbours(maze, v, nb2);
+                for (int k = 0; k < n && !supported; k++) {
+                    supported = !(flags[nb2[k]] & RAISED) && dist[nb2[k]] + 1 == dist[v];
+                }
+                if (!supported) {
+                    flags[v] |= RAISED;
+                    raised.push_back(v);
+                    level.push_back(v);
+                }
+            }
+        }
+
+        // Repair: seed every raised cell from its unaffected neighbours...
+        seeds.clear();
+        for (std::uint32_t r : raised) {
+            std::uint32_t best = UNREACHED;
+            const int n = neighbours(maze, r, nb);
+            for (int k = 0; k < n; k++) {
+                if (!(flags[nb[k]] & RAISED) && dist[nb[k]] != UNREACHED && dist[nb[k]] + 1 < best) best = dist[nb[k]] + 1;
+            }
+            if (best != UNREACHED && best <= radius) seeds.push_back(std::make_pair(best, r));
+        }
+        for (std::uint32_t r : raised) dist[r] = UNREACHED;
+        sortSeeds();
+
+        // ...then spread inside the raised region. Seeds are sorted and the FIFO only ever
+        // receives increasing distances, so always taking the smaller front processes cells
+        // in distance order (Dijkstra for unit weights, no heap needed).
+        fifo.clear();
+        std::size_t si = 0, fi = 0;
+        while (si < seeds.size() || fi < fifo.size()) {
+            std::pair<std::uint32_t, std::uint32_t> e;
+            if (fi < fifo.size() && (si == seeds.size() || fifo[fi].first <= seeds[si].first)) e = fifo[fi++];
+            else e = seeds[si++];
+            if (e.first > dist[e.second]) continue; // Stale: already reached more cheaply
+            dist[e.second] = e.first;
+            const std::uint32_t next = e.first + 1;
+            if (next > radius) continue;
+            const int n = neighbours(maze, e.second, nb);
+            for (int k = 0; k < n; k++) {
+                const std::uint32_t v = nb[k];
+                if ((flags[v] & RAISED) && dist[v] > next) {
+                    dist[v] = next;
+                    fifo.push_back(std::make_pair(next, v));
+                }
+            }
+        }
+        touched += raised.size();
+        for (std::uint32_t r : raised) {
+            flags[r] = 0;
+            if (dist[r] == UNREACHED) reached--; // Pushed out of the radius
+        }
+        return true;
+    }
+
+public:
+    FlowField() : rows(0), cols(0), radius(UNREACHED), sourceX(0), sourceY(0), valid(false), touched(0),
+                  reached(0), budget(0), fallbacks(0), backoff(0), skipRepairs(0) {}
+
+    // Cap the field at 'maxDistance' steps (0 = unlimited). Takes effect on the next rebuild.
+    void setRadius(std::uint32_t maxDistance) {
+        radius = maxDistance == 0 ? UNREACHED : maxDistance;
+        valid = false;
+        backoff = skipRepairs = 0; // Repairs may pay off at the new radius
+    }
+    std::uint32_t getRadius() const { return radius == UNREACHED ? 0 : radius; }
+
+    // Forget the field (e.g. walls changed); the next moveSource() rebuilds
+    void invalidate() { valid = false; }
+    bool isValid() const { return valid; }
+
+    // Full BFS from (x, y). On the same board only the previously reached cells are cleared,
+    // so with a radius a rebuild costs the area around the player, not the board.
+    void rebuild(const MazeGrid& maze, int x, int y) {
+        touched = 0;
+        if (valid && rows == maze.getRows() && cols == maze.getCols()) {
+            clearReached();
+        } else {
+            rows = maze.getRows();
+            cols = maze.getCols();
+            dist.assign(maze.cellCount(), UNREACHED);
+            flags.assign(maze.cellCount(), 0);
+        }
+        sourceX = x;
+        sourceY = y;
+        valid = true;
+        reached = 0;
+        budget = ~std::size_t(0);
+        queue.clear();
+        if (maze.isWall(x, y)) return;
+        dist[cellOf(x, y)] = 0;
+        reached = 1;
+        queue.push_back(cellOf(x, y));
+        decreaseWave(maze);
+    }
+
+    // The player moved to (x, y). Adjacent moves are repaired incrementally; anything else
+    // (first use, teleport, different board) falls back to a rebuild.
+    void moveSource(const MazeGrid& maze, int x, int y) {
+        const int manhattan = (x > sourceX ? x - sourceX : sourceX - x) + (y > sourceY ? y - sourceY : sourceY - y);
+        if (!valid || rows != maze.getRows() || cols != maze.getCols() || manhattan > 1 || maze.isWall(x, y)) {
+            rebuild(maze, x, y);
+            return;
+        }
+        touched = 0;
+        if (manhattan == 0) return;
+        if (skipRepairs) {
+            skipRepairs--;
+            rebuild(maze, x, y);
+            return;
+        }
+        const std::uint32_t oldCell = cellOf(sourceX, sourceY), newCell = cellOf(x, y);
+        // A rebuild touches about 2 x reached cells (clear + BFS) at a lower cost per cell
+        // than a repair, so a repair that gets this far is unlikely to finish cheaper
+        budget = reached / 4 + 64;
+        dist[newCell] = 0;
+        queue.clear();
+        queue.push_back(newCell);
+        if (!decreaseWave(maze) || !removeSource(maze, oldCell)) {
+            // Give up: drop the raise-phase marks (distances are still one connected region
+            // around the old source, which rebuild() clears) and start over
+            for (std::uint32_t r : raised) flags[r] = 0;
+            for (std::uint32_t c : nextLevel) flags[c] = 0;
+            raised.clear();
+            nextLevel.clear();
+            const std::size_t wasted = touched;
+            fallbacks++;
+            backoff = backoff ? std::min(backoff * 2, MAX_BACKOFF) : 1;
+            skipRepairs = backoff;
+            rebuild(maze, x, y);
+            touched += wasted;
+            return;
+        }
+        backoff = 0;
+        sourceX = x;
+        sourceY = y;
+    }
+
+    std::uint32_t distance(int x, int y) const {
+        if (!valid || static_cast<unsigned>(x) >= static_cast<unsigned>(rows) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(cols)) return UNREACHED;
+        return dist[cellOf(x, y)];
+    }
+
+    // Downhill neighbour of (x, y): a cell one step closer to the player. Ties are broken by
+    // 'tieBreak' (rotates which direction is tried first). Returns false at the player, in
+    // unreached cells, or if the only way down is (blockX, blockY) (the exit for enemies).
+    bool nextStep(int x, int y, std::uint32_t tieBreak, int blockX, int blockY, int& outX, int& outY) const {
+        const std::uint32_t d = distance(x, y);
+        if (d == UNREACHED || d == 0) return false;
+        static const int DX[4] = { -1, 0, 1, 0 };
+        static const int DY[4] = { 0, 1, 0, -1 };
+        for (int k = 0; k < 4; k++) {
+            const int dir = (k + static_cast<int>(tieBreak & 3)) & 3;
+            const int nx = x + DX[dir], ny = y + DY[dir];
+            if (nx == blockX && ny == blockY) continue;
+            if (distance(nx, ny) + 1 == d) {
+                outX = nx;
+                outY = ny;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int getSourceX() const { return sourceX; }
+    int getSourceY() const { return sourceY; }
+    std::size_t lastCellsTouched() const { return touched; }
+    std::size_t fallbackRebuilds() const { return fallbacks; }
+    std::size_t memoryBytes() const {
+        return dist.capacity() * sizeof(std::uint32_t) + flags.capacity() +
+               (queue.capacity() + level.capacity() + nextLevel.capacity() + raised.capacity()) * sizeof(std::uint32_t) +
+               bucketStart.capacity() * sizeof(std::uint32_t) +
+               (seeds.capacity() + fifo.capacity() + sorted.capacity()) * sizeof(std::pair<std::uint32_t, std::uint32_t>);
+    }
+};
+
+#endif // FLOW_FIELD_H
@@ -0,0 +1,268 @@
+// Instrumentation.h
+#ifndef INSTRUMENTATION_H // Start of include guard
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h> // __rdtsc
+#define MAZE_INSTRUMENT_TSC 1
+#endif
+
+// Hot-path instrumentation, compiled in only when MAZE_INSTRUMENT is defined to 1 (CMake
+// option MAZE_INSTRUMENT, on for the game, off for MazeBench). Otherwise every macro below
+// expands to nothing and the game carries no trace of it.
+//
+//   MAZE_TIMED_SCOPE(STAGE_MOVE_ENEMIES);   - time the rest of the enclosing block into a stage
+//   MAZE_COUNT(COUNTER_CELLS_REDRAWN, n);   - add n to a counter
+//   MAZE_COUNT_ALLOCATIONS()                - at file scope in ONE source file: count operator new
+//
+// Each stage keeps an HDR-style histogram: log-linear buckets with 32 sub-buckets per power
+// of two, so any latency from a few ns to minutes is kept to ~3% with a fixed 16 KB per stage
+// and recording is a couple of shifts and an increment, no allocation.
+// Timers read the CPU's time-stamp counter where there is one (x86 with GCC / Clang): about
+// half the cost of steady_clock::now(), which matters when movePlayer itself takes ~5 ns.
+// Ticks are converted to nanoseconds only when reporting, by comparing how far the counter
+// and steady_clock have both advanced since the first timer ran.
+// Stages are recorded without locks. Every stage is only written by one thread at a time,
+// and readers either share that thread's lock (the real-time loop's state lock) or run
+// after it has finished. Counters are atomic, since allocations happen on every thread.
+
+enum InstrumentStage {
+    STAGE_INPUT,        // Handling one key (includes whatever the key triggers)
+    STAGE_MOVE_PLAYER,  // MazeSim::movePlayer (turn-based: includes the enemies' turn)
+    STAGE_MOVE_ENEMIES, // MazeSim::moveEnemies
+    STAGE_CHECK_STATE,  // MazeSim::checkGameState
+    STAGE_DISPLAY,      // Drawing a frame and writing it to the console
+    STAGE_SOLVE_LEVEL,  // MazeSim::solveLevel (par route for a new level)
+    STAGE_NEXT_LEVEL,   // MazeSim::resetLevel (level change: built on the spot or taken from the pipeline)
+    STAGE_COUNT
+};
+
+enum InstrumentCounter {
+    COUNTER_ALLOCATIONS,     // operator new calls (see MAZE_COUNT_ALLOCATIONS)
+    COUNTER_ALLOCATED_BYTES,
+    COUNTER_FRAMES,          // Frames presented
+    COUNTER_CELLS_REDRAWN,   // Cells re-sent by the differential renderer
+    COUNTER_CONSOLE_BYTES,   // Escape-stream bytes written to the console
+    COUNTER_COUNT
+};
+
+inline const char* stageName(int stage) {
+    static const char* const NAMES[STAGE_COUNT] = { "input", "movePlayer", "moveEnemies", "checkGameState", "display", "solveLevel", "nextLevel" };
+    return stage >= 0 && stage < STAGE_COUNT ? NAMES[stage] : "?";
+}
+
+// The timers' clock: raw ticks, cheap to read
+inline std::uint64_t instrumentTicks() {
+#ifdef MAZE_INSTRUMENT_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Log-linear latency histogram over clock ticks
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;                     // 32 sub-buckets per power of two
+    static constexpr unsigned SUB_COUNT = 1u << SUB_BITS;
+    static constexpr unsigned BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT; // Covers every uint64 value
+
+private:
+    std::uint64_t counts[BUCKETS];
+    std::uint64_t total, sum, smallest, largest;
+
+    static unsigned highestBit(std::uint64_t v) { // v > 0
+#if defined(__GNUC__) || defined(__clang__)
+        return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#else
+        unsigned bit = 0;
+        while (v >>= 1) bit++;
+        return bit;
+#endif
+    }
+
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        for (unsigned i = 0; i < BUCKETS; i++) counts[i] = 0;
+        total = sum = largest = 0;
+        smallest = ~std::uint64_t(0);
+    }
+
+    // Values below 2 * SUB_COUNT get a bucket each; above that, each power of two
+    // [2^k, 2^(k+1)) is split into SUB_COUNT equal buckets picked by the bits below the top one
+    static unsigned bucketOf(std::uint64_t v) {
+        if (v < 2 * SUB_COUNT) return static_cast<unsigned>(v);
+        const unsigned shift = highestBit(v) - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + static_cast<unsigned>(v >> shift) - SUB_COUNT;
+    }
+
+    // Smallest value that lands in 'bucket'
+    static std::uint64_t bucketStart(unsigned bucket) {
+        if (bucket < 2 * SUB_COUNT) return bucket;
+        const unsigned shift = bucket / SUB_COUNT - 1;
+        return static_cast<std::uint64_t>(bucket % SUB_COUNT + SUB_COUNT) << shift;
+    }
+
+    void record(std::uint64_t ticks) {
+        counts[bucketOf(ticks)]++;
+        total++;
+        sum += ticks;
+        if (ticks < smallest) smallest = ticks;
+        if (ticks > largest) largest = ticks;
+    }
+
+    std::uint64_t count() const { return total; }
+    std::uint64_t min() const { return total ? smallest : 0; }
+    std::uint64_t max() const { return largest; }
+    double mean() const { return total ? static_cast<double>(sum) / static_cast<double>(total) : 0.0; }
+
+    // p in [0, 1]. Reported as the middle of the bucket holding that rank, clamped to the
+    // recorded min / max, so p0 and p100 are exact.
+    std::uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(p * static_cast<double>(total))); // Nearest-rank
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+        for (unsigned b = 0; b < BUCKETS; b++) {
+            if (counts[b] < rank) {
+                rank -= counts[b];
+                continue;
+            }
+            const std::uint64_t lo = bucketStart(b);
+            const std::uint64_t hi = b + 1 < BUCKETS ? bucketStart(b + 1) - 1 : ~std::uint64_t(0);
+            std::uint64_t v = lo + (hi - lo) / 2;
+            if (v < min()) v = min();
+            if (v > largest) v = largest;
+            return v;
+        }
+        return largest;
+    }
+};
+
+// Every stage histogram and counter in the program
+class Instrumentation {
+private:
+    LatencyHistogram stages[STAGE_COUNT];
+    std::atomic<std::uint64_t> counters[COUNTER_COUNT];
+    std::uint64_t startTicks;                      // Clock readings when the first timer ran,
+    std::chrono::steady_clock::time_point startTime; // for converting ticks to nanoseconds
+
+    Instrumentation() : startTicks(instrumentTicks()), startTime(std::chrono::steady_clock::now()) {
+        for (int i = 0; i < COUNTER_COUNT; i++) counters[i].store(0, std::memory_order_relaxed);
+    }
+
+public:
+    static Instrumentation& instance() {
+        static Instrumentation stats; // Built on first use, thread-safe since C++11
+        return stats;
+    }
+
+    LatencyHistogram& stage(InstrumentStage s) { return stages[s]; }
+    void add(InstrumentCounter c, std::uint64_t n) { counters[c].fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t counter(InstrumentCounter c) const { return counters[c].load(std::memory_order_relaxed); }
+
+    // Nanoseconds per histogram tick, measured over the whole run so far
+    double nsPerTick() const {
+#ifdef MAZE_INSTRUMENT_TSC
+        const std::uint64_t ticks = instrumentTicks() - startTicks;
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+        return ticks ? ns / static_cast<double>(ticks) : 1.0;
+#else
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::duration(1)).count();
+#endif
+    }
+
+    // "moveEnemies        1234     1.2    5.6    40.1" (microseconds), for the overlay and the summary
+    std::string stageLine(InstrumentStage s) const {
+        const LatencyHistogram& h = stages[s];
+        const double us = nsPerTick() / 1000.0;
+        char line[96];
+        std::snprintf(line, sizeof(line), "%-15s %9llu %9.1f %9.1f %9.1f %10.1f", stageName(s),
+                      static_cast<unsigned long long>(h.count()), h.percentile(0.5) * us,
+                      h.percentile(0.99) * us, h.mean() * us, h.max() * us);
+        return line;
+    }
+    static const char* stageHeader() { return "stage               calls   p50(us)   p99(us)  mean(us)    max(us)"; }
+
+    std::string counterLine() const {
+        const std::uint64_t frames = counter(COUNTER_FRAMES);
+        char line[128];
+        std::snprintf(line, sizeof(line), "allocs %llu (%llu KB) | frames %llu | cells %llu | console %llu KB",
+                      static_cast<unsigned long long>(counter(COUNTER_ALLOCATIONS)),
+                      static_cast<unsigned long long>(counter(COUNTER_ALLOCATED_BYTES) / 1024),
+                      static_cast<unsigned long long>(frames),
+                      static_cast<unsigned long long>(counter(COUNTER_CELLS_REDRAWN)),
+                      static_cast<unsigned long long>(counter(COUNTER_CONSOLE_BYTES) / 1024));
+        return line;
+    }
+
+    // Full report: every stage with samples, then the counters
+    void printSummary(std::FILE* out) const {
+        std::fprintf(out, "%s\n", stageHeader());
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            if (stages[s].count()) std::fprintf(out, "%s\n", stageLine(static_cast<InstrumentStage>(s)).c_str());
+        }
+        std::fprintf(out, "%s\n", counterLine().c_str());
+    }
+};
+
+// Records the time from construction to the end of the scope into one stage
+class ScopedStageTimer {
+private:
+    LatencyHistogram& histogram;
+    std::uint64_t start;
+
+public:
+    explicit ScopedStageTimer(InstrumentStage s)
+        : histogram(Instrumentation::instance().stage(s)), start(instrumentTicks()) {}
+    ~ScopedStageTimer() { histogram.record(instrumentTicks() - start); }
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
+
+#if defined(MAZE_INSTRUMENT) && MAZE_INSTRUMENT
+
+#include <cstdlib>
+#include <new>
+
+#define MAZE_INSTRUMENT_CONCAT2(a, b) a##b
+#define MAZE_INSTRUMENT_CONCAT(a, b) MAZE_INSTRUMENT_CONCAT2(a, b)
+#define MAZE_TIMED_SCOPE(stage) ScopedStageTimer MAZE_INSTRUMENT_CONCAT(mazeStageTimer_, __LINE__)(stage)
+#define MAZE_COUNT(counter, n) Instrumentation::instance().add(counter, static_cast<std::uint64_t>(n))
+
+// Replacement global operator new / delete that count every allocation. Over-aligned
+// allocations keep the library's own operators and are not counted. delete is kept out of
+// line: inlined, GCC sees free() on a pointer from operator new and warns about a mismatch.
+#if defined(__GNUC__) || defined(__clang__)
+#define MAZE_INSTRUMENT_NOINLINE __attribute__((noinline))
+#else
+#define MAZE_INSTRUMENT_NOINLINE
+#endif
+#define MAZE_COUNT_ALLOCATIONS()                                                  \
+    void* operator new(std::size_t size) {                                        \
+        MAZE_COUNT(COUNTER_ALLOCATIONS, 1);                                       \
+        MAZE_COUNT(COUNTER_ALLOCATED_BYTES, size);                                \
+        if (void* p = std::malloc(size ? size : 1)) return p;                     \
+        throw std::bad_alloc();                                                   \
+    }                                                                             \
+    MAZE_INSTRUMENT_NOINLINE void operator delete(void* p) noexcept { std::free(p); } \
+    MAZE_INSTRUMENT_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#else
+
+#define MAZE_TIMED_SCOPE(stage) ((void)0)
+#define MAZE_COUNT(counter, n) ((void)0)
+#define MAZE_COUNT_ALLOCATIONS()
+
+#endif
+
+#endif // INSTRUMENTATION_H
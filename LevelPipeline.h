@@ -0,0 +1,226 @@
+// LevelPipeline.h
+#ifndef LEVEL_PIPELINE_H // Start of include guard
+#define LEVEL_PIPELINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "MazeGrid.h"      // Board of a prepared level
+#include "FreeCellIndex.h" // Its free squares
+#include "MazeGenerator.h" // MazeAlgorithm; each builder thread keeps its own generator scratch
+#include "MazeSolver.h"    // ... and solver scratch
+
+// Everything a new level's content depends on. Two equal specs always build the same level.
+struct LevelSpec {
+    std::uint64_t seed;
+    int level;
+    int dimension;
+    MazeAlgorithm algorithm;
+    std::size_t enemies; // Enemies carried over from the previous level (the level may add one)
+
+    bool operator==(const LevelSpec& other) const {
+        return seed == other.seed && level == other.level && dimension == other.dimension &&
+               algorithm == other.algorithm && enemies == other.enemies;
+    }
+    bool operator!=(const LevelSpec& other) const { return !(*this == other); }
+};
+
+// Where a level puts things and what it is worth, next to the board itself
+struct LevelSetup {
+    LevelSpec spec;
+    std::vector<std::int32_t> enemyXs, enemyYs; // Every enemy's square, ids in order (may add one)
+    int collectibles;
+    int placementShortfall;
+    int parMoves;
+    int rejectedLayouts;
+    std::uint64_t rngState; // Placement RNG after setting the level up
+};
+
+// A level built ahead of time: swapped into the game whole when the player gets there
+struct PreparedLevel {
+    MazeGrid maze;
+    FreeCellIndex freeCells;
+    std::vector<std::int32_t> itemSquares;
+    LevelSetup setup;
+};
+
+// Builds the next levels on a worker thread while the current one is played.
+//
+// The game asks for a level with take(spec). If it is at the front of the queue the game gets
+// it at once and the level change is a handful of swaps; if the worker is still building it,
+// the game waits for that build (never starts a second one); anything else is a miss and the
+// game builds the level itself, then restart()s the pipeline from the level after it.
+// Levels follow each other predictably (the next spec comes from the last one through
+// 'follow'), so a miss only happens when something the prediction can't see changed
+// (enemies spawned by a tool, a load, a different algorithm).
+// Up to 'depth' levels are built or being built at any time. Used levels are handed back
+// with recycle(), so the worker rebuilds into buffers it already owns and the old level's
+// memory is never freed on the game thread.
+// The worker runs at the lowest priority the platform offers without privileges, so building
+// ahead only ever uses time the game leaves idle (on one core it would otherwise preempt the
+// game thread the moment take() wakes it for the next build).
+class LevelPipeline {
+public:
+    typedef std::function<void(const LevelSpec&, PreparedLevel&, LevelSolver&, MazeGeneratorScratch&)> BuildFn;
+    typedef std::function<LevelSpec(const LevelSpec&)> FollowFn;
+
+private:
+    BuildFn build;
+    FollowFn follow;
+    std::size_t depth;
+
+    mutable std::mutex lock;
+    std::condition_variable workAvailable, levelReady;
+    std::deque<std::unique_ptr<PreparedLevel>> ready; // Built, in level order
+    std::vector<std::unique_ptr<PreparedLevel>> spares; // Buffers to build into
+    LevelSpec pending;       // Next spec to build
+    bool havePending;
+    bool building;           // The worker is building 'buildingSpec'
+    LevelSpec buildingSpec;
+    std::uint64_t generation; // Bumped by restart(); builds from an older generation are dropped
+    bool stopping;
+    std::uint64_t hits, waits, misses;
+    double buildMsTotal;
+    std::size_t builds;
+    std::thread worker;
+
+    static void lowerThreadPriority() {
+#if defined(_WIN32)
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(SCHED_IDLE)
+        sched_param param = {};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param); // Best effort: stays normal if refused
+#endif
+    }
+
+    void run() {
+        lowerThreadPriority();
+        LevelSolver solver; // Kept for the thread's lifetime, so its scratch buffers are reused
+        MazeGeneratorScratch generatorScratch;
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            workAvailable.wait(guard, [&] { return stopping || (havePending && ready.size() < depth); });
+            if (stopping) return;
+            const LevelSpec spec = pending;
+            const std::uint64_t gen = generation;
+            pending = follow(spec);
+            std::unique_ptr<PreparedLevel> level;
+            if (!spares.empty()) {
+                level = std::move(spares.back());
+                spares.pop_back();
+            } else {
+                level.reset(new PreparedLevel());
+            }
+            building = true;
+            buildingSpec = spec;
+            guard.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            build(spec, *level, solver, generatorScratch);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            guard.lock();
+            building = false;
+            buildMsTotal += ms;
+            builds++;
+            if (gen == generation) ready.push_back(std::move(level));
+            else spares.push_back(std::move(level)); // Restarted meanwhile: not wanted any more
+            levelReady.notify_all();
+        }
+    }
+
+public:
+    // 'buildLevel' fills a PreparedLevel for a spec (called on the worker thread with its own
+    // solver and generator scratch); 'nextSpec' predicts the spec of the level after a given one
+    LevelPipeline(BuildFn buildLevel, FollowFn nextSpec, std::size_t levelsAhead)
+        : build(buildLevel), follow(nextSpec), depth(levelsAhead < 1 ? 1 : levelsAhead), pending(),
+          havePending(false), building(false), buildingSpec(), generation(0), stopping(false), hits(0), waits(0),
+          misses(0), buildMsTotal(0), builds(0) {
+        worker = std::thread(&LevelPipeline::run, this);
+    }
+
+    ~LevelPipeline() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        worker.join();
+    }
+
+    LevelPipeline(const LevelPipeline&) = delete;
+    LevelPipeline& operator=(const LevelPipeline&) = delete;
+
+    // Forget everything queued and build from 'next' on
+    void restart(const LevelSpec& next) {
+        std::lock_guard<std::mutex> guard(lock);
+        generation++;
+        while (!ready.empty()) {
+            spares.push_back(std::move(ready.front()));
+            ready.pop_front();
+        }
+        pending = next;
+        havePending = true;
+        workAvailable.notify_all();
+    }
+
+    // The level for 'spec' if it is built or being built (waits for the build in the latter
+    // case), else null: the caller builds it and restarts the pipeline
+    std::unique_ptr<PreparedLevel> take(const LevelSpec& spec) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (ready.empty() && building && buildingSpec == spec) {
+            const std::uint64_t gen = generation;
+            waits++;
+            levelReady.wait(guard, [&] { return !building || generation != gen; });
+        } else if (!ready.empty() && ready.front()->setup.spec == spec) {
+            hits++;
+        }
+        if (ready.empty() || ready.front()->setup.spec != spec) {
+            misses++;
+            return nullptr;
+        }
+        std::unique_ptr<PreparedLevel> level = std::move(ready.front());
+        ready.pop_front();
+        workAvailable.notify_all(); // Room for one more
+        return level;
+    }
+
+    // Hand a used level back so its buffers are reused (and freed off the game thread)
+    void recycle(std::unique_ptr<PreparedLevel> level) {
+        if (!level) return;
+        std::lock_guard<std::mutex> guard(lock);
+        spares.push_back(std::move(level));
+    }
+
+    std::size_t getDepth() const { return depth; }
+    std::size_t readyCount() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return ready.size();
+    }
+    // take() results: found ready / waited for the build in progress / not there
+    std::uint64_t getHits() const { std::lock_guard<std::mutex> guard(lock); return hits; }
+    std::uint64_t getWaits() const { std::lock_guard<std::mutex> guard(lock); return waits; }
+    std::uint64_t getMisses() const { std::lock_guard<std::mutex> guard(lock); return misses; }
+    // Mean time the worker spends building one level
+    double meanBuildMs() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return builds ? buildMsTotal / static_cast<double>(builds) : 0.0;
+    }
+};
+
+#endif // LEVEL_PIPELINE_H
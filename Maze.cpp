@@ -1,49 +1,57 @@
 // Maze.cpp
 #include <iostream>
-#include <fstream>
 #include <vector>
-#include <random>
-#include <ctime>
 #include <string>    // Explicitly include string
-#include <windows.h> // For Sleep() and console handles
-#include <conio.h>   // For _getch()
+#include <cstdlib>   // For atoi() / atof()
+#include <fstream>   // To check which save file exists
+#include "Console.h"  // Sleep(), console colors and _getch() (windows.h / conio.h, or POSIX stand-ins)
 
-#include "Maze.h"    // Include the header defining Player and Enemy
+#include "MazeSim.h" // Headless game core (rules, grid, Player/Enemy from Maze.h)
+#include "MazeRenderer.h" // Differential ANSI renderer
+#include "AutoSave.h"    // Background save writer
+#include "MazeReplay.h"  // Input log for reproducing a session
+#include "RealTimeLoop.h" // Fixed-timestep sim + render threads for real-time mode
+#include "Instrumentation.h" // Stage timers / counters (MAZE_INSTRUMENT builds only)
 
 using namespace std;
 
-// Windows specific getch alias
+MAZE_COUNT_ALLOCATIONS() // Counts operator new in instrumented builds; nothing otherwise
+
+// Windows-style getch alias (Console.h supplies _getch() elsewhere)
 #define GETCH() _getch()
 
-// Renamed from SIZE to avoid potential conflicts (e.g., with windows.h macros)
-const int MAZE_DIMENSION = 10;
+// Older SDK / MinGW headers predate the VT flag
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
 
+// Console front end: owns the headless MazeSim and adds everything that talks to the
+// terminal (clearing, colors, messages, pauses). Game rules live in MazeSim.h.
 class MazeGame {
 private:
-    // Use the renamed constant for the maze dimensions
-    char maze[MAZE_DIMENSION][MAZE_DIMENSION];
-    Player* player;
-    vector<Enemy*> enemies;
-    int score;
-    int moves;
-    int level;
-    int collectibles;
+    MazeSim sim;
+    unsigned lastEvents; // Events from the most recent move, reported by checkGameState()
+    FrameRenderer renderer; // Double-buffered differential ANSI renderer
+    AutoSaver autosaver; // Writes autosaves and 'V' saves on its own thread
+    InputRecorder recorder; // Logs every move so the session can be replayed (MazeBench replay)
+    string recordFile;
     HANDLE hConsole; // Handle for console colors
     int defaultColor; // Store default console color
-
-    // Function to clear the console screen (Windows specific)
-    void clearScreen() {
-        COORD coordScreen = { 0, 0 };
-        DWORD cCharsWritten;
-        CONSOLE_SCREEN_BUFFER_INFO csbi;
-        DWORD dwConSize;
-
-        if (!GetConsoleScreenBufferInfo(hConsole, &csbi)) return;
-        dwConSize = csbi.dwSize.X * csbi.dwSize.Y;
-        if (!FillConsoleOutputCharacter(hConsole, (TCHAR)' ', dwConSize, coordScreen, &cCharsWritten)) return;
-        if (!GetConsoleScreenBufferInfo(hConsole, &csbi)) return;
-        if (!FillConsoleOutputAttribute(hConsole, csbi.wAttributes, dwConSize, coordScreen, &cCharsWritten)) return;
-        SetConsoleCursorPosition(hConsole, coordScreen);
+    string statusMessage; // Result of the last save/load, shown under the next frame
+    bool statusIsError;
+    bool showStats; // Instrumentation overlay under the board ('i')
+
+    static const int STATS_ROWS = STAGE_COUNT + 3; // Blank line, header, one line per stage, counters
+    static const int LEVELS_AHEAD = 2; // Levels pregenerated in the background (MazeSim::setPregenerateDepth)
+    static const int UNDO_STEPS = 1000; // Moves 'U' can take back (MazeSim::setUndoDepth)
+    // Steps out to which enemies chase (MazeSim::setChaseRadius): a winding path to any square
+    // of the view window, so an enemy the player can see hunts them and the rest wander, and a
+    // move costs the area around the player instead of the whole board
+    static const int CHASE_RADIUS = DEFAULT_VIEW_ROWS + DEFAULT_VIEW_COLS;
+
+    void setStatus(const string& message, bool isError) {
+        statusMessage = message;
+        statusIsError = isError;
     }
 
      // Function to set text color
@@ -51,372 +59,307 @@ private:
         SetConsoleTextAttribute(hConsole, colorCode);
     }
 
-    void initializeMaze() {
-        // Use MAZE_DIMENSION
-        for (int i = 0; i < MAZE_DIMENSION; i++) {
-            for (int j = 0; j < MAZE_DIMENSION; j++) {
-                 // Use MAZE_DIMENSION - 1 for bounds
-                 if (i == 0 || i == MAZE_DIMENSION - 1 || j == 0 || j == MAZE_DIMENSION - 1 || (i%2 != 0 && j%2 != 0))
-                    maze[i][j] = '#';
-                else
-                    maze[i][j] = ' ';
-            }
-        }
-        maze[1][1] = ' '; // Ensure start is clear
-        // Use MAZE_DIMENSION - 2 for exit position
-        maze[MAZE_DIMENSION - 2][MAZE_DIMENSION - 2] = 'E';
-        addCollectibles();
-    }
-
-    void addCollectibles() {
-        static mt19937 gen(static_cast<unsigned int>(time(0)));
-        // Use MAZE_DIMENSION - 2 for distribution bounds
-        uniform_int_distribution<> dis(1, MAZE_DIMENSION - 2);
-
-        collectibles = level + 2;
-        for (int i = 0; i < collectibles; i++) {
-            int r, c;
-            do {
-                r = dis(gen);
-                c = dis(gen);
-             // Use MAZE_DIMENSION - 2 for exit check
-            } while (maze[r][c] != ' ' || (r == 1 && c == 1) || (r == MAZE_DIMENSION - 2 && c == MAZE_DIMENSION - 2));
-            maze[r][c] = '*';
-        }
+    // The overlay: per-stage latencies and the counters, in the last STATS_ROWS rows of the frame
+    void drawStats(FrameRenderer& frame) {
+#if defined(MAZE_INSTRUMENT) && MAZE_INSTRUMENT
+        const Instrumentation& stats = Instrumentation::instance();
+        int row = frame.getHeight() - STATS_ROWS + 1;
+        frame.text(row++, 0, Instrumentation::stageHeader(), 15); // Bright White
+        for (int s = 0; s < STAGE_COUNT; s++) frame.text(row++, 0, stats.stageLine(static_cast<InstrumentStage>(s)), 11);
+        frame.text(row, 0, stats.counterLine(), 11);
+#else
+        frame.text(frame.getHeight() - STATS_ROWS + 1, 0, "Built without MAZE_INSTRUMENT: no stats to show.", 14);
+#endif
     }
 
 public:
-    MazeGame() : score(0), moves(0), level(1), collectibles(0), defaultColor(7) { // Initialize defaultColor
+    explicit MazeGame(int size = MAZE_DIMENSION)
+        : sim(size), lastEvents(EVENT_NONE), defaultColor(7), statusIsError(false), showStats(false) { // Initialize defaultColor
         hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
         CONSOLE_SCREEN_BUFFER_INFO csbi;
         if (GetConsoleScreenBufferInfo(hConsole, &csbi)) {
              defaultColor = csbi.wAttributes; // Get actual default color
         }
-
-        initializeMaze(); // Now maze is correctly declared
-        player = new Player(1, 1); // Uses Player from Maze.h
-
-        // Ensure enemy start position is clear before placing
-        int start_enemy_x = 5;
-        int start_enemy_y = 5;
-        // Basic bounds check for initial enemy placement
-        if (start_enemy_x >= 0 && start_enemy_x < MAZE_DIMENSION && start_enemy_y >= 0 && start_enemy_y < MAZE_DIMENSION) {
-             if (maze[start_enemy_x][start_enemy_y] == '#') {
-                 maze[start_enemy_x][start_enemy_y] = ' '; // Clear if wall
-             }
-             enemies.push_back(new Enemy(start_enemy_x, start_enemy_y)); // Uses Enemy from Maze.h
-        } else {
-             // Handle error or place enemy at a default valid spot if 5,5 is out of bounds
-             if (maze[1][2] == ' ') enemies.push_back(new Enemy(1,2));
-             else enemies.push_back(new Enemy(2,1)); // Failsafe
+        // The renderer speaks ANSI; Windows 10+ consoles understand it once VT processing is on
+        DWORD mode = 0;
+        if (GetConsoleMode(hConsole, &mode)) {
+             SetConsoleMode(hConsole, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
         }
+        sim.setPregenerateDepth(LEVELS_AHEAD); // Next levels are built while this one is played
+        sim.setUndoDepth(UNDO_STEPS);
+    }
 
+    // --- Public Getters Added ---
+    int getScore() const { return sim.getScore(); }
+    int getPlayerX() const { return sim.getPlayerX(); }
+    int getPlayerY() const { return sim.getPlayerY(); }
+    int getCollectiblesRemaining() const { return sim.getCollectiblesRemaining(); }
+    int getDimension() const { return sim.getDimension(); }
+    char getCell(int x, int y) const { return sim.getCell(x, y); }
+    // --- End Getters ---
 
+    // Enemies wander (classic) or chase the player along the sim's flow field, from up to
+    // 'chaseRadius' steps away (0 = the whole board, a full field update per move)
+    void setEnemyBehavior(EnemyBehavior behavior, std::uint32_t chaseRadius = CHASE_RADIUS) {
+        sim.setChaseRadius(chaseRadius);
+        sim.setEnemyBehavior(behavior);
     }
 
-    ~MazeGame() {
-        delete player;
-        for (auto enemy : enemies) {
-            delete enemy;
-        }
-        enemies.clear();
+    // Real-time mode: enemies move on a clock (playRealTime) instead of after every move.
+    // Set before startRecording(), which notes the mode in the log. Undo is turn-based only:
+    // the enemy clock would keep running over the moves being taken back.
+    void setRealTime(bool enabled) {
+        sim.setTurnBased(!enabled);
+        sim.setUndoDepth(enabled ? 0 : UNDO_STEPS);
     }
 
-    // --- Public Getters Added ---
-    int getScore() const { return score; }
-    int getPlayerX() const { return player->getX(); }
-    int getPlayerY() const { return player->getY(); }
-    int getCollectiblesRemaining() const { return collectibles; }
-    char getCell(int x, int y) const {
-        // Added bounds checking for safety
-        if (x >= 0 && x < MAZE_DIMENSION && y >= 0 && y < MAZE_DIMENSION) {
-            return maze[x][y];
-        }
-        return '#'; // Return wall if out-of-bounds request
+    // Autosave to maze_autosave.dat every 'moves' moves or 'seconds' seconds (0 = off)
+    void setAutosaveInterval(int moves, double seconds) { autosaver.setInterval(moves, seconds); }
+
+    // Log this session's moves to 'filename' from the current state (after the settings are
+    // applied, since the log embeds them). A load starts a fresh log from the loaded state.
+    void startRecording(const string& filename) {
+        recordFile = filename;
+        string error;
+        if (!recorder.start(recordFile, sim, &error)) setStatus("Error: " + error, true);
+    }
+
+    // Pick the maze generator and start over on a board built with it
+    void setMazeAlgorithm(MazeAlgorithm algorithm) {
+        sim.setMazeAlgorithm(algorithm);
+        sim.newGame();
     }
-    // --- End Getters ---
 
 
+    // Draw the current state. Only cells that changed since the last frame are sent to
+    // the terminal, as one ANSI escape stream written in a single call.
     void display() {
-        clearScreen();
-
-        const int COLOR_WALL = 13;    // Magenta / Purple
-        const int COLOR_PLAYER = 14;   // Yellow
-        const int COLOR_ENEMY = 12;    // Bright Red
-        const int COLOR_ITEM = 11;   // Bright Cyan / Yellowish
-        const int COLOR_EXIT = 10;    // Bright Green
-
-        cout << "--- Maze Game --- Level: " << level << " ---\n";
-
-        // Use MAZE_DIMENSION
-        for (int i = 0; i < MAZE_DIMENSION; i++) {
-            for (int j = 0; j < MAZE_DIMENSION; j++) {
-                bool drawn = false;
-                if (i == player->getX() && j == player->getY()) {
-                    setColor(COLOR_PLAYER);
-                    cout << player->getSymbol() << " ";
-                    drawn = true;
-                } else {
-                    for (auto enemy : enemies) {
-                        if (i == enemy->getX() && j == enemy->getY()) {
-                            setColor(COLOR_ENEMY);
-                            cout << enemy->getSymbol() << " ";
-                            drawn = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (!drawn) {
-                    char cell = maze[i][j]; // Safe now: maze is accessible
-                    if (cell == '#') setColor(COLOR_WALL);
-                    else if (cell == '*') setColor(COLOR_ITEM);
-                    else if (cell == 'E') setColor(COLOR_EXIT);
-                    else setColor(defaultColor); // Empty space
-                    cout << cell << " ";
-                }
-                 setColor(defaultColor); // Reset color after each cell
-            }
-            cout << endl;
-        }
-         setColor(defaultColor); // Ensure color is reset after the loop
-        cout << "Score: " << score << " | Moves: " << moves << " | Collectibles left: " << collectibles << endl;
+        MAZE_TIMED_SCOPE(STAGE_DISPLAY);
+        drawMazeFrame(renderer, sim, DEFAULT_VIEW_ROWS, DEFAULT_VIEW_COLS, showStats ? STATS_ROWS : 0);
+        if (showStats) drawStats(renderer);
+        renderer.present(stdoutSink);
     }
 
-    bool movePlayer(char direction) {
-        int dx = 0, dy = 0;
-        switch (tolower(direction)) {
-            case 'w': dx = -1; break;
-            case 's': dx = 1; break;
-            case 'a': dy = -1; break;
-            case 'd': dy = 1; break;
-            default: return false;
-        }
-
-        int newX = player->getX() + dx;
-        int newY = player->getY() + dy;
+    // Show / hide the instrumentation overlay
+    void toggleStats() { showStats = !showStats; }
 
-        // Use MAZE_DIMENSION for bounds check
-        if (newX >= 0 && newX < MAZE_DIMENSION && newY >= 0 && newY < MAZE_DIMENSION && maze[newX][newY] != '#') {
-            if (maze[newX][newY] == '*') {
-                score += 10;
-                collectibles--;
-                maze[newX][newY] = ' '; // Clear collectible
-            }
-            player->move(dx, dy);
-            moves++;
-            // It might make more sense to move enemies *before* checking game state,
-            // but we'll keep original logic for now.
-            moveEnemies();
-            return true;
-        }
-        return false;
+    // End-of-game report of everything the instrumentation recorded
+    void printStats() {
+#if defined(MAZE_INSTRUMENT) && MAZE_INSTRUMENT
+        cout << "\n--- Instrumentation ---" << endl;
+        Instrumentation::instance().printSummary(stdout);
+        fflush(stdout);
+#endif
     }
 
-    void moveEnemies() {
-        // Seed slightly differently or just once if preferred
-        static mt19937 gen(static_cast<unsigned int>(time(0)) + 1);
-        uniform_int_distribution<> dis(-1, 1);
-
-        for (auto enemy : enemies) {
-            int dx = 0, dy = 0, newX = 0, newY = 0;
-            int attempts = 0;
-            const int maxAttempts = 10; // Prevent infinite loops if stuck
-            do {
-                dx = dis(gen);
-                dy = dis(gen);
-                // Allow diagonal moves if dx and dy are both non-zero, but prevent standing still
-                if (dx == 0 && dy == 0) continue;
-
-                newX = enemy->getX() + dx;
-                newY = enemy->getY() + dy;
-                attempts++;
-
-             // Check bounds using MAZE_DIMENSION and ensure it's not a wall or exit
-            } while ( !(newX >= 0 && newX < MAZE_DIMENSION && newY >= 0 && newY < MAZE_DIMENSION && maze[newX][newY] != '#' && maze[newX][newY] != 'E') &&
-                     attempts < maxAttempts);
-
-            // Only move if a valid move was found within attempts
-            if (attempts < maxAttempts) {
-                 // Check for collision with player *before* moving enemy onto player space? Optional.
-                 // if (newX == player->getX() && newY == player->getY()) { /* Handle potential immediate collision */ }
-                enemy->move(dx, dy);
-            }
-        }
+    size_t lastFrameBytes() const { return renderer.lastFrameBytes(); }
+
+    // Steps the simulation; returns true if the player actually moved
+    bool movePlayer(char direction) {
+        const SimAction action = actionFromKey(direction);
+        recorder.record(action); // Exactly what the sim is given, so the log replays this session
+        lastEvents = sim.step(action);
+        autosaver.poll(sim); // A snapshot at most; the writer thread does the I/O
+        return (lastEvents & EVENT_MOVED) != 0;
     }
 
+    // Reports what the last move caused. Returns false once the game is over.
     bool checkGameState() {
-        // Check for collision with player
-        for (auto enemy : enemies) {
-            if (player->getX() == enemy->getX() && player->getY() == enemy->getY()) {
-                // Use Windows API for color instead of potentially unsupported ANSI codes here
-                setColor(12); // Bright Red
-                cout << "\n--- Ouch! Caught by an enemy! ---" << endl;
-                setColor(defaultColor);
-                return false; // Game over
-            }
+        if (lastEvents & EVENT_CAUGHT) {
+            // Use Windows API for color instead of potentially unsupported ANSI codes here
+            setColor(12); // Bright Red
+            cout << "\n--- Ouch! Caught by an enemy! ---" << endl;
+            setColor(defaultColor);
+            return false; // Game over
         }
-
-        // Check for reaching the exit
-        // Use MAZE_DIMENSION-2 to correctly identify exit location defined in initializeMaze
-        if (player->getX() == MAZE_DIMENSION - 2 && player->getY() == MAZE_DIMENSION - 2) {
-             if (collectibles == 0) {
-                setColor(10); // Bright Green
-                cout << "\n--- Level " << level << " Complete! --- Moving to next level..." << endl;
-                setColor(defaultColor);
-                level++;
-                resetLevel();
-                Sleep(1500); // Pause
-                return true; // Continue playing (next level)
-             } else {
-                 // Player is at exit, but hasn't collected everything (handled in main loop display now)
-                 return true; // Continue playing (still on current level)
-             }
+        if (lastEvents & EVENT_LEVEL_COMPLETE) {
+            // The sim has already advanced to the new level (normally one that was waiting in
+            // the pipeline), so report it under the next frame instead of pausing the game
+            setStatus("--- Level " + to_string(sim.getLevel() - 1) + " Complete! ---" +
+                      (lastEvents & EVENT_PAR ? " Par or better! +" + to_string(PAR_BONUS) : string()), false);
         }
-        return true; // Continue playing (no game-ending event occurred)
+        return true; // Continue playing
     }
 
-    void resetLevel() {
-        initializeMaze(); // Re-generates walls, exit, and collectibles
-        player->x = 1; // Reset player position (direct access okay within class)
-        player->y = 1;
-
-        // Reposition existing enemies, ensuring they aren't in walls
-        int enemy_start_x = 5;
-        int enemy_start_y = 5;
-        for (size_t i = 0; i < enemies.size(); ++i) {
-             // Simple repositioning logic, could be improved
-             int new_ex = (enemy_start_x + i) % (MAZE_DIMENSION - 2) + 1; // Spread them out a bit
-             int new_ey = (enemy_start_y + i) % (MAZE_DIMENSION - 2) + 1;
-
-             // Ensure the spot is clear
-             while (maze[new_ex][new_ey] != ' ' || (new_ex == 1 && new_ey == 1)) {
-                 new_ey++;
-                 if (new_ey >= MAZE_DIMENSION - 1) {
-                     new_ey = 1;
-                     new_ex++;
-                     if (new_ex >= MAZE_DIMENSION - 1) {
-                         new_ex = 1; // Wrap around
-                     }
-                 }
-             }
-             enemies[i]->x = new_ex; // Direct access okay within class
-             enemies[i]->y = new_ey;
-             maze[new_ex][new_ey] = ' '; // Make sure spot is marked traversable if we cleared a wall
+    // Save/load report on the line under the next frame instead of a pause: the message stays
+    // up until the next key, and the game never blocks for a fixed second.
+    // Saving only snapshots the game; the file is written in the background (a failure is
+    // reported under a later frame).
+    void saveGame(const string& filename) {
+        autosaver.submit(sim.snapshot(), filename);
+        setStatus("--- Game Saved to " + filename + " ---", false);
+    }
+
+    // Loads 'filename', or 'legacyFilename' (an old text save) if the first doesn't exist yet
+    void loadGame(const string& filename, const string& legacyFilename) {
+        autosaver.flush(); // A save still being written would otherwise be read half-done
+        string chosen = filename;
+        if (!ifstream(filename).is_open() && ifstream(legacyFilename).is_open()) chosen = legacyFilename;
+        string error;
+        if (sim.loadGame(chosen, &error)) {
+            setStatus("--- Game Loaded from " + chosen + " ---", false);
+            if (recorder.isRecording()) startRecording(recordFile);
+        } else {
+            setStatus("Error: " + error, true);
         }
+    }
 
-        // Add new enemies based on level
-        if (level >= 3 && enemies.size() < (level / 2) + 1) {
-             int new_enemy_x = 3, new_enemy_y = 3;
-             // Find an empty spot for the new enemy
-             while(maze[new_enemy_x][new_enemy_y] != ' ' || (new_enemy_x == 1 && new_enemy_y == 1)) {
-                 new_enemy_y++;
-                 if(new_enemy_y >= MAZE_DIMENSION - 1) { new_enemy_y = 1; new_enemy_x++; }
-                 if(new_enemy_x >= MAZE_DIMENSION - 1) new_enemy_x = 1; // Wrap around search
-             }
-             enemies.push_back(new Enemy(new_enemy_x, new_enemy_y));
-             maze[new_enemy_x][new_enemy_y] = ' '; // Ensure spot is traversable
+    // Take back the last move ('U') / play it again ('R'). The replay log can't express an
+    // undo, so like a load it starts a fresh log from the state the undo left behind.
+    void undoMove() {
+        if (!sim.undo()) {
+            setStatus("--- Nothing to undo ---", true);
+            return;
         }
-        // moves = 0; // Optional: Reset moves per level? Currently cumulative.
+        setStatus("--- Move undone (" + to_string(sim.getHistory().undoCount()) + " more can be) ---", false);
+        if (recorder.isRecording()) startRecording(recordFile);
     }
 
-    void saveGame(const string& filename) {
-        ofstream file(filename);
-        if (file.is_open()) {
-            file << level << " " << score << " " << moves << " " << collectibles << endl;
-            file << player->getX() << " " << player->getY() << endl; // Use getters for consistency if desired, though direct access is fine here
-            file << enemies.size() << endl;
-            for(const auto& enemy : enemies) {
-                file << enemy->getX() << " " << enemy->getY() << endl;
-            }
-            // Use MAZE_DIMENSION
-            for (int i = 0; i < MAZE_DIMENSION; i++) {
-                for (int j = 0; j < MAZE_DIMENSION; j++)
-                    file << maze[i][j];
-                file << endl;
-            }
-            file.close();
-            cout << "\n--- Game Saved to " << filename << " ---" << endl;
-            Sleep(1000);
-        } else {
-            cerr << "Error: Could not open file " << filename << " for saving!" << endl;
-            Sleep(1000);
+    void redoMove() {
+        if (!sim.redo()) {
+            setStatus("--- Nothing to redo ---", true);
+            return;
         }
+        setStatus("--- Move redone ---", false);
+        if (recorder.isRecording()) startRecording(recordFile);
     }
 
-    void loadGame(const string& filename) {
-        ifstream file(filename);
-        if (file.is_open()) {
-            // Temporary variables for reading
-            int loadedLevel, loadedScore, loadedMoves, loadedCollectibles;
-            int px, py;
-            size_t enemyCount;
-
-            // Read stats
-            file >> loadedLevel >> loadedScore >> loadedMoves >> loadedCollectibles;
-            if (file.fail()) { cerr << "Error reading game stats from save file." << endl; file.close(); return; }
-
-            // Read player position
-            file >> px >> py;
-            if (file.fail()) { cerr << "Error reading player position from save file." << endl; file.close(); return; }
-
-            // Read enemy count
-            file >> enemyCount;
-            if (file.fail()) { cerr << "Error reading enemy count from save file." << endl; file.close(); return; }
-
-            // --- If all reads up to this point succeed, apply changes ---
-            level = loadedLevel;
-            score = loadedScore;
-            moves = loadedMoves;
-            collectibles = loadedCollectibles;
-            player->x = px; // Direct access okay within class
-            player->y = py;
-
-            // Clear old enemies and load new ones
-            for (auto enemy : enemies) { delete enemy; }
-            enemies.clear();
-            for(size_t i = 0; i < enemyCount; ++i) {
-                int ex, ey;
-                file >> ex >> ey;
-                if (file.fail()) {
-                    cerr << "Error reading enemy " << i << " position from save file." << endl;
-                    // Clear potentially partially loaded enemies to avoid issues
-                    for(auto enemy : enemies) { delete enemy; }
-                    enemies.clear();
-                    file.close();
-                    return; // Abort load
-                }
-                enemies.push_back(new Enemy(ex, ey));
+    // Real-time game: a sim thread ticks 'tickHz' times a second and moves the enemies
+    // 'enemyHz' times a second, a render thread presents up to 'renderHz' frames a second,
+    // and the calling thread becomes the input thread. Returns once the player is caught
+    // (after one more key) or quits, then prints the loop's timing report.
+    void playRealTime(double tickHz, double enemyHz, double renderHz) {
+        RealTimeLoop loop(tickHz, enemyHz, renderHz);
+        auto onKey = [this](char key) -> bool {
+            MAZE_TIMED_SCOPE(STAGE_INPUT);
+            switch (tolower(key)) {
+                case 'w':
+                case 'a':
+                case 's':
+                case 'd':
+                    statusMessage.clear(); // A move dismisses the last message
+                    movePlayer(key);
+                    if (lastEvents & EVENT_CAUGHT) {
+                        setStatus("--- Ouch! Caught by an enemy! --- Press any key.", true);
+                        return false;
+                    }
+                    if (lastEvents & EVENT_LEVEL_COMPLETE) {
+                        setStatus("--- Level " + to_string(sim.getLevel() - 1) + " Complete! ---" +
+                                  (lastEvents & EVENT_PAR ? " Par or better! +" + to_string(PAR_BONUS) : string()), false);
+                    }
+                    return true;
+                case 'v':
+                    saveGame("maze_save.dat");
+                    return true;
+                case 'l':
+                    loadGame("maze_save.dat", "maze_save.txt");
+                    return true;
+                case 'i':
+                    toggleStats();
+                    return true;
+                case 'q':
+                    return false;
+                default:
+                    return true;
             }
-
-            // Read maze grid
-            string line;
-            getline(file, line); // Consume the rest of the line after the last enemy coords
-            // Use MAZE_DIMENSION
-            for (int i = 0; i < MAZE_DIMENSION; i++) {
-                 if (!getline(file, line) || line.length() < MAZE_DIMENSION) { // Check line length
-                     cerr << "Error reading maze grid line " << i << " or line too short from save file." << endl;
-                     file.close();
-                     // Potentially revert game state or handle error more gracefully
-                     return; // Abort load
-                 }
-                 for (int j = 0; j < MAZE_DIMENSION; j++) {
-                    maze[i][j] = line[j];
-                 }
+        };
+        auto onEnemyStep = [this]() -> bool {
+            recorder.recordEnemyStep();
+            if (sim.tickEnemies() & EVENT_CAUGHT) {
+                setStatus("--- Ouch! Caught by an enemy! --- Press any key.", true);
+                return false;
             }
-
-            file.close();
-            cout << "\n--- Game Loaded from " << filename << " ---" << endl;
-            Sleep(1000);
-        } else {
-            cerr << "Error: Could not open file " << filename << " for loading!" << endl;
-            Sleep(1000);
+            return true;
+        };
+        auto onDraw = [this](FrameRenderer& frame) {
+            drawMazeFrame(frame, sim, DEFAULT_VIEW_ROWS, DEFAULT_VIEW_COLS, 2 + (showStats ? STATS_ROWS : 0));
+            if (showStats) drawStats(frame);
+            string error;
+            if (autosaver.takeError(error)) setStatus("Error: " + error, true);
+            const int row = frame.getHeight() - 1 - (showStats ? STATS_ROWS : 0);
+            if (!statusMessage.empty()) {
+                frame.text(row, 0, statusMessage, statusIsError ? 12 : 10); // Bright Red / Bright Green
+            } else if (sim.getCell(sim.getPlayerX(), sim.getPlayerY()) == 'E' && sim.getCollectiblesRemaining() > 0) {
+                frame.text(row, 0, "Collect all '*' before exiting!", 14); // Yellow
+            } else {
+                frame.text(row, 0, "Move (w/a/s/d), Save (v), Load (l), Stats (i), Quit (q)", 11); // Bright Cyan
+            }
+        };
+        loop.start(onKey, onEnemyStep, onDraw, renderer, stdoutSink);
+        while (!loop.finished()) {
+            const char key = static_cast<char>(GETCH());
+            loop.pushInput(key);
+            if (tolower(key) == 'q') break;
         }
+        loop.stop();
+
+        const RealTimeLoop::Stats& stats = loop.getStats();
+        cout << "\nTicks: " << stats.ticks << " (" << stats.lateTicks << " late, " << stats.skippedTicks
+             << " skipped), jitter p50/p99/max " << stats.tickJitter.percentile(0.5) << " / "
+             << stats.tickJitter.percentile(0.99) << " / " << stats.tickJitter.max() << " ms" << endl;
+        cout << "Frames: " << stats.frames << " (" << stats.framesDropped << " dropped), input-to-render p50/p99/max "
+             << stats.inputLatency.percentile(0.5) << " / " << stats.inputLatency.percentile(0.99) << " / "
+             << stats.inputLatency.max() << " ms" << endl;
+    }
+
+    // Print (and clear) the pending save/load message, if any
+    void showStatus() {
+        string error;
+        if (autosaver.takeError(error)) setStatus("Error: " + error, true);
+        if (statusMessage.empty()) return;
+        setColor(statusIsError ? 12 : 10); // Bright Red / Bright Green
+        cout << "\n" << statusMessage << endl;
+        setColor(defaultColor);
+        statusMessage.clear();
     }
 }; // End of MazeGame class
 
-int main() {
-    MazeGame game;
+int main(int argc, char* argv[]) {
+    // Optional board size, "chase", a generator name, an autosave interval and real-time mode
+    // on the command line, e.g. "Maze.exe 4096 chase wilson autosave=50 realtime"
+    // ("chase=200" to chase from 200 steps instead of the view window's reach, "chase=0"
+    // from anywhere; "autosave=30s" for seconds, "autosave=off" to disable, "realtime=6" for
+    // 6 enemy moves a second instead of 4)
+    int boardSize = MAZE_DIMENSION;
+    bool chase = false;
+    int chaseRadius = -1; // -1 = MazeGame's default
+    double enemyHz = 0; // 0 = turn-based
+    MazeAlgorithm algorithm = MAZE_BACKTRACKER;
+    int autosaveMoves = 100;
+    double autosaveSeconds = 60.0;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "chase" || arg.compare(0, 6, "chase=") == 0) {
+            chase = true;
+            if (arg.size() > 6) chaseRadius = atoi(arg.c_str() + 6);
+            continue;
+        }
+        if (arg.compare(0, 9, "autosave=") == 0) {
+            const string value = arg.substr(9);
+            autosaveMoves = 0;
+            autosaveSeconds = 0;
+            if (!value.empty() && value.back() == 's') autosaveSeconds = atof(value.c_str());
+            else if (value != "off") autosaveMoves = atoi(value.c_str());
+            continue;
+        }
+        if (arg == "realtime" || arg.compare(0, 9, "realtime=") == 0) {
+            enemyHz = arg.size() > 9 ? atof(arg.c_str() + 9) : 4.0;
+            if (enemyHz <= 0) enemyHz = 4.0;
+            continue;
+        }
+        if (parseMazeAlgorithm(argv[i], algorithm)) continue;
+        boardSize = atoi(argv[i]);
+        if (boardSize < MIN_MAZE_DIMENSION) boardSize = MAZE_DIMENSION;
+    }
+    MazeGame game(boardSize);
+    if (algorithm != MAZE_BACKTRACKER) game.setMazeAlgorithm(algorithm);
+    if (chase) {
+        if (chaseRadius >= 0) game.setEnemyBehavior(ENEMIES_CHASE, static_cast<std::uint32_t>(chaseRadius));
+        else game.setEnemyBehavior(ENEMIES_CHASE);
+    }
+    game.setAutosaveInterval(autosaveMoves, autosaveSeconds);
+    game.setRealTime(enemyHz > 0);
+    game.startRecording("maze_replay.rec");
     char input;
     bool running = true;
 
@@ -441,7 +384,10 @@ int main() {
     cout << "    * Use W to move up, A to move left, S to move down, D to move right.          " << endl;
     cout << "    * Collect * for 10 points, reach 'E' after collecting all * to level up.      " << endl;
     cout << "    * Avoid 'X' enemies! Collision is Game Over.                                  " << endl;
+    cout << "    * Finish a level within its par moves for a 50 point bonus.                   " << endl;
     cout << "    * Save game with 'V', load game with 'L', quit with 'Q'.                      " << endl;
+    cout << "    * Take back a move with 'U', play it again with 'R' (turn-based games).       " << endl;
+    cout << "    * Press 'I' to show or hide timing stats (instrumented builds).               " << endl;
     SetColorMain(15); // Bright White
     cout << "----------------------------------------------------------------------------------" << endl;
     // Highlight start prompt
@@ -451,8 +397,13 @@ int main() {
     cout << endl;
     GETCH(); // Wait for key press
 
+    if (enemyHz > 0) {
+        game.playRealTime(60.0, enemyHz, 60.0); // 60 Hz sim clock and frame rate
+        running = false;
+    }
     while (running) {
         game.display(); // Game handles its own colors during display
+        game.showStatus();
 
         // Display reminder if at exit but items remain - USE GETTERS
         int currentPX = game.getPlayerX();
@@ -465,38 +416,52 @@ int main() {
         }
 
         SetColorMain(11); // Bright Cyan for prompt
-        cout << "\nMove (w/a/s/d), Save (v), Load (l), Quit (q): ";
+        cout << "\nMove (w/a/s/d), Undo (u), Redo (r), Save (v), Load (l), Stats (i), Quit (q): ";
         SetColorMain(defaultColorMain);
 
         input = GETCH();
         // cout << input << endl; // Optional: Echo input back
 
-        switch (tolower(input)) {
-            case 'w':
-            case 'a':
-            case 's':
-            case 'd':
-                if (game.movePlayer(input)) {
-                   // Check game state *after* potentially moving and enemies moving
-                   running = game.checkGameState();
-                }
-                break;
-            case 'v':
-                game.saveGame("maze_save.txt");
-                // Keep running = true after save
-                break;
-            case 'l':
-                game.loadGame("maze_save.txt");
-                // Keep running = true after load attempt
-                break;
-            case 'q':
-                running = false;
-                cout << "\nQuitting game..." << endl;
-                break;
-            default:
-                 // cout << "\nInvalid key!" << endl; // Optional feedback
-                 // Sleep(50); // Optional small delay
-                 break; // Do nothing for invalid input
+        bool moved = false;
+        {
+            MAZE_TIMED_SCOPE(STAGE_INPUT); // The key's own work; reporting what the move caused (below) is not counted
+            switch (tolower(input)) {
+                case 'w':
+                case 'a':
+                case 's':
+                case 'd':
+                    moved = game.movePlayer(input);
+                    break;
+                case 'v':
+                    game.saveGame("maze_save.dat");
+                    // Keep running = true after save
+                    break;
+                case 'l':
+                    game.loadGame("maze_save.dat", "maze_save.txt");
+                    // Keep running = true after load attempt
+                    break;
+                case 'u':
+                    game.undoMove();
+                    break;
+                case 'r':
+                    game.redoMove();
+                    break;
+                case 'i':
+                    game.toggleStats();
+                    break;
+                case 'q':
+                    running = false;
+                    cout << "\nQuitting game..." << endl;
+                    break;
+                default:
+                     // cout << "\nInvalid key!" << endl; // Optional feedback
+                     // Sleep(50); // Optional small delay
+                     break; // Do nothing for invalid input
+            }
+        }
+        if (moved) {
+           // Check game state *after* potentially moving and enemies moving
+           running = game.checkGameState();
         }
     }
 
@@ -508,6 +473,7 @@ int main() {
     SetColorMain(defaultColorMain); // Reset to default
     cout << endl << endl;
 
+    game.printStats();
 
     cout << "Press any key to exit." << endl;
     GETCH();
@@ -2,6 +2,8 @@
 #ifndef GAME_ENTITY_H // Start of include guard
 #define GAME_ENTITY_H
 
+template <int W, int H> class BasicMazeGame; // The headless core (MazeSim.h)
+
 // A simple base class for game objects with position and symbol
 class GameEntity {
 protected: // Protected allows derived classes (Player, Enemy) to access directly
@@ -23,6 +25,12 @@ public:
         y += dy;
     }
 
+    // Teleport (level reset, loading)
+    void setPosition(int newX, int newY) {
+        x = newX;
+        y = newY;
+    }
+
     // Getter methods for position and symbol
     int getX() const { return x; } // Mark getters as const
     int getY() const { return y; } // Mark getters as const
@@ -33,6 +41,7 @@ public:
 
     // Make MazeGame::resetLevel and MazeGame::loadGame friends to allow direct modification of x, y
     friend class MazeGame; // Grant friendship to the entire class for simplicity here
+    template <int W, int H> friend class BasicMazeGame; // The headless core (MazeSim.h) owns and repositions entities
 };
 
 // Player class, derived from GameEntity
@@ -43,6 +52,8 @@ public:
 };
 
 // Enemy class, derived from GameEntity
+// Note: MazeSim keeps its enemies in an EnemyStore (EnemyStore.h, struct-of-arrays) rather
+// than as individual Enemy objects; this class remains for code that wants a single entity.
 class Enemy : public GameEntity {
 public:
     // Constructor specifically for Enemy, setting symbol to 'X'
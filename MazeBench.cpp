@@ -0,0 +1,1607 @@
+// MazeBench.cpp
+// Headless driver for the game core. Runs MazeSim without any console I/O, so it builds
+// and runs on Linux as well as Windows:
+//
+//   MazeBench throughput [boardSize] [steps]   - random moves through step_n(), reports steps/second
+//   MazeBench vecenv [games] [boardSize] [threads] [steps] - batched stepping + bit-plane observations, env steps/second
+//   MazeBench pregen [boardSize] [levels] [depth] [thinkMs] - level change latency, built on the spot vs pregenerated
+//   MazeBench fixed [steps] [newGames]          - compile-time 10 x 10 board (ClassicMazeSim) vs runtime-sized MazeSim
+//   MazeBench render [boardSize] [frames]      - differential renderer into a null sink, reports bytes/frame
+//   MazeBench occupancy [boardSize] [maxEnemies] - linear enemy scans vs the occupancy index
+//   MazeBench enemies [boardSize] [maxEnemies] [threads] - enemy update kernel, ms per tick + determinism checksum
+//   MazeBench flowfield [boardSize] [moves] [radius] - incremental chase field vs full rebuilds
+//   MazeBench generate [boardSize] [algorithm|all] [outFile] - maze generation cells/second (+ streaming Eller to disk)
+//   MazeBench placement [boardSize]             - free-cell index vs retry-until-free placement as the board fills
+//   MazeBench solver [boardSize] [maxItems]      - bitset flood vs BFS, multi-source BFS vs one BFS per item, DP vs 2-opt routes
+//   MazeBench save [boardSize] [enemies]        - text vs binary save/load MB/s, round trip + corruption checks
+//   MazeBench autosave [boardSize] [enemies] [everyMoves] [steps] - game-thread cost of sync vs background saves
+//   MazeBench undo [boardSize] [steps] [enemies] - undo history memory per step, undo/redo latency, round-trip check
+//   MazeBench record [boardSize] [steps] [enemies] [logFile] [chase] - record a random session to a replay log
+//   MazeBench replay [logFile] [step]          - replay a log at full speed, keyframe seeks vs re-simulation
+//   MazeBench realtime [boardSize] [enemies] [enemyHz] [seconds] [keysPerSecond] [renderCostMs] - tick jitter, latency, dropped frames
+//   MazeBench suite [outFile.json] [quick]     - every hot game function across sizes / enemy counts, as JSON
+//   MazeBench compare [base.json] [new.json] [thresholdPercent] - flag functions that got slower between two suite runs
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MazeSim.h" // Headless game core
+#include "MazeRenderer.h" // Differential ANSI renderer
+#include "AutoSave.h"    // Background save writer
+#include "MazeReplay.h"  // Input recording and replay
+#include "RealTimeLoop.h" // Fixed-timestep sim + render threads
+#include "VecEnv.h"      // Batched environments for bots
+
+using namespace std;
+
+// Feed random w/a/s/d actions through step_n() in batches and report how fast the core runs.
+// A caught player simply starts a new game so the run always covers the requested step count.
+static void runThroughput(int boardSize, size_t totalSteps) {
+    const size_t BATCH = 1 << 16;
+    mt19937 gen(12345); // Fixed seed for the action stream so runs are comparable
+    uniform_int_distribution<int> dis(ACTION_UP, ACTION_RIGHT);
+    vector<SimAction> actions(BATCH);
+    for (auto& a : actions) a = static_cast<SimAction>(dis(gen));
+    vector<unsigned> events(BATCH);
+
+    MazeSim sim(boardSize);
+    size_t done = 0, games = 1, collected = 0, levels = 0, blocked = 0;
+
+    auto start = chrono::steady_clock::now();
+    while (done < totalSteps) {
+        size_t want = totalSteps - done < BATCH ? totalSteps - done : BATCH;
+        size_t ran = sim.step_n(actions.data(), want, events.data());
+        for (size_t i = 0; i < ran; i++) {
+            if (events[i] & EVENT_COLLECTED) collected++;
+            if (events[i] & EVENT_LEVEL_COMPLETE) levels++;
+            if (events[i] & EVENT_BLOCKED) blocked++;
+        }
+        done += ran;
+        if (sim.isGameOver()) {
+            sim.newGame();
+            games++;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "board        : " << sim.getDimension() << " x " << sim.getDimension() << "\n";
+    cout << "steps        : " << done << "\n";
+    cout << "games        : " << games << " (levels completed: " << levels << ", items: " << collected
+         << ", blocked moves: " << blocked << ")\n";
+    cout << "time         : " << seconds << " s\n";
+    cout << "steps/second : " << static_cast<double>(done) / seconds << endl;
+}
+
+// Step the game and present a frame after every move, discarding the output.
+// Reports the size of the first (full) frame next to the average differential frame.
+static void runRender(int boardSize, size_t frames) {
+    mt19937 gen(12345);
+    uniform_int_distribution<int> dis(ACTION_UP, ACTION_RIGHT);
+    MazeSim sim(boardSize);
+    FrameRenderer renderer;
+    FrameRenderer::Sink sink = nullSink;
+
+    drawMazeFrame(renderer, sim);
+    size_t fullBytes = renderer.present(sink);
+    size_t totalBytes = 0, totalCells = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; f++) {
+        sim.step(static_cast<SimAction>(dis(gen)));
+        if (sim.isGameOver()) sim.newGame();
+        drawMazeFrame(renderer, sim);
+        totalBytes += renderer.present(sink);
+        totalCells += renderer.lastFrameCells();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "board          : " << sim.getDimension() << " x " << sim.getDimension() << "\n";
+    cout << "frames         : " << frames << "\n";
+    cout << "full frame     : " << fullBytes << " bytes\n";
+    cout << "avg frame      : " << static_cast<double>(totalBytes) / frames << " bytes ("
+         << static_cast<double>(totalCells) / frames << " cells re-sent)\n";
+    cout << "frames/second  : " << static_cast<double>(frames) / seconds << endl;
+}
+
+// Nanoseconds per call of 'fn' over 'iterations' calls
+template <typename Fn>
+static double nsPerCall(size_t iterations, Fn fn) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) fn(i);
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// Top the sim up to 'count' enemies: free squares first (a bounded pick each through the
+// free-cell index), then, once the board is full, stacked on random walkable squares
+static void spawnEnemies(MazeSim& sim, size_t count, unsigned seed) {
+    if (sim.getEnemies().size() >= count) return;
+    size_t missing = count - sim.getEnemies().size();
+    sim.spawnEnemies(missing < sim.getFreeCells().size() ? missing : sim.getFreeCells().size());
+    const MazeGrid& maze = sim.getGrid();
+    mt19937 gen(seed);
+    uniform_int_distribution<int> pos(1, sim.getDimension() - 2);
+    while (sim.getEnemies().size() < count) {
+        int x = pos(gen), y = pos(gen);
+        if (!maze.isWall(x, y) && maze.at(x, y) != 'E') sim.addEnemy(x, y);
+    }
+}
+
+// Compare the old linear scans (what checkGameState/display used to do) against the
+// occupancy index for growing enemy counts.
+static void runOccupancy(int boardSize, size_t maxEnemies) {
+    cout << "enemies   point-scan(ns)  point-index(ns)  radius2-scan(ns)  radius2-index(ns)  frame(us)  tick(ns/enemy)\n";
+    for (size_t count = 1; count <= maxEnemies; count *= 10) {
+        MazeSim sim(boardSize);
+        spawnEnemies(sim, count, 777);
+        mt19937 gen(777);
+        uniform_int_distribution<int> pos(1, sim.getDimension() - 2);
+        const EnemyStore& enemies = sim.getEnemies();
+        const int32_t* ex = enemies.xData();
+        const int32_t* ey = enemies.yData();
+        const OccupancyGrid& occupancy = sim.getOccupancy();
+
+        // Random probe positions, shared by all variants
+        const size_t QUERIES = 20000;
+        vector<pair<int, int>> probes(QUERIES);
+        for (auto& p : probes) p = make_pair(pos(gen), pos(gen));
+        size_t sink = 0; // Keeps the optimizer from dropping the loops
+
+        size_t scanIters = count >= 10000 ? 200 : QUERIES;
+        double pointScan = nsPerCall(scanIters, [&](size_t i) {
+            for (size_t e = 0; e < count; e++) {
+                if (ex[e] == probes[i].first && ey[e] == probes[i].second) { sink++; break; }
+            }
+        });
+        double pointIndex = nsPerCall(QUERIES, [&](size_t i) {
+            sink += occupancy.occupied(probes[i].first, probes[i].second);
+        });
+        double radiusScan = nsPerCall(scanIters, [&](size_t i) {
+            for (size_t e = 0; e < count; e++) {
+                if (abs(ex[e] - probes[i].first) <= 2 && abs(ey[e] - probes[i].second) <= 2) { sink++; break; }
+            }
+        });
+        double radiusIndex = nsPerCall(QUERIES, [&](size_t i) {
+            sink += occupancy.anyWithin(probes[i].first, probes[i].second, 2);
+        });
+
+        FrameRenderer renderer;
+        double frameUs = nsPerCall(200, [&](size_t) {
+            drawMazeFrame(renderer, sim);
+            renderer.present(nullSink);
+        }) / 1000.0;
+        size_t ticks = count >= 10000 ? 20 : 2000;
+        double tickNs = nsPerCall(ticks, [&](size_t) { sim.moveEnemies(); }) / count;
+
+        printf("%-9zu %14.1f %16.1f %17.1f %18.1f %10.1f %15.1f\n",
+               count, pointScan, pointIndex, radiusScan, radiusIndex, frameUs, tickNs);
+        if (sink == 42) cout << ""; // Use the result
+    }
+}
+
+// FNV-1a over every enemy position: equal checksums mean bit-identical simulations
+template <int W, int H>
+static uint64_t enemyChecksum(const BasicMazeGame<W, H>& sim) {
+    const EnemyStore& enemies = sim.getEnemies();
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < enemies.size(); i++) {
+        h = (h ^ static_cast<uint32_t>(enemies.getX(i))) * 1099511628211ull;
+        h = (h ^ static_cast<uint32_t>(enemies.getY(i))) * 1099511628211ull;
+    }
+    return h;
+}
+
+// Time moveEnemies() for growing populations, single-threaded and on 'threads' threads,
+// under both conflict policies. The checksum column must match across thread counts.
+static void runEnemies(int boardSize, size_t maxEnemies, unsigned threads) {
+    const uint64_t SEED = 2024;
+    cout << "kernel: " << EnemyStore::kernelName() << ", hardware threads: " << thread::hardware_concurrency() << "\n";
+    cout << "policy     enemies   threads   ms/tick   ns/enemy   store(B/enemy)   index(MB)   checksum\n";
+    const EnemyConflictPolicy policies[2] = { ENEMIES_STACK, ENEMIES_EXCLUSIVE };
+    for (EnemyConflictPolicy policy : policies) {
+        for (size_t count = 1000; count <= maxEnemies; count *= 10) {
+            unsigned threadCounts[2] = { 1, threads };
+            for (int t = 0; t < (threads > 1 ? 2 : 1); t++) {
+                MazeSim sim(boardSize, SEED);
+                sim.setThreadCount(threadCounts[t]);
+                sim.setEnemyConflictPolicy(policy);
+                spawnEnemies(sim, count, 4242);
+                size_t ticks = count >= 1000000 ? 10 : 100;
+                sim.moveEnemies(); // Warm-up: sizes the scratch buffers
+                double tickNs = nsPerCall(ticks, [&](size_t) { sim.moveEnemies(); });
+                double bytes = static_cast<double>(sim.getEnemies().memoryBytes()) / count;
+                double indexMb = sim.getOccupancy().memoryBytes() / (1024.0 * 1024.0);
+                printf("%-10s %-9zu %7u %9.3f %10.1f %16.1f %11.1f   %016llx\n",
+                       policy == ENEMIES_STACK ? "stack" : "exclusive", count, threadCounts[t],
+                       tickNs / 1e6, tickNs / count, bytes, indexMb,
+                       static_cast<unsigned long long>(enemyChecksum(sim)));
+            }
+        }
+    }
+}
+
+// Walk a source around the board and keep a FlowField up to date incrementally; compare the
+// cost with rebuilding from scratch and check that both give the same distances.
+static void runFlowField(int boardSize, size_t totalMoves, uint32_t radius) {
+    MazeSim sim(boardSize, 42);
+    const MazeGrid& grid = sim.getGrid();
+    FlowField incremental, full;
+    incremental.setRadius(radius);
+    full.setRadius(radius);
+
+    cout << "board        : " << grid.getRows() << " x " << grid.getCols() << "\n";
+    cout << "radius       : " << (radius ? to_string(radius) : string("unlimited")) << "\n";
+
+    int x = 1, y = 1;
+    auto start = chrono::steady_clock::now();
+    incremental.rebuild(grid, x, y);
+    double rebuildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "first build  : " << rebuildMs << " ms incl. allocation, " << incremental.lastCellsTouched() << " cells\n";
+    full.rebuild(grid, x, y); // Allocate up front so the timed rebuilds below are like-for-like
+
+    static const int DX[4] = { -1, 1, 0, 0 };
+    static const int DY[4] = { 0, 0, -1, 1 };
+    mt19937 gen(7);
+    const size_t checks = 5;
+    size_t touchedTotal = 0, touchedMax = 0, mismatches = 0;
+    double updateMs = 0, worstMs = 0, fullMs = 0;
+    for (size_t m = 1; m <= totalMoves; m++) {
+        int d, nx, ny;
+        do {
+            d = static_cast<int>(gen() & 3);
+            nx = x + DX[d];
+            ny = y + DY[d];
+        } while (grid.isWall(nx, ny));
+        x = nx;
+        y = ny;
+        auto t0 = chrono::steady_clock::now();
+        incremental.moveSource(grid, x, y);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        updateMs += ms;
+        if (ms > worstMs) worstMs = ms;
+        touchedTotal += incremental.lastCellsTouched();
+        if (incremental.lastCellsTouched() > touchedMax) touchedMax = incremental.lastCellsTouched();
+
+        if (m % ((totalMoves + checks - 1) / checks) == 0 || m == totalMoves) {
+            t0 = chrono::steady_clock::now();
+            full.rebuild(grid, x, y);
+            fullMs += chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            for (int i = 0; i < grid.getRows(); i++) {
+                for (int j = 0; j < grid.getCols(); j++) {
+                    if (incremental.distance(i, j) != full.distance(i, j)) mismatches++;
+                }
+            }
+        }
+    }
+    const size_t rebuilds = checks + 1 > totalMoves ? totalMoves : checks + 1;
+    cout << "moves        : " << totalMoves << "\n";
+    cout << "update       : " << updateMs / totalMoves << " ms avg, " << worstMs << " ms worst\n";
+    cout << "cells touched: " << touchedTotal / totalMoves << " avg, " << touchedMax << " max\n";
+    cout << "fallbacks    : " << incremental.fallbackRebuilds() << " repairs replaced by a rebuild\n";
+    cout << "full rebuild : " << fullMs / rebuilds << " ms avg (" << rebuilds << " samples)\n";
+    cout << "field memory : " << incremental.memoryBytes() / (1024.0 * 1024.0) << " MB\n";
+    cout << "verified     : " << (mismatches == 0 ? "matches full rebuild" : to_string(mismatches) + " cells differ") << endl;
+}
+
+// FNV-1a over the grid rows, to show that a seed always gives the same maze
+static uint64_t gridChecksum(const MazeGrid& grid) {
+    uint64_t h = 1469598103934665603ull;
+    for (int i = 0; i < grid.getRows(); i++) {
+        const char* row = grid.row(i);
+        for (int j = 0; j < grid.getCols(); j++) h = (h ^ static_cast<unsigned char>(row[j])) * 1099511628211ull;
+    }
+    return h;
+}
+
+// A maze is perfect when its open squares form a tree: connected, and exactly one fewer
+// 4-neighbour adjacency than open squares
+static bool isPerfect(const MazeGrid& grid) {
+    const int rows = grid.getRows(), cols = grid.getCols();
+    uint64_t open = 0, edges = 0;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (grid.isWall(i, j)) continue;
+            open++;
+            edges += !grid.isWall(i + 1, j);
+            edges += !grid.isWall(i, j + 1);
+        }
+    }
+    if (open == 0 || edges != open - 1) return false;
+    FlowField reach; // BFS from the start; every open square must get a distance
+    reach.rebuild(grid, 1, 1);
+    return reach.lastCellsTouched() == open;
+}
+
+static void runGenerate(int boardSize, const string& which, const string& outFile) {
+    const uint64_t SEED = 2024;
+    vector<MazeAlgorithm> algorithms;
+    MazeAlgorithm one;
+    if (which == "all") algorithms = { MAZE_LATTICE, MAZE_BACKTRACKER, MAZE_WILSON, MAZE_ELLER };
+    else if (parseMazeAlgorithm(which, one)) algorithms.push_back(one);
+    else {
+        cerr << "Unknown algorithm: " << which << " (lattice, backtracker, wilson, eller or all)\n";
+        return;
+    }
+    const double cells = static_cast<double>(boardSize) * boardSize;
+    cout << "board        : " << boardSize << " x " << boardSize << " (seed " << SEED << ")\n";
+    for (MazeAlgorithm algorithm : algorithms) {
+        MazeGrid grid, again;
+        auto start = chrono::steady_clock::now();
+        MazeGenerator::generate(grid, boardSize, boardSize, algorithm, SEED);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        MazeGenerator::generate(again, boardSize, boardSize, algorithm, SEED);
+        bool repeatable = gridChecksum(grid) == gridChecksum(again);
+        again = MazeGrid(); // Free before the perfectness check
+        cout << mazeAlgorithmName(algorithm) << ":\n";
+        cout << "  time        : " << seconds * 1000.0 << " ms\n";
+        cout << "  cells/second: " << cells / seconds / 1e6 << " M\n";
+        cout << "  same seed   : " << (repeatable ? "identical maze" : "DIFFERENT maze") << "\n";
+        cout << "  perfect     : " << (isPerfect(grid) ? "yes" : "no") << endl;
+    }
+
+    if (!outFile.empty()) {
+        // Streaming Eller: one row in memory at a time, written straight to disk
+        FILE* out = fopen(outFile.c_str(), "wb");
+        if (!out) {
+            cerr << "Could not open " << outFile << " for writing\n";
+            return;
+        }
+        EllerRowStream stream(boardSize, boardSize, SEED);
+        vector<char> line(static_cast<size_t>(boardSize) + 1);
+        line[boardSize] = '\n';
+        auto start = chrono::steady_clock::now();
+        while (stream.nextRow(line.data())) fwrite(line.data(), 1, line.size(), out);
+        fclose(out);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double bytes = cells + boardSize;
+        cout << "eller stream -> " << outFile << ":\n";
+        cout << "  time        : " << seconds * 1000.0 << " ms\n";
+        cout << "  cells/second: " << cells / seconds / 1e6 << " M (" << bytes / seconds / (1024.0 * 1024.0) << " MB/s)\n";
+        cout << "  state       : " << (stream.memoryBytes() + line.size()) / 1024.0 << " KB" << endl;
+    }
+}
+
+// Fill the board with enemies and time single placements at increasing fill levels, once
+// through the free-cell index and once the old way (random squares until one is free)
+static void runPlacement(int boardSize) {
+    MazeSim sim(boardSize, 99);
+    const MazeGrid& maze = sim.getGrid();
+    const size_t startFree = sim.getFreeCells().size();
+    cout << "board        : " << boardSize << " x " << boardSize << ", " << startFree << " free squares\n";
+    cout << "full(%)   index(ns/placement)   retry(ns/placement)   retry tries/placement\n";
+    mt19937 gen(5);
+    uniform_int_distribution<int> pos(1, boardSize - 2);
+    const double levels[] = { 0.0, 0.5, 0.9, 0.99, 0.999 };
+    for (double level : levels) {
+        size_t target = static_cast<size_t>(startFree * level);
+        size_t placed = startFree - sim.getFreeCells().size();
+        if (target > placed) sim.spawnEnemies(target - placed);
+        const size_t SAMPLES = 1000;
+        if (sim.getFreeCells().size() < SAMPLES) break;
+
+        // Retry loop: what addCollectibles() used to do (measured without placing anything)
+        size_t tries = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t k = 0; k < SAMPLES; k++) {
+            int x, y;
+            do {
+                x = pos(gen);
+                y = pos(gen);
+                tries++;
+            } while (maze.at(x, y) != ' ' || sim.getOccupancy().occupied(x, y));
+        }
+        double retryNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / SAMPLES;
+
+        start = chrono::steady_clock::now();
+        sim.spawnEnemies(SAMPLES);
+        double indexNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / SAMPLES;
+        printf("%-9.1f %-21.1f %-21.1f %.1f\n", level * 100.0, indexNs, retryNs, static_cast<double>(tries) / SAMPLES);
+    }
+    // Asking for more than fits is refused up front instead of spinning forever
+    string error;
+    bool ok = sim.spawnEnemies(sim.getFreeCells().size() + 1, &error);
+    cout << "overfull     : " << (ok ? "accepted?!" : error) << endl;
+}
+
+static size_t fileBytes(const string& filename) {
+    ifstream file(filename, ios::binary | ios::ate);
+    return file.is_open() ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+// Does 'loaded' hold the same game as 'sim'? (board, player, enemies and stats)
+static bool sameGame(const MazeSim& sim, const MazeSim& loaded) {
+    return gridChecksum(sim.getGrid()) == gridChecksum(loaded.getGrid()) &&
+           enemyChecksum(sim) == enemyChecksum(loaded) && sim.getEnemies().size() == loaded.getEnemies().size() &&
+           sim.getPlayerX() == loaded.getPlayerX() && sim.getPlayerY() == loaded.getPlayerY() &&
+           sim.getScore() == loaded.getScore() && sim.getLevel() == loaded.getLevel() &&
+           sim.getCollectiblesRemaining() == loaded.getCollectiblesRemaining();
+}
+
+// Plain queue BFS from (x, y) over the wall bitmap: the reference the solver is checked against
+static void bfsDistances(const MazeGrid& maze, int x, int y, vector<uint32_t>& dist) {
+    const int cols = maze.getCols();
+    dist.assign(static_cast<size_t>(maze.getRows()) * cols, LevelSolver::UNREACHABLE);
+    vector<uint32_t> queue;
+    queue.reserve(dist.size() / 2);
+    dist[static_cast<size_t>(x) * cols + y] = 0;
+    queue.push_back(static_cast<uint32_t>(x) * cols + y);
+    for (size_t head = 0; head < queue.size(); head++) {
+        const uint32_t cell = queue[head];
+        const int cx = static_cast<int>(cell / cols), cy = static_cast<int>(cell % cols);
+        const int nx[4] = { cx - 1, cx + 1, cx, cx };
+        const int ny[4] = { cy, cy, cy - 1, cy + 1 };
+        for (int k = 0; k < 4; k++) {
+            if (maze.isWall(nx[k], ny[k])) continue;
+            const uint32_t next = static_cast<uint32_t>(nx[k]) * cols + ny[k];
+            if (dist[next] != LevelSolver::UNREACHABLE) continue;
+            dist[next] = dist[cell] + 1;
+            queue.push_back(next);
+        }
+    }
+}
+
+// The level solver's three layers against straightforward versions: the bitset flood fill
+// against a queue BFS, the multi-source BFS against one BFS per point, and the 2-opt route
+// against the exact DP (how far from optimal it lands). Then many levels are generated to
+// count layouts rejected as unsolvable.
+static void runSolver(int boardSize, int maxItems) {
+    const MazeAlgorithm algorithms[] = { MAZE_BACKTRACKER, MAZE_WILSON, MAZE_ELLER, MAZE_LATTICE };
+    LevelSolver solver;
+    vector<uint32_t> dist;
+    cout << "board        : " << boardSize << " x " << boardSize << "\n";
+    printf("%-12s %10s %10s %10s %s\n", "algorithm", "reached", "flood(ms)", "bfs(ms)", "same");
+    for (MazeAlgorithm algorithm : algorithms) {
+        MazeGrid maze;
+        MazeGenerator::generate(maze, boardSize, boardSize, algorithm, 99);
+        maze.set(1, 1, ' ');
+        auto start = chrono::steady_clock::now();
+        const size_t reached = solver.flood(maze, 1, 1).count();
+        const double floodMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        bfsDistances(maze, 1, 1, dist);
+        const double bfsMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        bool same = true;
+        for (int x = 0; x < boardSize; x++) {
+            for (int y = 0; y < boardSize; y++) {
+                same = same && (dist[static_cast<size_t>(x) * boardSize + y] != LevelSolver::UNREACHABLE) == solver.getReachability().reached(x, y);
+            }
+        }
+        printf("%-12s %10zu %10.2f %10.2f %s\n", mazeAlgorithmName(algorithm), reached, floodMs, bfsMs, same ? "yes" : "NO");
+    }
+
+    // Distances and routes on the default (backtracker) maze: start, n random items, exit
+    MazeGrid maze;
+    MazeGenerator::generate(maze, boardSize, boardSize, MAZE_BACKTRACKER, 99);
+    maze.set(1, 1, ' ');
+    SplitMix64 rng(5);
+    printf("%-6s %12s %12s %6s %10s %10s %12s %10s %8s\n", "items", "msbfs(ms)", "bfs x n(ms)", "same",
+           "dp(ms)", "dp moves", "2-opt(ms)", "2-opt", "gap");
+    for (int items : { 4, 8, 12, 16, 32, 64, 128 }) {
+        if (items > maxItems) break;
+        vector<pair<int, int>> points(1, make_pair(1, 1));
+        while (static_cast<int>(points.size()) < items + 1) {
+            const int x = static_cast<int>(rng.below(static_cast<uint32_t>(boardSize)));
+            const int y = static_cast<int>(rng.below(static_cast<uint32_t>(boardSize)));
+            if (!maze.isWall(x, y)) points.push_back(make_pair(x, y));
+        }
+        points.push_back(make_pair(boardSize - 2, boardSize - 2));
+        const size_t count = points.size();
+
+        auto start = chrono::steady_clock::now();
+        const vector<uint32_t> matrix = solver.pairwiseDistances(maze, points);
+        const double msbfsMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        bool same = true;
+        for (size_t i = 0; i < count; i++) {
+            bfsDistances(maze, points[i].first, points[i].second, dist);
+            for (size_t j = 0; j < count; j++) {
+                same = same && matrix[i * count + j] == dist[static_cast<size_t>(points[j].first) * boardSize + points[j].second];
+            }
+        }
+        const double bfsMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        vector<int> route;
+        start = chrono::steady_clock::now();
+        const uint32_t heuristic = LevelSolver::routeHeuristic(matrix, count, route);
+        const double heuristicMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (items <= LevelSolver::EXACT_ITEM_LIMIT) {
+            start = chrono::steady_clock::now();
+            const uint32_t exact = LevelSolver::routeExact(matrix, count, route);
+            const double exactMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            printf("%-6d %12.2f %12.2f %6s %10.3f %10u %12.3f %10u %+7.1f%%\n", items, msbfsMs, bfsMs, same ? "yes" : "NO",
+                   exactMs, exact, heuristicMs, heuristic, (static_cast<double>(heuristic) / exact - 1.0) * 100.0);
+        } else {
+            printf("%-6d %12.2f %12.2f %6s %10s %10s %12.3f %10u %8s\n", items, msbfsMs, bfsMs, same ? "yes" : "NO",
+                   "-", "-", heuristicMs, heuristic, "-");
+        }
+    }
+
+    // Level generation as the game does it: every layout checked, unsolvable ones redrawn
+    const int LEVELS = 20;
+    MazeSim sim(boardSize, 2024);
+    double parTotal = 0;
+    int withPar = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < LEVELS; i++) {
+        sim.resetLevel();
+        if (sim.getParMoves() >= 0) {
+            parTotal += sim.getParMoves();
+            withPar++;
+        }
+    }
+    const double levelMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / LEVELS;
+    cout << "levels       : " << LEVELS << " generated, " << levelMs << " ms each, " << sim.getRejectedLayouts()
+         << " layouts rejected, mean par " << (withPar ? parTotal / withPar : -1.0) << " moves" << endl;
+}
+
+// Save and load the same game through the text and binary formats, report MB/s of each,
+// check both round trips, and make sure damaged binary files are refused
+static void runSave(int boardSize, size_t enemyCount) {
+    MazeSim sim(boardSize, 7);
+    spawnEnemies(sim, enemyCount, 7);
+    const string textFile = "mazebench_save.txt", binaryFile = "mazebench_save.dat";
+    const int RUNS = 3; // Best of 3; files stay in the page cache, so this measures parsing, not the disk
+    cout << "board        : " << boardSize << " x " << boardSize << ", " << sim.getEnemies().size() << " enemies\n";
+    // MB/s are per MB of board (one byte per cell) so both formats are measured against the same work
+    const double boardMb = static_cast<double>(boardSize) * boardSize / (1024.0 * 1024.0);
+    cout << "format   file(MB)   save(ms)   save(MB/s)   load(ms)   load(MB/s)   round trip\n";
+    for (int binary = 0; binary < 2; binary++) {
+        const string& file = binary ? binaryFile : textFile;
+        double saveSeconds = 1e30, loadSeconds = 1e30;
+        bool same = true;
+        for (int run = 0; run < RUNS; run++) {
+            string error;
+            auto start = chrono::steady_clock::now();
+            bool ok = binary ? sim.saveGame(file, &error) : sim.saveGameText(file, &error);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (!ok) { cerr << error << endl; return; }
+            saveSeconds = min(saveSeconds, seconds);
+
+            MazeSim loaded(MIN_MAZE_DIMENSION, 1);
+            start = chrono::steady_clock::now();
+            ok = loaded.loadGame(file, &error);
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (!ok) { cerr << error << endl; return; }
+            loadSeconds = min(loadSeconds, seconds);
+            same = same && sameGame(sim, loaded);
+        }
+        const double mb = fileBytes(file) / (1024.0 * 1024.0);
+        printf("%-8s %-10.2f %-10.2f %-12.1f %-10.2f %-12.1f %s\n", binary ? "binary" : "text", mb,
+               saveSeconds * 1000.0, boardMb / saveSeconds, loadSeconds * 1000.0, boardMb / loadSeconds, same ? "identical" : "DIFFERENT");
+    }
+
+    // One flipped byte in the middle of the wall plane, then a truncated file: both must be refused
+    ifstream in(binaryFile, ios::binary);
+    vector<char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    const string damagedFile = "mazebench_damaged.dat";
+    MazeSim target(MIN_MAZE_DIMENSION, 1);
+    string error;
+    bytes[bytes.size() / 2] ^= 0x10;
+    ofstream(damagedFile, ios::binary).write(bytes.data(), bytes.size());
+    bool flipped = target.loadGame(damagedFile, &error);
+    cout << "flipped byte : " << (flipped ? "accepted?!" : error) << "\n";
+    bytes[bytes.size() / 2] ^= 0x10;
+    ofstream(damagedFile, ios::binary).write(bytes.data(), bytes.size() - 8);
+    bool truncated = target.loadGame(damagedFile, &error);
+    cout << "truncated    : " << (truncated ? "accepted?!" : error) << endl;
+    remove(damagedFile.c_str());
+    remove(textFile.c_str());
+    remove(binaryFile.c_str());
+}
+
+// Play random moves with a save every 'everyMoves' moves, first written synchronously on
+// the game thread (saveGame), then handed to the AutoSaver. Reports what each save costs
+// the game thread, and checks that the background file loads back as the same game.
+static void runAutosave(int boardSize, size_t enemyCount, int everyMoves, size_t steps) {
+    const string file = "mazebench_autosave.dat";
+    mt19937 gen(77);
+    uniform_int_distribution<int> dis(ACTION_UP, ACTION_RIGHT);
+    MazeSim sim(boardSize, 11);
+    spawnEnemies(sim, enemyCount, 11);
+    cout << "board        : " << boardSize << " x " << boardSize << ", " << sim.getEnemies().size()
+         << " enemies, save every " << everyMoves << " moves\n";
+    cout << "mode      saves   game-thread mean(ms)   game-thread max(ms)\n";
+
+    auto play = [&](const char* name, auto save) {
+        size_t saves = 0;
+        double total = 0, worst = 0;
+        for (size_t i = 0; i < steps; i++) {
+            sim.step(static_cast<SimAction>(dis(gen)));
+            if (sim.isGameOver()) sim.newGame();
+            auto start = chrono::steady_clock::now();
+            if (!save()) continue;
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            saves++;
+            total += ms;
+            worst = max(worst, ms);
+        }
+        printf("%-9s %-7zu %-22.4f %.4f\n", name, saves, saves ? total / saves : 0.0, worst);
+    };
+
+    int lastSave = sim.getMoves();
+    play("sync", [&] {
+        if (sim.getMoves() < lastSave) lastSave = sim.getMoves();
+        if (sim.getMoves() - lastSave < everyMoves) return false;
+        lastSave = sim.getMoves();
+        return sim.saveGame(file);
+    });
+    AutoSaver saver(file, everyMoves, 0);
+    play("async", [&] { return saver.poll(sim); });
+    saver.flush();
+    // The snapshot alone, without the hand-off (on a single core the woken writer can
+    // pre-empt the game thread inside poll(), which shows up in the async max above)
+    const int SNAPSHOTS = 20;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < SNAPSHOTS; i++) {
+        SaveSnapshot snap = sim.snapshot();
+    }
+    cout << "snapshot     : " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / SNAPSHOTS
+         << " ms\n";
+    AutoSaver::Stats stats = saver.getStats();
+    cout << "writer       : " << stats.written << " written, " << stats.superseded << " superseded, "
+         << stats.failed << " failed, last write " << stats.lastWriteSeconds * 1000.0 << " ms (off the game thread)\n";
+
+    // The final state through the background writer must load back unchanged
+    saver.submit(sim.snapshot(), file);
+    saver.flush();
+    MazeSim loaded(MIN_MAZE_DIMENSION, 1);
+    string error;
+    bool ok = loaded.loadGame(file, &error);
+    cout << "round trip   : " << (!ok ? error : sameGame(sim, loaded) ? "identical" : "DIFFERENT") << endl;
+    remove(file.c_str());
+}
+
+// Everything that decides how a game continues, folded into one value
+template <int W, int H>
+static uint64_t stateChecksum(const BasicMazeGame<W, H>& sim) {
+    uint64_t h = gridChecksum(sim.getGrid()) ^ enemyChecksum(sim);
+    const uint64_t fields[] = { static_cast<uint64_t>(sim.getPlayerX()), static_cast<uint64_t>(sim.getPlayerY()),
+                                static_cast<uint64_t>(sim.getScore()), static_cast<uint64_t>(sim.getMoves()),
+                                static_cast<uint64_t>(sim.getLevel()), sim.getTick() };
+    for (uint64_t f : fields) h = mix64(h ^ f);
+    return h;
+}
+
+// N games stepped together with an observation per game per step, three ways: one
+// separately allocated MazeSim per agent stepped in a loop (the way a bot harness would do
+// it without VecEnv), VecEnv on one thread and VecEnv on 'threads'. The VecEnv runs must
+// produce identical observations/rewards (checksum), whatever the thread count.
+static void runVecEnv(size_t games, int boardSize, unsigned threads, size_t totalSteps) {
+    const size_t rounds = (totalSteps + games - 1) / games;
+    const size_t ACTION_ROUNDS = 256;
+    mt19937 gen(777);
+    vector<SimAction> actions(games * ACTION_ROUNDS);
+    for (SimAction& a : actions) a = static_cast<SimAction>(ACTION_UP + gen() % 4);
+    vector<int32_t> rewards(games);
+    vector<unsigned char> dones(games);
+
+    cout << "games        : " << games << " x " << boardSize << " x " << boardSize << ", " << rounds
+         << " steps each\n";
+    {
+        vector<unique_ptr<MazeSim>> sims;
+        for (size_t i = 0; i < games; i++) sims.emplace_back(new MazeSim(boardSize, 1000 + i));
+        const size_t words = OBS_PLANES * static_cast<size_t>(sims[0]->getGrid().getRows()) * sims[0]->getGrid().getWordsPerRow();
+        vector<uint64_t> obs(games * words);
+        size_t episodes = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; r++) {
+            const SimAction* roundActions = &actions[(r % ACTION_ROUNDS) * games];
+            for (size_t i = 0; i < games; i++) {
+                const int before = sims[i]->getScore();
+                sims[i]->step(roundActions[i]);
+                rewards[i] = sims[i]->getScore() - before;
+                dones[i] = sims[i]->isGameOver();
+                if (dones[i]) {
+                    sims[i]->newGame(mix64(1000 + i + ++episodes));
+                }
+                VecEnv::writeObservation(*sims[i], &obs[i * words]);
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("%-22s %14.0f env steps/s  (%zu episodes)\n", "separate MazeSims", rounds * games / seconds, episodes);
+    }
+
+    vector<unsigned> threadCounts = { 1 };
+    if (threads > 1) threadCounts.push_back(threads);
+    uint64_t firstChecksum = 0;
+    size_t observationBytes = 0;
+    for (unsigned t : threadCounts) {
+        VecEnv envs(games, boardSize, 2024, t);
+        vector<uint64_t> obs(games * envs.observationWords());
+        observationBytes = envs.observationWords() * sizeof(uint64_t);
+        envs.reset(obs.data());
+        uint64_t checksum = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; r++) {
+            envs.step(&actions[(r % ACTION_ROUNDS) * games], obs.data(), rewards.data(), dones.data());
+            // Fold a slice of the output in so the checksum sees every game without costing much
+            const size_t g = r % games;
+            checksum = mix64(checksum ^ obs[g * envs.observationWords() + (r % envs.observationWords())] ^
+                             (static_cast<uint64_t>(rewards[g]) << 8) ^ dones[g]);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        for (size_t i = 0; i < games; i++) checksum = mix64(checksum ^ stateChecksum(envs.game(i)));
+        if (t == threadCounts[0]) firstChecksum = checksum;
+        char label[32];
+        snprintf(label, sizeof(label), "VecEnv, %u thread%s", t, t == 1 ? "" : "s");
+        printf("%-22s %14.0f env steps/s  (%llu episodes)  checksum %016llx%s\n", label,
+               envs.getTotalSteps() / seconds, static_cast<unsigned long long>(envs.getTotalEpisodes()),
+               static_cast<unsigned long long>(checksum), checksum == firstChecksum ? "" : "  MISMATCH");
+    }
+    cout << "observation  : " << OBS_PLANES << " bit-planes, " << observationBytes << " bytes per game per step" << endl;
+}
+
+// 'Game' through 'totalSteps' random moves, a caught player starting a new game under the next
+// seed, then 'newGames' fresh games on their own. Returns a checksum over the state at every
+// game's end, so two game types that play identically return the same value.
+template <class Game>
+static uint64_t playFixedBench(MazeAlgorithm algorithm, const vector<SimAction>& actions, size_t totalSteps,
+                               size_t newGames, double& stepsPerSecond, double& newGameUs) {
+    unique_ptr<Game> sim(new Game(MAZE_DIMENSION, 4242));
+    sim->setMazeAlgorithm(algorithm);
+    sim->newGame(4242);
+    uint64_t checksum = 0, seed = 4242;
+    size_t done = 0;
+    vector<unsigned> events(actions.size());
+    auto start = chrono::steady_clock::now();
+    while (done < totalSteps) {
+        const size_t offset = done % actions.size();
+        const size_t want = totalSteps - done < actions.size() - offset ? totalSteps - done : actions.size() - offset;
+        done += sim->step_n(actions.data() + offset, want, events.data());
+        if (sim->isGameOver()) {
+            checksum = mix64(checksum ^ stateChecksum(*sim));
+            sim->newGame(++seed);
+        }
+    }
+    stepsPerSecond = done / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    checksum = mix64(checksum ^ stateChecksum(*sim));
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < newGames; i++) {
+        sim->newGame(++seed);
+        checksum = mix64(checksum ^ stateChecksum(*sim));
+    }
+    newGameUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / newGames;
+    return checksum;
+}
+
+// The classic board as a compile-time size (ClassicMazeSim) against the same board sized at
+// runtime (MazeSim), one generator at a time: stepping throughput through step_n() with
+// the usual wandering enemies, and the cost of setting up a new game. Both must play the
+// same games (checksum).
+static void runFixed(size_t steps, size_t newGames) {
+    mt19937 gen(99);
+    vector<SimAction> actions(1 << 16);
+    for (SimAction& a : actions) a = static_cast<SimAction>(ACTION_UP + gen() % 4);
+
+    printf("board %d x %d, %zu steps, %zu new games per run\n", MAZE_DIMENSION, MAZE_DIMENSION, steps, newGames);
+    printf("%-12s %15s %15s %8s %13s %13s  %s\n", "algorithm", "dynamic st/s", "fixed st/s", "speedup",
+           "dyn newGame", "fixed newGame", "same games");
+    const MazeAlgorithm algorithms[] = { MAZE_LATTICE, MAZE_BACKTRACKER, MAZE_WILSON, MAZE_ELLER };
+    for (MazeAlgorithm algorithm : algorithms) {
+        double dynamicRate, fixedRate, dynamicUs, fixedUs;
+        const uint64_t dynamicSum = playFixedBench<MazeSim>(algorithm, actions, steps, newGames, dynamicRate, dynamicUs);
+        const uint64_t fixedSum = playFixedBench<ClassicMazeSim>(algorithm, actions, steps, newGames, fixedRate, fixedUs);
+        printf("%-12s %15.0f %15.0f %7.2fx %10.2f us %10.2f us  %s\n", mazeAlgorithmName(algorithm), dynamicRate,
+               fixedRate, fixedRate / dynamicRate, dynamicUs, fixedUs, dynamicSum == fixedSum ? "yes" : "NO - MISMATCH");
+    }
+}
+
+// A bot that finishes levels: heads for the nearest item, or for the exit once every item
+// is taken. The route to the current target is kept until the target is gone.
+struct LevelBot {
+    vector<uint32_t> dist; // Distance to the target, per square
+    int targetX = -1, targetY = -1; // -1: pick a target on the next move (new board)
+
+    SimAction move(const MazeSim& sim) {
+        const MazeGrid& maze = sim.getGrid();
+        const int cols = maze.getCols();
+        const int px = sim.getPlayerX(), py = sim.getPlayerY();
+        if (maze.get(targetX, targetY) != '*' && maze.get(targetX, targetY) != 'E') {
+            const vector<int32_t>& items = sim.getItemSquares();
+            targetX = targetY = sim.getDimension() - 2;
+            if (!items.empty()) {
+                bfsDistances(maze, px, py, dist);
+                uint32_t best = LevelSolver::UNREACHABLE;
+                for (size_t k = 0; k < items.size(); k += 2) {
+                    const uint32_t d = dist[static_cast<size_t>(items[k]) * cols + items[k + 1]];
+                    if (d < best) { best = d; targetX = items[k]; targetY = items[k + 1]; }
+                }
+            }
+            bfsDistances(maze, targetX, targetY, dist);
+        }
+        // Walk down the target's distance field
+        const int nx[4] = { px - 1, px + 1, px, px };
+        const int ny[4] = { py, py, py - 1, py + 1 };
+        const SimAction towards[4] = { ACTION_UP, ACTION_DOWN, ACTION_LEFT, ACTION_RIGHT };
+        const uint32_t here = dist[static_cast<size_t>(px) * cols + py];
+        for (int k = 0; k < 4; k++) {
+            if (!maze.isWall(nx[k], ny[k]) && dist[static_cast<size_t>(nx[k]) * cols + ny[k]] < here) return towards[k];
+        }
+        targetX = targetY = -1; // Unreachable (a layout kept as a last resort): pick again next move
+        return ACTION_UP;
+    }
+};
+
+// Level transitions with and without background pregeneration. A bot plays 'levels' levels
+// (a caught bot starts a new game), "thinking" for 'thinkMs' on each level before its last
+// move, like a player who needs a moment; the move that finishes a level is timed, since it
+// carries the whole level change. Both runs make the same moves and must end in the same
+// state: a pregenerated level is the same level.
+static void runPregen(int boardSize, int levels, size_t depth, double thinkMs) {
+    cout << "board        : " << boardSize << " x " << boardSize << ", " << levels << " levels, think "
+         << thinkMs << " ms per level" << endl;
+    const size_t runs[2] = { 0, depth };
+    uint64_t firstChecksum = 0;
+    for (size_t run = 0; run < 2; run++) {
+        MazeSim sim(boardSize, 4242);
+        sim.setPregenerateDepth(runs[run]);
+        LatencyHistogram transition; // ns
+        vector<size_t> queueDepths(depth + 2, 0);
+        LevelBot bot;
+        int completed = 0, games = 1;
+        uint64_t checksum = 0;
+        while (completed < levels) {
+            const SimAction action = bot.move(sim);
+            // The next move finishes the level when it lands on the exit with nothing left
+            const int dim = sim.getDimension();
+            const int nextX = sim.getPlayerX() + (action == ACTION_UP ? -1 : action == ACTION_DOWN ? 1 : 0);
+            const int nextY = sim.getPlayerY() + (action == ACTION_LEFT ? -1 : action == ACTION_RIGHT ? 1 : 0);
+            const bool finishing = sim.getCollectiblesRemaining() == 0 && nextX == dim - 2 && nextY == dim - 2;
+            if (finishing) {
+                this_thread::sleep_for(chrono::duration<double, milli>(thinkMs));
+                const LevelPipeline* pipeline = sim.getPipeline();
+                if (pipeline) queueDepths[min(pipeline->readyCount(), queueDepths.size() - 1)]++;
+            }
+            auto start = chrono::steady_clock::now();
+            const unsigned events = sim.step(action);
+            const uint64_t ns = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+            if (events & EVENT_LEVEL_COMPLETE) {
+                transition.record(ns);
+                completed++;
+                checksum = mix64(checksum ^ stateChecksum(sim));
+                bot.targetX = bot.targetY = -1; // New board
+            }
+            if (sim.isGameOver()) {
+                sim.newGame(4242 + static_cast<uint64_t>(games++));
+                bot.targetX = bot.targetY = -1;
+            }
+        }
+        if (run == 0) firstChecksum = checksum;
+        char label[32];
+        snprintf(label, sizeof(label), runs[run] ? "pregenerated (%zu)" : "on the spot", runs[run]);
+        printf("%-18s: p50 %.3f  p99 %.3f  max %.3f  mean %.3f ms per level change (%d games)\n", label,
+               transition.percentile(0.5) / 1e6, transition.percentile(0.99) / 1e6, transition.max() / 1e6,
+               transition.mean() / 1e6, games);
+        if (const LevelPipeline* pipeline = sim.getPipeline()) {
+            printf("%-18s: %llu ready, %llu waited for, %llu missed; %.3f ms per build on the worker\n", "pipeline",
+                   static_cast<unsigned long long>(pipeline->getHits()), static_cast<unsigned long long>(pipeline->getWaits()),
+                   static_cast<unsigned long long>(pipeline->getMisses()), pipeline->meanBuildMs());
+            printf("%-18s:", "queue depth");
+            for (size_t d = 0; d < queueDepths.size(); d++) {
+                printf(" %s%zu: %zu", d + 1 == queueDepths.size() ? ">=" : "", d, queueDepths[d]);
+            }
+            printf("  (levels ready at each change)\n");
+        }
+        printf("%-18s: %016llx%s\n", "checksum", static_cast<unsigned long long>(checksum),
+               checksum == firstChecksum ? "" : "  MISMATCH");
+    }
+}
+
+// Play 'steps' random moves and record them. The walker avoids squares next to an enemy,
+// but if it is caught anyway the recording stops there, like the console game. With 'chase' the enemies hunt the player, so the flow field is exercised too.
+// State plus the free-square count, so a history that left the free-cell index out of step
+// shows up too
+static uint64_t undoCheck(const MazeSim& sim) {
+    return mix64(stateChecksum(sim) ^ sim.getFreeCells().size());
+}
+
+static void printNs(const char* name, const LatencyHistogram& h) {
+    printf("%-14s: p50 %.2f  p99 %.2f  max %.1f  mean %.2f us (%llu)\n", name, h.percentile(0.5) / 1000.0,
+           h.percentile(0.99) / 1000.0, h.max() / 1000.0, h.mean() / 1000.0, static_cast<unsigned long long>(h.count()));
+}
+
+// Undo history on a big board. A bot plays 'steps' steps with all of them kept (a step that
+// gets the player caught is undone and a random move tried instead), then the whole run is
+// undone step by step and redone again, checking the state against checkpoints taken on
+// the way. Memory per step and undo/redo latency are set against the alternatives: a full
+// snapshot per step, restoring one, and loading a save from disk.
+static void runUndo(int boardSize, size_t steps, size_t enemyCount) {
+    MazeSim sim(boardSize, 31337);
+    spawnEnemies(sim, enemyCount, 5);
+    sim.setUndoDepth(steps);
+    const size_t CHECK_EVERY = steps / 64 + 1;
+    vector<uint64_t> checks(1, undoCheck(sim)); // State after every CHECK_EVERY steps
+    LevelBot bot;
+    mt19937 gen(3);
+    LatencyHistogram stepNs, undoNs, redoNs;
+    size_t done = 0, retries = 0, levels = 0, caughtStreak = 0;
+    bool randomMove = false;
+    while (done < steps) {
+        const SimAction action = randomMove ? static_cast<SimAction>(ACTION_UP + gen() % 4) : bot.move(sim);
+        randomMove = false;
+        auto start = chrono::steady_clock::now();
+        const unsigned events = sim.step(action);
+        stepNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()));
+        if (!(events & EVENT_MOVED)) {
+            randomMove = true;
+            continue;
+        }
+        if (events & EVENT_CAUGHT) {
+            sim.undo();
+            retries++;
+            randomMove = true;
+            // Enemies camping on the only way on: give up rather than loop forever
+            if (++caughtStreak == 64) break;
+            continue;
+        }
+        if (events & EVENT_LEVEL_COMPLETE) {
+            levels++;
+            bot.targetX = bot.targetY = -1; // New board
+        }
+        if (++done % CHECK_EVERY == 0) checks.push_back(undoCheck(sim));
+        caughtStreak = 0;
+    }
+    const uint64_t finalState = undoCheck(sim);
+    const UndoHistory& history = sim.getHistory();
+    // Slots the ring has not used yet are left out, so a run that ended early isn't flattered
+    const size_t historyBytes = history.memoryBytes() - (history.getCapacity() - history.undoCount()) * sizeof(UndoRecord);
+    const double bytesPerStep = static_cast<double>(historyBytes) / history.undoCount();
+    cout << "board         : " << boardSize << " x " << boardSize << ", " << sim.getEnemies().size() << " enemies, "
+         << done << " steps kept (" << levels << " levels finished, " << retries << " caught moves undone and retried"
+         << (done < steps ? "; boxed in by enemies, run ended early" : "") << ")\n";
+    printNs("step", stepNs);
+    printf("%-14s: %.2f MB for %zu steps, %.1f bytes per step\n", "history", historyBytes / (1024.0 * 1024.0),
+           history.undoCount(), bytesPerStep);
+
+    size_t mismatches = 0;
+    for (size_t k = done; k > 0; k--) {
+        auto start = chrono::steady_clock::now();
+        sim.undo();
+        undoNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()));
+        if ((k - 1) % CHECK_EVERY == 0 && undoCheck(sim) != checks[(k - 1) / CHECK_EVERY]) mismatches++;
+    }
+    const bool undoneAll = !sim.canUndo();
+    for (size_t k = 1; k <= done; k++) {
+        auto start = chrono::steady_clock::now();
+        sim.redo();
+        redoNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()));
+        if (k % CHECK_EVERY == 0 && undoCheck(sim) != checks[k / CHECK_EVERY]) mismatches++;
+    }
+    printNs("undo", undoNs);
+    printNs("redo", redoNs);
+    cout << "verified      : " << (mismatches == 0 && undoneAll && undoCheck(sim) == finalState
+                                       ? "every checkpoint matches going back and forward again"
+                                       : to_string(mismatches) + " checkpoints DIFFER") << "\n";
+
+    // What keeping a whole snapshot per step would cost instead
+    const SaveSnapshot snap = sim.snapshot();
+    const size_t snapshotBytes = sizeof(SaveSnapshot) +
+                                 (snap.items.capacity() + snap.enemyXs.capacity() + snap.enemyYs.capacity()) * sizeof(int32_t);
+    LatencyHistogram restoreNs;
+    for (int i = 0; i < 20; i++) {
+        auto start = chrono::steady_clock::now();
+        sim.restore(snap);
+        restoreNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()));
+    }
+    printf("%-14s: %.1f bytes per step with the wall plane shared (%.1fx the history)\n", "snapshot/step",
+           static_cast<double>(snapshotBytes), snapshotBytes / bytesPerStep);
+    printNs("restore", restoreNs);
+    const string filename = "maze_bench_undo.dat";
+    if (sim.saveGame(filename)) {
+        auto start = chrono::steady_clock::now();
+        sim.loadGame(filename);
+        printf("%-14s: %.1f us (%zu bytes)\n", "loadGame", chrono::duration<double, micro>(chrono::steady_clock::now() - start).count(),
+               fileBytes(filename));
+        remove(filename.c_str());
+    }
+}
+
+static void runRecord(int boardSize, size_t steps, size_t enemyCount, const string& logFile, bool chase) {
+    MazeSim sim(boardSize, 2024);
+    if (chase) {
+        sim.setChaseRadius(16); // Far-away enemies wander, or a random walker is caught at once
+        sim.setEnemyBehavior(ENEMIES_CHASE);
+    }
+    sim.removeAllEnemies(); // The starting enemy sits next to the start and would end the walk early
+    spawnEnemies(sim, enemyCount, 3);
+    InputRecorder recorder;
+    string error;
+    if (!recorder.start(logFile, sim, &error)) {
+        cerr << error << endl;
+        return;
+    }
+    mt19937 gen(99);
+    uniform_int_distribution<int> dis(ACTION_UP, ACTION_RIGHT);
+    size_t levels = 0;
+    const int dx[] = { 0, -1, 1, 0, 0 }, dy[] = { 0, 0, 0, -1, 1 }; // Indexed by SimAction
+    for (size_t i = 0; i < steps && !sim.isGameOver(); i++) {
+        SimAction action = static_cast<SimAction>(dis(gen));
+        for (int k = 0; k < 4; k++) {
+            SimAction a = static_cast<SimAction>(ACTION_UP + (action - ACTION_UP + k) % 4);
+            int x = sim.getPlayerX() + dx[a], y = sim.getPlayerY() + dy[a];
+            if (!sim.getGrid().isWall(x, y) && !sim.getOccupancy().anyWithin(x, y, 1)) {
+                action = a;
+                break;
+            }
+        }
+        recorder.record(action);
+        if (sim.step(action) & EVENT_LEVEL_COMPLETE) levels++;
+    }
+    recorder.stop();
+    const size_t recorded = static_cast<size_t>(recorder.actionCount());
+    cout << "recorded     : " << recorded << " actions" << (sim.isGameOver() ? " (caught)" : "") << ", " << levels
+         << " levels -> " << logFile << "\n";
+    cout << "log size     : " << fileBytes(logFile) << " bytes (" << (recorded + 3) / 4 << " bytes of actions)\n";
+    cout << "final state  : " << hex << stateChecksum(sim) << dec << endl;
+}
+
+// Replay a log at full speed, then jump around it: every seek goes through the nearest
+// keyframe and must land on the same state as a straight run from the start
+static void runReplay(const string& logFile, long long stopAt) {
+    ReplayPlayer replay;
+    string error;
+    if (!replay.open(logFile, &error)) {
+        cerr << error << endl;
+        return;
+    }
+    MazeSim& sim = replay.getSim();
+    const uint64_t total = replay.actionCount();
+    cout << "log          : " << logFile << ", " << total << " actions, seed " << replay.getHeader().seed << ", board "
+         << sim.getDimension() << " x " << sim.getDimension() << ", " << sim.getEnemies().size() << " enemies\n";
+    if (stopAt >= 0) {
+        replay.seek(static_cast<uint64_t>(stopAt));
+        cout << "at step " << replay.getPosition() << ": level " << sim.getLevel() << ", score " << sim.getScore()
+             << ", player (" << sim.getPlayerX() << ", " << sim.getPlayerY() << ")" << (sim.isGameOver() ? ", caught" : "")
+             << ", state " << hex << stateChecksum(sim) << dec << endl;
+        return;
+    }
+
+    auto start = chrono::steady_clock::now();
+    replay.run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "full replay  : " << seconds * 1000.0 << " ms (" << total / seconds << " steps/second), "
+         << replay.keyframeCount() << " keyframes\n";
+    cout << "final state  : " << hex << stateChecksum(sim) << dec << "\n";
+    if (total == 0) return;
+
+    // Reference: the same targets reached by re-simulating from step 0 every time
+    ReplayPlayer straight;
+    straight.open(logFile);
+    straight.setKeyframeInterval(0);
+    mt19937_64 gen(1);
+    const int SEEKS = 10;
+    double seekMs = 0, straightMs = 0;
+    int mismatches = 0;
+    for (int i = 0; i < SEEKS; i++) {
+        uint64_t target = gen() % (total + 1);
+        start = chrono::steady_clock::now();
+        replay.seek(target);
+        seekMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        straight.seek(0);
+        straight.seek(target);
+        straightMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (stateChecksum(sim) != stateChecksum(straight.getSim())) mismatches++;
+    }
+    cout << "seek         : " << seekMs / SEEKS << " ms per jump via keyframes, " << straightMs / SEEKS
+         << " ms re-simulating from the start\n";
+    cout << "verified     : " << (mismatches == 0 ? "every jump matches a straight run" : to_string(mismatches) + " jumps differ")
+         << endl;
+}
+
+// Real-time mode for 'seconds' seconds: 60 Hz sim clock, enemies at 'enemyHz', 60 Hz frames.
+// This thread plays the input thread, pressing random keys 'keysPerSecond' times a second.
+// 'renderCostMs' of busy work per presented frame stands in for a slow terminal, and a big
+// board with many enemies loads the sim thread. Reports tick jitter, input-to-render latency
+// and dropped frames, then replays the session's log and checks it ends in the same state.
+static void printTiming(const char* name, const TimingStats& t) {
+    printf("%-13s: p50 %.3f  p99 %.3f  max %.3f  mean %.3f ms (%llu samples)\n", name, t.percentile(0.5),
+           t.percentile(0.99), t.max(), t.mean(), static_cast<unsigned long long>(t.count()));
+}
+
+static void runRealTime(int boardSize, size_t enemyCount, double enemyHz, double seconds, double keysPerSecond,
+                        double renderCostMs) {
+    const string logFile = "mazebench_realtime.rec";
+    MazeSim sim(boardSize, 2024);
+    sim.removeAllEnemies();
+    spawnEnemies(sim, enemyCount, 3);
+    sim.setTurnBased(false);
+    InputRecorder recorder;
+    string error;
+    if (!recorder.start(logFile, sim, &error)) {
+        cerr << error << endl;
+        return;
+    }
+    // The bench keeps going after a catch (steps become no-ops) so the timing covers the whole run
+    auto onKey = [&](char key) {
+        const SimAction action = actionFromKey(key);
+        recorder.record(action);
+        sim.step(action);
+        return true;
+    };
+    auto onEnemyStep = [&]() {
+        recorder.recordEnemyStep();
+        sim.tickEnemies();
+        return true;
+    };
+    FrameRenderer renderer;
+    auto onDraw = [&](FrameRenderer& frame) { drawMazeFrame(frame, sim); };
+    auto slowSink = [renderCostMs](const char*, size_t) {
+        const auto until = chrono::steady_clock::now() + chrono::duration<double, milli>(renderCostMs);
+        while (chrono::steady_clock::now() < until) {
+        }
+    };
+
+    RealTimeLoop loop(60.0, enemyHz, 60.0);
+    cout << "board        : " << boardSize << " x " << boardSize << ", " << sim.getEnemies().size() << " enemies, "
+         << enemyHz << " enemy steps/s, " << keysPerSecond << " keys/s, " << renderCostMs << " ms per frame\n";
+    loop.start(onKey, onEnemyStep, onDraw, renderer, slowSink);
+    mt19937 gen(5);
+    const char keys[] = { 'w', 'a', 's', 'd' };
+    const auto begin = chrono::steady_clock::now();
+    const auto keyPeriod = chrono::duration<double>(1.0 / keysPerSecond);
+    for (size_t i = 1; chrono::steady_clock::now() - begin < chrono::duration<double>(seconds); i++) {
+        loop.pushInput(keys[gen() % 4]);
+        this_thread::sleep_until(begin + chrono::duration_cast<chrono::steady_clock::duration>(keyPeriod * i));
+    }
+    loop.stop();
+    recorder.stop();
+
+    const RealTimeLoop::Stats& stats = loop.getStats();
+    cout << "ticks        : " << stats.ticks << " (" << stats.lateTicks << " late, " << stats.skippedTicks
+         << " skipped), " << stats.enemySteps << " enemy steps, " << stats.keys << " keys (" << stats.keysDropped
+         << " dropped)\n";
+    cout << "frames       : " << stats.frames << " presented, " << stats.framesDropped << " dropped\n";
+    printTiming("tick jitter", stats.tickJitter);
+    printTiming("tick work", stats.tickWork);
+    printTiming("frame work", stats.frameWork);
+    printTiming("input->frame", stats.inputLatency);
+
+    ReplayPlayer replay;
+    if (!replay.open(logFile, &error)) {
+        cerr << error << endl;
+        return;
+    }
+    replay.run();
+    cout << "replay       : " << replay.actionCount() << " entries, "
+         << (stateChecksum(replay.getSim()) == stateChecksum(sim) ? "same final state" : "DIFFERENT final state")
+         << (sim.isGameOver() ? " (caught)" : "") << endl;
+    remove(logFile.c_str());
+}
+
+// --- Benchmark suite ---
+// Times the game's hot functions one at a time across board sizes and enemy counts and
+// writes the results as JSON, one result per line, so runs from different commits can be
+// diffed or checked with "MazeBench compare".
+
+struct SuiteResult {
+    string name;
+    int size;
+    size_t enemies;
+    double medianNs, minNs; // Per call
+    size_t samples, callsPerSample;
+};
+
+static double medianOf(vector<double> values) {
+    sort(values.begin(), values.end());
+    const size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+// Cheap calls: each sample times a batch of calls, sized so a sample takes at least
+// 'sampleMs'. Expensive calls get one call per sample and fewer samples.
+template <typename Fn>
+static void timeBatched(SuiteResult& result, double sampleMs, size_t maxSamples, Fn fn) {
+    size_t batch = 1;
+    double ms = 0;
+    for (;;) {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < batch; i++) fn();
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (ms >= sampleMs || batch >= (size_t(1) << 24)) break;
+        batch = ms <= 0 ? batch * 16 : max(batch * 2, static_cast<size_t>(batch * sampleMs / ms) + 1);
+    }
+    size_t samples = ms >= sampleMs * 4 ? max<size_t>(3, maxSamples / 3) : maxSamples;
+    vector<double> ns;
+    for (size_t s = 0; s < samples; s++) {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < batch; i++) fn();
+        ns.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / batch);
+    }
+    result.medianNs = medianOf(ns);
+    result.minNs = *min_element(ns.begin(), ns.end());
+    result.samples = samples;
+    result.callsPerSample = batch;
+}
+
+// Calls that need fresh state every time: setup() runs untimed before each timed call.
+// Sampling stops after 'totalMs' of wall time, setup included (at least 3 samples).
+template <typename Setup, typename Fn>
+static void timeWithSetup(SuiteResult& result, double totalMs, size_t maxSamples, Setup setup, Fn fn) {
+    vector<double> ns;
+    const auto begin = chrono::steady_clock::now();
+    while (ns.size() < maxSamples &&
+           (ns.size() < 3 || chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count() < totalMs)) {
+        setup();
+        auto start = chrono::steady_clock::now();
+        fn();
+        ns.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+    }
+    result.medianNs = medianOf(ns);
+    result.minNs = *min_element(ns.begin(), ns.end());
+    result.samples = ns.size();
+    result.callsPerSample = 1;
+}
+
+static unique_ptr<MazeSim> suiteSim(int size, size_t enemies) {
+    unique_ptr<MazeSim> sim(new MazeSim(size, 2024));
+    sim->removeAllEnemies();
+    spawnEnemies(*sim, enemies, 3);
+    return sim;
+}
+
+static string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+static void runSuite(const string& outFile, bool quick) {
+    const vector<int> sizes = quick ? vector<int>{ 11, 101, 1001 } : vector<int>{ 11, 101, 1001, 4001 };
+    const vector<size_t> enemyCounts = { 1, 100, 10000 };
+    const double sampleMs = quick ? 1.0 : 5.0;
+    const size_t maxSamples = quick ? 5 : 15;
+    const string saveFile = "mazebench_suite.dat";
+    mt19937 gen(42);
+    vector<SimAction> actions(4096);
+    for (SimAction& a : actions) a = static_cast<SimAction>(ACTION_UP + gen() % 4);
+
+    vector<SuiteResult> results;
+    printf("%-15s %6s %8s %14s %14s %8s\n", "function", "size", "enemies", "median(ns)", "min(ns)", "samples");
+    auto report = [&](SuiteResult& r) {
+        printf("%-15s %6d %8zu %14.1f %14.1f %8zu\n", r.name.c_str(), r.size, r.enemies, r.medianNs, r.minNs, r.samples);
+        fflush(stdout);
+        results.push_back(r);
+    };
+
+    for (int size : sizes) {
+        for (size_t enemies : enemyCounts) {
+            auto make = [&](const char* name) { return SuiteResult{ name, size, enemies, 0, 0, 0, 0 }; };
+            {
+                // The player's move on its own: enemies only move when told to
+                SuiteResult r = make("movePlayer");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                sim->setTurnBased(false);
+                size_t i = 0;
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->movePlayer(actions[i++ & 4095]); });
+                report(r);
+            }
+            {
+                SuiteResult r = make("moveEnemies");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->moveEnemies(); });
+                report(r);
+            }
+            {
+                SuiteResult r = make("checkGameState");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->checkGameState(); });
+                report(r);
+            }
+            {
+                // A frame after every move, so each one has something to diff
+                SuiteResult r = make("display");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                FrameRenderer renderer;
+                size_t i = 0;
+                auto move = [&] {
+                    sim->step(actions[i++ & 4095]);
+                    if (sim->isGameOver()) sim->newGame();
+                };
+                timeWithSetup(r, sampleMs * maxSamples, 2000, move, [&] {
+                    drawMazeFrame(renderer, *sim);
+                    renderer.present(nullSink);
+                });
+                report(r);
+            }
+            {
+                SuiteResult r = make("addCollectibles");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeWithSetup(r, sampleMs * maxSamples, 2000, [&] { sim->initializeMaze(); }, [&] { sim->addCollectibles(); });
+                report(r);
+            }
+            {
+                SuiteResult r = make("initializeMaze");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->initializeMaze(); });
+                report(r);
+            }
+            {
+                SuiteResult r = make("resetLevel");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->resetLevel(); });
+                report(r);
+            }
+            {
+                SuiteResult r = make("solveLevel");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->solveLevel(); });
+                report(r);
+            }
+            {
+                SuiteResult r = make("saveGame");
+                unique_ptr<MazeSim> sim = suiteSim(size, enemies);
+                timeBatched(r, sampleMs, maxSamples, [&] { sim->saveGame(saveFile); });
+                report(r);
+                r = make("loadGame");
+                MazeSim loaded(MIN_MAZE_DIMENSION, 1);
+                timeBatched(r, sampleMs, maxSamples, [&] { loaded.loadGame(saveFile); });
+                report(r);
+            }
+        }
+    }
+    remove(saveFile.c_str());
+
+    ofstream out(outFile);
+    if (!out.is_open()) {
+        cerr << "Could not open " << outFile << " for writing" << endl;
+        return;
+    }
+    const char* commit = getenv("MAZEBENCH_COMMIT");
+    const time_t now = time(0);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+#if defined(__clang__)
+    const string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    const string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    const string compiler = "MSVC " + to_string(_MSC_VER);
+#else
+    const string compiler = "unknown";
+#endif
+    out << "{\n";
+    out << "  \"benchmark\": \"MazeBench suite\",\n";
+    out << "  \"commit\": \"" << jsonEscape(commit && *commit ? commit : "unknown") << "\",\n";
+    out << "  \"date\": \"" << date << "\",\n";
+    out << "  \"compiler\": \"" << jsonEscape(compiler) << "\",\n";
+    out << "  \"threads\": " << thread::hardware_concurrency() << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const SuiteResult& r = results[i];
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"size\": %d, \"enemies\": %zu, \"median_ns\": %.1f, \"min_ns\": %.1f, "
+                 "\"samples\": %zu, \"calls_per_sample\": %zu}%s\n",
+                 r.name.c_str(), r.size, r.enemies, r.medianNs, r.minNs, r.samples, r.callsPerSample,
+                 i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+    cout << "results      : " << results.size() << " -> " << outFile << endl;
+}
+
+// Reads back the result lines runSuite writes (one object per line), keyed by name/size/enemies
+static bool readSuite(const string& filename, map<string, double>& medians) {
+    ifstream in(filename);
+    if (!in.is_open()) {
+        cerr << "Could not open " << filename << endl;
+        return false;
+    }
+    auto field = [](const string& line, const string& key) {
+        const size_t at = line.find("\"" + key + "\": ");
+        if (at == string::npos) return string();
+        size_t begin = at + key.size() + 4;
+        size_t end = line.find_first_of(",}", begin);
+        string value = line.substr(begin, end - begin);
+        if (!value.empty() && value[0] == '"') value = value.substr(1, value.size() - 2);
+        return value;
+    };
+    string line;
+    while (getline(in, line)) {
+        const string name = field(line, "name");
+        if (name.empty()) continue;
+        medians[name + " " + field(line, "size") + " " + field(line, "enemies")] = atof(field(line, "median_ns").c_str());
+    }
+    return true;
+}
+
+// Compare two suite runs; returns the number of results that got slower by more than 'thresholdPercent'
+static int runCompare(const string& baseFile, const string& newFile, double thresholdPercent) {
+    map<string, double> base, current;
+    if (!readSuite(baseFile, base) || !readSuite(newFile, current)) return -1;
+    int regressions = 0;
+    printf("%-32s %14s %14s %9s\n", "function size enemies", "base(ns)", "new(ns)", "change");
+    for (const auto& entry : current) {
+        auto old = base.find(entry.first);
+        if (old == base.end() || old->second <= 0) continue;
+        const double change = (entry.second / old->second - 1.0) * 100.0;
+        const bool slower = change > thresholdPercent;
+        if (slower) regressions++;
+        printf("%-32s %14.1f %14.1f %+8.1f%%%s\n", entry.first.c_str(), old->second, entry.second, change,
+               slower ? "  REGRESSION" : "");
+    }
+    cout << regressions << " regression(s) over " << thresholdPercent << "%" << endl;
+    return regressions;
+}
+
+static void printUsage() {
+    cerr << "Usage:\n"
+         << "  MazeBench throughput [boardSize] [steps]\n"
+         << "  MazeBench vecenv [games] [boardSize] [threads] [steps]\n"
+         << "  MazeBench pregen [boardSize] [levels] [depth] [thinkMs]\n"
+         << "  MazeBench fixed [steps] [newGames]\n"
+         << "  MazeBench render [boardSize] [frames]\n"
+         << "  MazeBench occupancy [boardSize] [maxEnemies]\n"
+         << "  MazeBench enemies [boardSize] [maxEnemies] [threads]\n"
+         << "  MazeBench flowfield [boardSize] [moves] [radius]\n"
+         << "  MazeBench generate [boardSize] [algorithm|all] [outFile]\n"
+         << "  MazeBench placement [boardSize]\n"
+         << "  MazeBench solver [boardSize] [maxItems]\n"
+         << "  MazeBench save [boardSize] [enemies]\n"
+         << "  MazeBench autosave [boardSize] [enemies] [everyMoves] [steps]\n"
+         << "  MazeBench undo [boardSize] [steps] [enemies]\n"
+         << "  MazeBench record [boardSize] [steps] [enemies] [logFile] [chase]\n"
+         << "  MazeBench replay [logFile] [step]\n"
+         << "  MazeBench realtime [boardSize] [enemies] [enemyHz] [seconds] [keysPerSecond] [renderCostMs]\n"
+         << "  MazeBench suite [outFile.json] [quick]\n"
+         << "  MazeBench compare [base.json] [new.json] [thresholdPercent]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    string mode = argv[1];
+    if (mode == "throughput") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : MAZE_DIMENSION;
+        size_t steps = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000000;
+        runThroughput(boardSize, steps);
+        return 0;
+    }
+    if (mode == "vecenv") {
+        size_t games = argc > 2 ? strtoull(argv[2], nullptr, 10) : 256;
+        int boardSize = argc > 3 ? atoi(argv[3]) : MAZE_DIMENSION;
+        unsigned threads = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : thread::hardware_concurrency();
+        size_t steps = argc > 5 ? strtoull(argv[5], nullptr, 10) : 10000000;
+        runVecEnv(games < 1 ? 1 : games, boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, threads, steps);
+        return 0;
+    }
+    if (mode == "pregen") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 201;
+        int levels = argc > 3 ? atoi(argv[3]) : 20;
+        size_t depth = argc > 4 ? strtoull(argv[4], nullptr, 10) : 2;
+        double thinkMs = argc > 5 ? atof(argv[5]) : 50.0;
+        runPregen(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, levels < 1 ? 1 : levels,
+                  depth < 1 ? 1 : depth, thinkMs);
+        return 0;
+    }
+    if (mode == "fixed") {
+        size_t steps = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000000;
+        size_t newGames = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100000;
+        runFixed(steps < 1 ? 1 : steps, newGames < 1 ? 1 : newGames);
+        return 0;
+    }
+    if (mode == "render") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : MAZE_DIMENSION;
+        size_t frames = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100000;
+        runRender(boardSize, frames);
+        return 0;
+    }
+    if (mode == "occupancy") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 1001;
+        size_t maxEnemies = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100000;
+        runOccupancy(boardSize, maxEnemies);
+        return 0;
+    }
+    if (mode == "enemies") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 2001;
+        size_t maxEnemies = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+        unsigned threads = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : thread::hardware_concurrency();
+        runEnemies(boardSize, maxEnemies, threads);
+        return 0;
+    }
+    if (mode == "flowfield") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 1001;
+        size_t moves = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000;
+        uint32_t radius = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 0;
+        runFlowField(boardSize, moves < 1 ? 1 : moves, radius);
+        return 0;
+    }
+    if (mode == "generate") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 4001;
+        string which = argc > 3 ? argv[3] : "all";
+        string outFile = argc > 4 ? argv[4] : "";
+        runGenerate(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, which, outFile);
+        return 0;
+    }
+    if (mode == "placement") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 1001;
+        runPlacement(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize);
+        return 0;
+    }
+    if (mode == "solver") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 1001;
+        int maxItems = argc > 3 ? atoi(argv[3]) : 64;
+        runSolver(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, maxItems);
+        return 0;
+    }
+    if (mode == "save") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 4001;
+        size_t enemies = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000;
+        runSave(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, enemies);
+        return 0;
+    }
+    if (mode == "autosave") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 4001;
+        size_t enemies = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000;
+        int everyMoves = argc > 4 ? atoi(argv[4]) : 10;
+        size_t steps = argc > 5 ? strtoull(argv[5], nullptr, 10) : 200;
+        runAutosave(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, enemies,
+                    everyMoves < 1 ? 1 : everyMoves, steps);
+        return 0;
+    }
+    if (mode == "undo") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 1001;
+        size_t steps = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000;
+        size_t enemies = argc > 4 ? strtoull(argv[4], nullptr, 10) : 200;
+        runUndo(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, steps < 1 ? 1 : steps, enemies);
+        return 0;
+    }
+    if (mode == "record") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 1001;
+        size_t steps = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100000;
+        size_t enemies = argc > 4 ? strtoull(argv[4], nullptr, 10) : 100;
+        string logFile = argc > 5 ? argv[5] : "mazebench.rec";
+        bool chase = argc > 6 && string(argv[6]) == "chase";
+        runRecord(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, steps, enemies, logFile, chase);
+        return 0;
+    }
+    if (mode == "replay") {
+        string logFile = argc > 2 ? argv[2] : "mazebench.rec";
+        long long stopAt = argc > 3 ? atoll(argv[3]) : -1;
+        runReplay(logFile, stopAt);
+        return 0;
+    }
+    if (mode == "realtime") {
+        int boardSize = argc > 2 ? atoi(argv[2]) : 201;
+        size_t enemies = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100;
+        double enemyHz = argc > 4 ? atof(argv[4]) : 4.0;
+        double seconds = argc > 5 ? atof(argv[5]) : 5.0;
+        double keysPerSecond = argc > 6 ? atof(argv[6]) : 10.0;
+        double renderCostMs = argc > 7 ? atof(argv[7]) : 0.0;
+        runRealTime(boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, enemies,
+                    enemyHz > 0 ? enemyHz : 4.0, seconds, keysPerSecond > 0 ? keysPerSecond : 10.0, renderCostMs);
+        return 0;
+    }
+    if (mode == "suite") {
+        string outFile = argc > 2 ? argv[2] : "mazebench.json";
+        bool quick = argc > 3 && string(argv[3]) == "quick";
+        runSuite(outFile, quick);
+        return 0;
+    }
+    if (mode == "compare") {
+        string baseFile = argc > 2 ? argv[2] : "mazebench_base.json";
+        string newFile = argc > 3 ? argv[3] : "mazebench.json";
+        double threshold = argc > 4 ? atof(argv[4]) : 10.0;
+        return runCompare(baseFile, newFile, threshold) == 0 ? 0 : 1;
+    }
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,421 @@
+// MazeGenerator.h
+#ifndef MAZE_GENERATOR_H // Start of include guard
+#define MAZE_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MazeGrid.h"   // Output grid ('#' walls, ' ' passages)
+#include "MazeRandom.h" // SplitMix64: same seed, same maze, on every platform
+
+// Perfect-maze generation.
+// Mazes live on the usual odd lattice: "cells" sit at odd (row, col) positions, the even
+// rows/columns between them are walls, and carving a passage opens the wall between two
+// cells. Every algorithm except the lattice produces a PERFECT maze: exactly one path
+// between any two open squares, start (1, 1) included.
+// Even board sizes have one spare row/column next to the border; it stays wall except for a
+// short spur from the last cell to (rows - 2, cols - 2), where the game puts the exit.
+// All randomness comes from one SplitMix64 stream seeded by the caller, so a seed always
+// gives the same maze.
+
+enum MazeAlgorithm {
+    MAZE_LATTICE,     // Classic board: border plus a pillar on every odd/odd square (not a maze)
+    MAZE_BACKTRACKER, // Iterative recursive backtracker: long winding corridors, few junctions
+    MAZE_WILSON,      // Loop-erased random walks: uniform over all perfect mazes, slower start
+    MAZE_ELLER        // Row by row with O(width) state; see EllerRowStream for the streaming form
+};
+
+inline const char* mazeAlgorithmName(MazeAlgorithm algorithm) {
+    switch (algorithm) {
+        case MAZE_LATTICE: return "lattice";
+        case MAZE_BACKTRACKER: return "backtracker";
+        case MAZE_WILSON: return "wilson";
+        case MAZE_ELLER: return "eller";
+    }
+    return "unknown";
+}
+
+// Name (as printed by mazeAlgorithmName) -> algorithm; false if unknown
+inline bool parseMazeAlgorithm(const std::string& name, MazeAlgorithm& out) {
+    const MazeAlgorithm all[] = { MAZE_LATTICE, MAZE_BACKTRACKER, MAZE_WILSON, MAZE_ELLER };
+    for (MazeAlgorithm a : all) {
+        if (name == mazeAlgorithmName(a)) {
+            out = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Hands out random bits from SplitMix64 a few at a time: the generators mostly need 1-2 bits
+// per decision, so one 64-bit draw covers dozens of steps.
+class RandomBits {
+private:
+    SplitMix64 rng;
+    std::uint64_t buffer;
+    int left;
+
+public:
+    explicit RandomBits(std::uint64_t seed) : rng(seed), buffer(0), left(0) {}
+
+    unsigned take(int bits) {
+        if (left < bits) {
+            buffer = rng();
+            left = 64;
+        }
+        const unsigned v = static_cast<unsigned>(buffer & ((std::uint64_t(1) << bits) - 1));
+        buffer >>= bits;
+        left -= bits;
+        return v;
+    }
+
+    // Uniform in [0, bound) for bound <= 4 (rejection on 2 bits, no modulo bias)
+    unsigned below4(unsigned bound) {
+        if (bound <= 1) return 0;
+        if (bound == 2) return take(1);
+        unsigned v;
+        do { v = take(2); } while (v >= bound);
+        return v;
+    }
+
+    std::uint32_t below(std::uint32_t bound) { return rng.below(bound); }
+};
+
+// Streaming Eller's algorithm: emits the maze one grid row at a time and keeps only O(cols)
+// state, so mazes far larger than memory can be written straight to disk.
+// Each cell row is processed left to right:
+//   1. cells not connected from above start in a set of their own;
+//   2. neighbours in different sets are randomly joined (always, on the last row);
+//   3. every set randomly opens at least one passage down into the next row.
+// Sets are tracked with a union-find over at most cols/2 ids that is compacted every row.
+class EllerRowStream {
+private:
+    static constexpr std::uint32_t NO_ID = ~std::uint32_t(0);
+
+    int rows, cols;
+    int cellRows, cellCols;
+    int nextGridRow;                  // Grid row the next nextRow() call emits
+    RandomBits random;
+    std::vector<std::uint32_t> setOf; // Per cell column: set id
+    std::vector<std::uint32_t> parent; // Union-find over set ids
+    std::vector<std::uint32_t> remap;  // Old root -> compact id while starting a row
+    std::vector<std::uint32_t> remaining; // Per set: cells of the row not yet decided
+    std::vector<std::uint8_t> hasDown;  // Per set: already opened a passage down
+    std::vector<std::uint8_t> east;     // Per cell column: passage to the right
+    std::vector<std::uint8_t> down;     // Per cell column: passage into the next cell row
+
+    std::uint32_t find(std::uint32_t id) {
+        while (parent[id] != id) {
+            parent[id] = parent[parent[id]]; // Path halving
+            id = parent[id];
+        }
+        return id;
+    }
+
+    // Steps 1-3 for cell row 'r'
+    void buildCellRow(int r) {
+        const bool last = r == cellRows - 1;
+        // 1. Compact ids: carried-down cells keep (renamed) sets, the rest get fresh ones
+        std::uint32_t nextId = 0;
+        for (int c = 0; c < cellCols; c++) {
+            if (r > 0 && down[c]) setOf[c] = find(setOf[c]);
+        }
+        for (int c = 0; c < cellCols; c++) {
+            if (r > 0 && down[c]) {
+                std::uint32_t& id = remap[setOf[c]];
+                if (id == NO_ID) id = nextId++;
+                setOf[c] = id;
+            } else {
+                setOf[c] = NO_ID;
+            }
+        }
+        for (int c = 0; c < cellCols; c++) {
+            if (setOf[c] == NO_ID) setOf[c] = nextId++;
+        }
+        for (std::uint32_t& id : remap) id = NO_ID;
+        for (std::uint32_t id = 0; id < nextId; id++) parent[id] = id;
+
+        // 2. Join neighbours in different sets
+        for (int c = 0; c + 1 < cellCols; c++) {
+            const std::uint32_t a = find(setOf[c]), b = find(setOf[c + 1]);
+            east[c] = a != b && (last || random.take(1));
+            if (east[c]) parent[b] = a;
+        }
+        east[cellCols - 1] = 0;
+
+        // 3. Open passages down, at least one per set
+        if (last) {
+            for (int c = 0; c < cellCols; c++) down[c] = 0;
+            return;
+        }
+        for (std::uint32_t id = 0; id < nextId; id++) {
+            remaining[id] = 0;
+            hasDown[id] = 0;
+        }
+        for (int c = 0; c < cellCols; c++) {
+            setOf[c] = find(setOf[c]);
+            remaining[setOf[c]]++;
+        }
+        for (int c = 0; c < cellCols; c++) {
+            const std::uint32_t s = setOf[c];
+            remaining[s]--;
+            down[c] = random.take(1) || (remaining[s] == 0 && !hasDown[s]);
+            if (down[c]) hasDown[s] = 1;
+        }
+    }
+
+public:
+    // rows, cols >= 3
+    EllerRowStream(int numRows, int numCols, std::uint64_t seed) : random(seed) { restart(numRows, numCols, seed); }
+
+    // Start over on a new maze, keeping the buffers (no allocation unless it is wider)
+    void restart(int numRows, int numCols, std::uint64_t seed) {
+        rows = numRows;
+        cols = numCols;
+        cellRows = (numRows - 1) / 2;
+        cellCols = (numCols - 1) / 2;
+        nextGridRow = 0;
+        random = RandomBits(seed);
+        setOf.assign(cellCols, 0);
+        parent.assign(cellCols, 0);
+        remap.assign(cellCols, NO_ID);
+        remaining.assign(cellCols, 0);
+        hasDown.assign(cellCols, 0);
+        east.assign(cellCols, 0);
+        down.assign(cellCols, 0);
+    }
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    bool done() const { return nextGridRow >= rows; }
+
+    // Write the next grid row ('#' / ' ', exactly cols chars, no terminator) into 'out'.
+    // Returns false once all rows have been produced.
+    bool nextRow(char* out) {
+        if (done()) return false;
+        const int x = nextGridRow++;
+        for (int y = 0; y < cols; y++) out[y] = '#';
+        const int lastCellX = 2 * cellRows - 1, lastCellY = 2 * cellCols - 1;
+        if (x % 2 == 1 && x <= lastCellX) {
+            // Cell row: cells plus the passages between them
+            buildCellRow(x / 2);
+            for (int c = 0; c < cellCols; c++) {
+                out[2 * c + 1] = ' ';
+                if (east[c]) out[2 * c + 2] = ' ';
+            }
+            if (x == lastCellX && rows % 2 == 1 && cols % 2 == 0) out[cols - 2] = ' '; // Exit spur
+        } else if (x > 0 && x < lastCellX) {
+            // Between two cell rows: the passages down
+            for (int c = 0; c < cellCols; c++) {
+                if (down[c]) out[2 * c + 1] = ' ';
+            }
+        } else if (x == lastCellX + 1 && x == rows - 2) {
+            // Spare row of an even-sized board: spur from the last cell to (rows - 2, cols - 2)
+            out[lastCellY] = ' ';
+            out[cols - 2] = ' ';
+        }
+        return true;
+    }
+
+    std::size_t memoryBytes() const {
+        return (setOf.capacity() + parent.capacity() + remap.capacity() + remaining.capacity()) * sizeof(std::uint32_t) +
+               hasDown.capacity() + east.capacity() + down.capacity();
+    }
+};
+
+// Working memory of MazeGenerator::generate(). Code that builds one maze after another keeps
+// one, so only the first maze (or a bigger one) allocates.
+struct MazeGeneratorScratch {
+    std::vector<std::uint8_t> cellState; // Backtracker back links / Wilson walk, one byte per cell
+    std::vector<char> line;              // One grid row for Eller
+    EllerRowStream eller{3, 3, 0};
+};
+
+// In-memory generation into a MazeGrid
+class MazeGenerator {
+private:
+    static constexpr std::uint8_t UP = 0, DOWN = 1, LEFT = 2, RIGHT = 3;
+
+    // Open cell (r, c) of the cell lattice
+    static void openCell(MazeGrid& grid, int r, int c) { grid.set(2 * r + 1, 2 * c + 1, ' '); }
+
+    // Open cell (r, c) and the wall towards its neighbour in direction 'dir'
+    static void openPassage(MazeGrid& grid, int r, int c, std::uint8_t dir) {
+        static const int DX[4] = { -1, 1, 0, 0 };
+        static const int DY[4] = { 0, 0, -1, 1 };
+        grid.set(2 * r + 1, 2 * c + 1, ' ');
+        grid.set(2 * r + 1 + DX[dir], 2 * c + 1 + DY[dir], ' ');
+    }
+
+    static std::uint8_t opposite(std::uint8_t dir) { return dir ^ 1; }
+
+    // Even-sized boards: connect (rows - 2, cols - 2) to the last cell through the spare row/column
+    static void addExitSpur(MazeGrid& grid) {
+        const int rows = grid.getRows(), cols = grid.getCols();
+        const int lastX = 2 * ((rows - 1) / 2) - 1, lastY = 2 * ((cols - 1) / 2) - 1;
+        if (rows % 2 == 0) grid.set(rows - 2, lastY, ' ');
+        if (cols % 2 == 0) grid.set(rows % 2 == 0 ? rows - 2 : lastX, cols - 2, ' ');
+    }
+
+    static void lattice(MazeGrid& grid) {
+        const int rows = grid.getRows(), cols = grid.getCols();
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                if (i == 0 || i == rows - 1 || j == 0 || j == cols - 1 || (i % 2 != 0 && j % 2 != 0))
+                    grid.set(i, j, '#');
+                else
+                    grid.set(i, j, ' ');
+            }
+        }
+    }
+
+    // Depth-first carving without recursion. Instead of an explicit stack every cell stores
+    // the direction back to the cell it was entered from (1 byte per cell, 0 = unvisited),
+    // so backtracking is a walk along those links and memory is one flat, row-major array.
+    static void backtracker(MazeGrid& grid, int cellRows, int cellCols, RandomBits& random,
+                            std::vector<std::uint8_t>& from) {
+        const std::uint8_t UNVISITED = 0, ROOT = 5;
+        from.assign(static_cast<std::size_t>(cellRows) * cellCols, UNVISITED);
+        int r = 0, c = 0;
+        std::size_t cur = 0;
+        from[cur] = ROOT;
+        openCell(grid, 0, 0);
+        for (;;) {
+            std::uint8_t options[4];
+            unsigned n = 0;
+            if (r > 0 && from[cur - cellCols] == UNVISITED) options[n++] = UP;
+            if (r + 1 < cellRows && from[cur + cellCols] == UNVISITED) options[n++] = DOWN;
+            if (c > 0 && from[cur - 1] == UNVISITED) options[n++] = LEFT;
+            if (c + 1 < cellCols && from[cur + 1] == UNVISITED) options[n++] = RIGHT;
+            std::uint8_t dir;
+            if (n > 0) {
+                dir = options[random.below4(n)];
+                openPassage(grid, r, c, dir);
+            } else {
+                if (from[cur] == ROOT) break;
+                dir = from[cur] - 1; // Back the way we came
+            }
+            switch (dir) {
+                case UP: r--; cur -= cellCols; break;
+                case DOWN: r++; cur += cellCols; break;
+                case LEFT: c--; cur--; break;
+                default: c++; cur++; break;
+            }
+            if (n > 0) {
+                from[cur] = opposite(dir) + 1;
+                openCell(grid, r, c);
+            }
+        }
+    }
+
+    // Wilson's algorithm: from every cell not yet in the maze, random-walk until the walk hits
+    // the maze, remembering only the LAST direction taken out of each cell (that erases loops
+    // for free), then carve the remembered path. Uniform over all perfect mazes.
+    static void wilson(MazeGrid& grid, int cellRows, int cellCols, RandomBits& random,
+                       std::vector<std::uint8_t>& state) {
+        const std::uint8_t IN_MAZE = 0x80;
+        const std::size_t n = static_cast<std::size_t>(cellRows) * cellCols;
+        state.assign(n, 0); // IN_MAZE | (walk direction + 1)
+        const std::size_t root = random.below(static_cast<std::uint32_t>(n));
+        state[root] = IN_MAZE;
+        openCell(grid, static_cast<int>(root / cellCols), static_cast<int>(root % cellCols));
+        for (std::size_t start = 0; start < n; start++) {
+            if (state[start] & IN_MAZE) continue;
+            const int startR = static_cast<int>(start / cellCols), startC = static_cast<int>(start % cellCols);
+            // Walk
+            int r = startR, c = startC;
+            std::size_t cur = start;
+            while (!(state[cur] & IN_MAZE)) {
+                std::uint8_t dir;
+                for (;;) {
+                    dir = static_cast<std::uint8_t>(random.take(2));
+                    if ((dir == UP && r > 0) || (dir == DOWN && r + 1 < cellRows) ||
+                        (dir == LEFT && c > 0) || (dir == RIGHT && c + 1 < cellCols)) break;
+                }
+                state[cur] = dir + 1;
+                switch (dir) {
+                    case UP: r--; cur -= cellCols; break;
+                    case DOWN: r++; cur += cellCols; break;
+                    case LEFT: c--; cur--; break;
+                    default: c++; cur++; break;
+                }
+            }
+            // Carve the loop-erased path
+            r = startR;
+            c = startC;
+            cur = start;
+            while (!(state[cur] & IN_MAZE)) {
+                const std::uint8_t dir = state[cur] - 1;
+                state[cur] = IN_MAZE;
+                openPassage(grid, r, c, dir);
+                switch (dir) {
+                    case UP: r--; cur -= cellCols; break;
+                    case DOWN: r++; cur += cellCols; break;
+                    case LEFT: c--; cur--; break;
+                    default: c++; cur++; break;
+                }
+            }
+        }
+    }
+
+public:
+    // Resize 'grid' to rows x cols (both >= 3) and fill it with a maze. Only '#' and ' ' are
+    // written; the caller places the exit, items, etc.
+    static void generate(MazeGrid& grid, int rows, int cols, MazeAlgorithm algorithm, std::uint64_t seed) {
+        MazeGeneratorScratch scratch;
+        generate(grid, rows, cols, algorithm, seed, scratch);
+    }
+
+    // Same, working in 'scratch' (and rebuilding 'grid' in place), so a maze no bigger than
+    // the last one allocates nothing
+    static void generate(MazeGrid& grid, int rows, int cols, MazeAlgorithm algorithm, std::uint64_t seed,
+                         MazeGeneratorScratch& scratch) {
+        RandomBits random(seed);
+        switch (algorithm) {
+            case MAZE_LATTICE:
+                grid.resize(rows, cols, ' ');
+                lattice(grid);
+                return;
+            case MAZE_ELLER: {
+                grid.resize(rows, cols, '#');
+                EllerRowStream& stream = scratch.eller;
+                stream.restart(rows, cols, seed);
+                scratch.line.resize(cols);
+                for (int x = 0; stream.nextRow(scratch.line.data()); x++) grid.setRow(x, scratch.line.data());
+                return;
+            }
+            case MAZE_BACKTRACKER:
+                grid.resize(rows, cols, '#');
+                backtracker(grid, (rows - 1) / 2, (cols - 1) / 2, random, scratch.cellState);
+                break;
+            case MAZE_WILSON:
+                grid.resize(rows, cols, '#');
+                wilson(grid, (rows - 1) / 2, (cols - 1) / 2, random, scratch.cellState);
+                break;
+        }
+        addExitSpur(grid);
+    }
+};
+
+// The MAZE_LATTICE board for a size known at compile time, as a wall plane laid out like
+// MazeGrid's (Rows rows of (Cols + 63) / 64 words), worked out entirely by the compiler.
+// Same walls as MazeGenerator::generate(.., MAZE_LATTICE, ..), except that the start square
+// (1, 1) is already open.
+template <int Rows, int Cols>
+struct LatticePlane {
+    static constexpr std::size_t WORDS_PER_ROW = (static_cast<std::size_t>(Cols) + 63) / 64;
+    std::uint64_t words[Rows * WORDS_PER_ROW];
+
+    constexpr LatticePlane() : words() {
+        for (int i = 0; i < Rows; i++) {
+            for (int j = 0; j < Cols; j++) {
+                const bool wall = i == 0 || i == Rows - 1 || j == 0 || j == Cols - 1 || (i % 2 != 0 && j % 2 != 0);
+                if (wall && !(i == 1 && j == 1)) words[i * WORDS_PER_ROW + (j >> 6)] |= std::uint64_t(1) << (j & 63);
+            }
+        }
+    }
+};
+
+#endif // MAZE_GENERATOR_H
@@ -0,0 +1,258 @@
+// MazeGrid.h
+#ifndef MAZE_GRID_H // Start of include guard
+#define MAZE_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Runtime-sized maze storage.
+// Cells live in ONE contiguous row-major buffer (no per-row allocations), so a 16k x 16k
+// maze is a single block instead of thousands of small ones. Next to it sits a bit-packed
+// wall plane (1 bit per cell) that the hot movement checks read instead of the char buffer:
+// 64 cells share a cache word, so bounds + wall tests stay cheap as the maze grows.
+// The wall plane is copy-on-write: shareWallPlane() hands out a reference in O(1) (an
+// autosave snapshot, for instance), and only a write that actually flips a wall bit while
+// it is shared copies it. Walls only change when a level is built, so in play that never happens.
+// Rebuilding a board reuses the grid's cell buffer and (when nothing else holds it) its wall
+// plane, so a new level of the same size allocates nothing. useStorage() puts both in memory
+// the caller owns, e.g. one slab for a whole batch of games (VecEnv).
+// Coordinates follow the rest of the game: x is the row, y is the column.
+class MazeGrid {
+private:
+    int rows, cols;
+    std::size_t wordsPerRow;             // Row stride of the wall plane, in 64-bit words
+    std::vector<char> ownCells;          // Cell buffer when the grid owns it
+    char* cells;                         // rows * cols characters, row-major (ownCells or the caller's)
+    std::size_t cellSlots;               // Characters available at 'cells'
+    std::shared_ptr<std::uint64_t[]> wallBits; // rows * wordsPerRow words, bit set = wall
+    std::size_t wallSlots;               // Words available in wallBits
+
+    std::size_t wallWords() const { return static_cast<std::size_t>(rows) * wordsPerRow; }
+
+    // Room for rows * cols cells (contents undefined); grows into ownCells when too small
+    void reserveCells() {
+        const std::size_t count = static_cast<std::size_t>(rows) * cols;
+        if (count <= cellSlots) return;
+        ownCells.resize(count);
+        cells = ownCells.data();
+        cellSlots = count;
+    }
+
+    // Zeroed wall plane: the current one when nothing else holds it and it is big enough,
+    // otherwise a fresh one (a plane a snapshot is still reading is never reused)
+    void allocateWalls() {
+        const std::size_t words = wallWords();
+        if (!wallBits || wallBits.use_count() > 1 || words > wallSlots) {
+            wallBits.reset(new std::uint64_t[words]);
+            wallSlots = words;
+        }
+        if (words) std::memset(wallBits.get(), 0, words * sizeof(std::uint64_t));
+    }
+
+    // Give this grid its own copy of the wall plane before writing to it, if it is shared
+    void detachWalls() {
+        if (wallBits.use_count() <= 1) return;
+        std::shared_ptr<std::uint64_t[]> own(new std::uint64_t[wallWords()]);
+        std::memcpy(own.get(), wallBits.get(), wallWords() * sizeof(std::uint64_t));
+        wallBits.swap(own);
+        wallSlots = wallWords();
+    }
+
+    void setWallBit(int x, int y, bool wall) {
+        const std::size_t index = x * wordsPerRow + (y >> 6);
+        const std::uint64_t mask = std::uint64_t(1) << (y & 63);
+        if (((wallBits[index] & mask) != 0) == wall) return; // Unchanged: no write, no copy
+        detachWalls();
+        wallBits[index] ^= mask;
+    }
+
+public:
+    MazeGrid() : rows(0), cols(0), wordsPerRow(0), cells(nullptr), cellSlots(0), wallSlots(0) {}
+    MazeGrid(int numRows, int numCols, char fill = ' ')
+        : rows(0), cols(0), wordsPerRow(0), cells(nullptr), cellSlots(0), wallSlots(0) {
+        resize(numRows, numCols, fill);
+    }
+
+    // Copies own their cells; the wall plane is shared copy-on-write
+    MazeGrid(const MazeGrid& other)
+        : rows(other.rows), cols(other.cols), wordsPerRow(other.wordsPerRow),
+          ownCells(other.cells, other.cells + other.cellCount()), cells(ownCells.data()),
+          cellSlots(ownCells.size()), wallBits(other.wallBits), wallSlots(other.wallSlots) {}
+    MazeGrid& operator=(const MazeGrid& other) {
+        MazeGrid copy(other);
+        swap(copy);
+        return *this;
+    }
+
+    // Build boards in caller-owned memory from now on: 'cellBuffer' holds up to 'cellCount'
+    // cells and 'wallBuffer' up to 'wallCount' words (wall plane words of a rows x cols board:
+    // rows * ((cols + 63) / 64)). The current board moves into them. A larger board, or a
+    // rebuild while a snapshot still shares the plane, goes back to the heap. Both buffers
+    // must outlive the grid and every plane shared from it. False (and nothing changes) if
+    // the current board doesn't fit.
+    bool useStorage(char* cellBuffer, std::size_t cellCount, std::uint64_t* wallBuffer, std::size_t wallCount) {
+        const std::size_t count = static_cast<std::size_t>(rows) * cols;
+        if (count > cellCount || wallWords() > wallCount) return false;
+        if (count) std::memcpy(cellBuffer, cells, count);
+        if (wallWords()) std::memcpy(wallBuffer, wallBits.get(), wallWords() * sizeof(std::uint64_t));
+        cells = cellBuffer;
+        cellSlots = cellCount;
+        wallBits.reset(wallBuffer, [](std::uint64_t*) {}); // Owned by the caller
+        wallSlots = wallCount;
+        std::vector<char>().swap(ownCells);
+        return true;
+    }
+
+    // Re-dimension the grid and fill every cell with 'fill' (keeps the wall plane in sync)
+    void resize(int numRows, int numCols, char fill = ' ') {
+        rows = numRows > 0 ? numRows : 0;
+        cols = numCols > 0 ? numCols : 0;
+        wordsPerRow = (static_cast<std::size_t>(cols) + 63) / 64;
+        reserveCells();
+        if (cellCount()) std::memset(cells, fill, cellCount());
+        allocateWalls();
+        if (fill == '#') {
+            // Whole words at a time; the padding bits past the last column stay clear
+            for (int x = 0; x < rows; x++) {
+                std::uint64_t* words = &wallBits[x * wordsPerRow];
+                for (std::size_t w = 0; w < wordsPerRow; w++) words[w] = ~std::uint64_t(0);
+                if (cols & 63) words[wordsPerRow - 1] = (std::uint64_t(1) << (cols & 63)) - 1;
+            }
+        }
+    }
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    std::size_t cellCount() const { return static_cast<std::size_t>(rows) * cols; }
+
+    bool inBounds(int x, int y) const {
+        // Unsigned compare folds the "< 0" and ">= size" checks into one branch each
+        return static_cast<unsigned>(x) < static_cast<unsigned>(rows) &&
+               static_cast<unsigned>(y) < static_cast<unsigned>(cols);
+    }
+
+    // Unchecked access - caller guarantees (x, y) is inside the grid
+    char at(int x, int y) const { return cells[static_cast<std::size_t>(x) * cols + y]; }
+
+    // Unchecked access by row-major cell index (x * cols + y)
+    char atIndex(std::size_t cell) const { return cells[cell]; }
+
+    // Checked access - anything outside the grid reads as a wall
+    char get(int x, int y) const { return inBounds(x, y) ? at(x, y) : '#'; }
+
+    // Every write goes through here so the wall plane can never drift from the cells
+    void set(int x, int y, char c) {
+        cells[static_cast<std::size_t>(x) * cols + y] = c;
+        setWallBit(x, y, c == '#');
+    }
+
+    // Hot-path wall test: reads only the bit plane. Out-of-bounds counts as a wall.
+    bool isWall(int x, int y) const {
+        if (!inBounds(x, y)) return true;
+        return (wallBits[x * wordsPerRow + (y >> 6)] >> (y & 63)) & 1;
+    }
+
+    // Raw row access for bulk writers/readers (save, load, display)
+    const char* row(int x) const { return &cells[static_cast<std::size_t>(x) * cols]; }
+
+    // Overwrite row x with cols characters from 'src', rebuilding its wall bits word by word
+    void setRow(int x, const char* src) {
+        detachWalls();
+        char* dst = &cells[static_cast<std::size_t>(x) * cols];
+        std::uint64_t* words = &wallBits[x * wordsPerRow];
+        for (std::size_t w = 0; w < wordsPerRow; w++) {
+            const int begin = static_cast<int>(w * 64);
+            const int end = begin + 64 < cols ? begin + 64 : cols;
+            std::uint64_t bits = 0;
+            for (int y = begin; y < end; y++) {
+                dst[y] = src[y];
+                bits |= static_cast<std::uint64_t>(src[y] == '#') << (y - begin);
+            }
+            words[w] = bits;
+        }
+    }
+
+    // Rebuild the grid from a wall plane laid out like wallBits (rows * wordsPerRow words),
+    // copied from 'words'. Cells come out as '#' or ' '.
+    void assignWallPlane(int numRows, int numCols, const std::uint64_t* words) {
+        const std::size_t count = numRows > 0 && numCols > 0
+                                      ? static_cast<std::size_t>(numRows) * ((static_cast<std::size_t>(numCols) + 63) / 64)
+                                      : 0;
+        std::shared_ptr<std::uint64_t[]> copy(new std::uint64_t[count]);
+        if (count) std::memcpy(copy.get(), words, count * sizeof(std::uint64_t));
+        assignWallPlane(numRows, numCols, std::shared_ptr<const std::uint64_t[]>(copy));
+    }
+
+    // Same, but the grid adopts 'plane' copy-on-write instead of copying it (e.g. a snapshot
+    // being restored). Cells are expanded 8 at a time through a 256-entry pattern table.
+    void assignWallPlane(int numRows, int numCols, std::shared_ptr<const std::uint64_t[]> plane) {
+        static const struct ExpandTable {
+            std::uint64_t chars[256]; // Byte b -> 8 cells, cell k = '#' if bit k of b is set
+            ExpandTable() {
+                for (int b = 0; b < 256; b++) {
+                    unsigned char pattern[8];
+                    for (int k = 0; k < 8; k++) pattern[k] = ((b >> k) & 1) ? '#' : ' ';
+                    std::memcpy(&chars[b], pattern, 8);
+                }
+            }
+        } expand;
+
+        rows = numRows > 0 ? numRows : 0;
+        cols = numCols > 0 ? numCols : 0;
+        wordsPerRow = (static_cast<std::size_t>(cols) + 63) / 64;
+        reserveCells();
+        // Shared, so only written through detachWalls(); every grid keeps its writes to itself
+        wallBits = std::const_pointer_cast<std::uint64_t[]>(plane);
+        wallSlots = wallWords();
+        if (cols & 63) {
+            // Padding bits past the last column must stay clear
+            const std::uint64_t padding = ~((std::uint64_t(1) << (cols & 63)) - 1);
+            for (int x = 0; x < rows; x++) {
+                if (wallBits[x * wordsPerRow + wordsPerRow - 1] & padding) {
+                    detachWalls();
+                    wallBits[x * wordsPerRow + wordsPerRow - 1] &= ~padding;
+                }
+            }
+        }
+        for (int x = 0; x < rows; x++) {
+            const std::uint64_t* rowWords = &wallBits[x * wordsPerRow];
+            char* dst = &cells[static_cast<std::size_t>(x) * cols];
+            int y = 0;
+            for (; y + 8 <= cols; y += 8) {
+                const unsigned byte = (rowWords[y >> 6] >> (y & 63)) & 0xFF;
+                std::memcpy(dst + y, &expand.chars[byte], 8);
+            }
+            for (; y < cols; y++) dst[y] = ((rowWords[y >> 6] >> (y & 63)) & 1) ? '#' : ' ';
+        }
+    }
+
+    // Wall plane access for code that works on whole words at a time
+    std::size_t getWordsPerRow() const { return wordsPerRow; }
+    const std::uint64_t* wallRow(int x) const { return &wallBits[x * wordsPerRow]; }
+
+    // O(1) read-only reference to the current wall plane (rows * getWordsPerRow() words).
+    // It stays valid and unchanged for as long as it is held, whatever happens to the grid.
+    std::shared_ptr<const std::uint64_t[]> shareWallPlane() const { return wallBits; }
+
+    // Approximate footprint (cells + wall plane, heap or caller's), used for reporting
+    std::size_t memoryBytes() const {
+        return cellSlots * sizeof(char) + wallSlots * sizeof(std::uint64_t);
+    }
+
+    void swap(MazeGrid& other) {
+        std::swap(rows, other.rows);
+        std::swap(cols, other.cols);
+        std::swap(wordsPerRow, other.wordsPerRow);
+        ownCells.swap(other.ownCells); // Buffers move with their contents, so 'cells' stays valid
+        std::swap(cells, other.cells);
+        std::swap(cellSlots, other.cellSlots);
+        wallBits.swap(other.wallBits);
+        std::swap(wallSlots, other.wallSlots);
+    }
+};
+
+#endif // MAZE_GRID_H
@@ -0,0 +1,69 @@
+// MazeRandom.h
+#ifndef MAZE_RANDOM_H // Start of include guard
+#define MAZE_RANDOM_H
+
+#include <cstdint>
+
+// Random number helpers shared by the simulation.
+// Everything here is defined bit-for-bit by this file (no std:: distributions, whose output
+// differs between standard libraries), so a seed means the same thing on every platform.
+
+// 32-bit finaliser from MurmurHash3: a cheap, well-mixed bijection on 32-bit values.
+// Only multiplies, shifts and xors, so it vectorises (see EnemyStore's AVX2 kernel).
+inline std::uint32_t mix32(std::uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// 64-bit finaliser (SplitMix64 output function)
+inline std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Counter-based (stateless) random value for entity 'id' on simulation tick 'tick'.
+// The result depends only on (seedKey, tick, id) - not on which thread asks, in what order,
+// or how many values were drawn before - which is what makes parallel updates reproducible.
+// 'seedKey' is a 32-bit digest of the game seed (see seedKey32()).
+inline std::uint32_t counterRandom32(std::uint32_t seedKey, std::uint32_t tick, std::uint32_t id) {
+    return mix32(seedKey ^ mix32(tick * 0x9E3779B1u ^ (id * 0x85EBCA77u + 0x165667B1u)));
+}
+
+inline std::uint32_t seedKey32(std::uint64_t seed) {
+    return static_cast<std::uint32_t>(mix64(seed) >> 32);
+}
+
+// Small sequential generator (SplitMix64) for the places that need a stream of numbers
+// rather than one value per (tick, id). Satisfies the UniformRandomBitGenerator interface.
+class SplitMix64 {
+private:
+    std::uint64_t state;
+
+public:
+    typedef std::uint64_t result_type;
+
+    explicit SplitMix64(std::uint64_t seed = 0) : state(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        state += 0x9E3779B97F4A7C15ull;
+        return mix64(state);
+    }
+
+    // Uniform integer in [0, bound) without modulo bias worth caring about (Lemire's method)
+    std::uint32_t below(std::uint32_t bound) {
+        return static_cast<std::uint32_t>(((*this)() >> 32) * bound >> 32);
+    }
+
+    std::uint64_t getState() const { return state; }
+    void setState(std::uint64_t s) { state = s; }
+};
+
+#endif // MAZE_RANDOM_H
@@ -0,0 +1,260 @@
+// MazeRenderer.h
+#ifndef MAZE_RENDERER_H // Start of include guard
+#define MAZE_RENDERER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MazeSim.h" // Game state read by drawMazeFrame()
+#include "Instrumentation.h" // Frame / cell / byte counters
+
+// Portable, differential terminal renderer.
+// The game draws into a BACK frame (a plain character + color grid). present() compares it
+// with the FRONT frame (what the terminal is currently showing), turns only the cells that
+// changed into one ANSI escape stream, hands that stream to the sink in a single write, and
+// swaps the frames. Unchanged frames cost zero bytes, which is what keeps large mazes usable
+// over slow SSH links.
+//
+// Colors use the same numbers as the Windows console attributes the game always used
+// (low nibble = foreground, bit 3 = bright, high nibble = background), so 10 is bright green,
+// 12 bright red, and so on. COLOR_DEFAULT means "terminal's own default colors".
+
+const unsigned char COLOR_DEFAULT = 0xFF;
+
+struct FrameCell {
+    char glyph;
+    unsigned char color;
+    bool operator==(const FrameCell& other) const { return glyph == other.glyph && color == other.color; }
+    bool operator!=(const FrameCell& other) const { return !(*this == other); }
+};
+
+class FrameRenderer {
+public:
+    // Receives each finished frame's escape stream (one call per frame)
+    typedef std::function<void(const char*, std::size_t)> Sink;
+
+private:
+    int width, height;                 // Frame size in terminal columns / rows
+    std::vector<FrameCell> front, back;
+    std::string out;                   // Escape stream for the frame being presented (reused buffer)
+    bool fullRedraw;                   // Next present() repaints everything (first frame, resize, invalidate)
+    std::size_t lastBytes, lastCells;  // Stats for the last presented frame
+    int cursorRow, cursorCol;          // Where the terminal cursor is while building 'out'
+    int currentColor;                  // Active SGR color while building 'out' (-1 = unknown)
+
+    // Gaps of unchanged cells up to this size are rewritten instead of jumping over them:
+    // a cursor move costs ~6-8 bytes, re-sending a few cells is usually cheaper.
+    static constexpr int MAX_REWRITE_GAP = 4;
+
+    void appendInt(int value) {
+        char buf[16];
+        int n = std::snprintf(buf, sizeof(buf), "%d", value);
+        out.append(buf, n);
+    }
+
+    void moveCursor(int r, int c) {
+        if (r == cursorRow && c == cursorCol) return;
+        out += "\x1b[";
+        appendInt(r + 1);
+        out += ';';
+        appendInt(c + 1);
+        out += 'H';
+        cursorRow = r;
+        cursorCol = c;
+    }
+
+    // Windows-style attribute -> SGR sequence. Only emitted when the color actually changes.
+    void applyColor(unsigned char color) {
+        if (color == currentColor) return;
+        currentColor = color;
+        if (color == COLOR_DEFAULT) {
+            out += "\x1b[0m";
+            return;
+        }
+        // Windows bit order is B=1, G=2, R=4; ANSI wants R=1, G=2, B=4
+        static const int ANSI_ORDER[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+        int fg = color & 0x0F;
+        int bg = (color >> 4) & 0x0F;
+        out += "\x1b[0;";
+        appendInt((fg & 8 ? 90 : 30) + ANSI_ORDER[fg & 7]);
+        if (bg != 0) {
+            out += ';';
+            appendInt((bg & 8 ? 100 : 40) + ANSI_ORDER[bg & 7]);
+        }
+        out += 'm';
+    }
+
+    void emitCell(int r, int c, const FrameCell& cell) {
+        moveCursor(r, c);
+        // A blank with no background looks the same in any foreground color, so it never
+        // forces a color switch - this merges runs like "# # #" into one colored span.
+        bool colorless = cell.glyph == ' ' && (cell.color == COLOR_DEFAULT || (cell.color & 0xF0) == 0);
+        if (!colorless) applyColor(cell.color);
+        out += cell.glyph;
+        cursorCol++;
+    }
+
+public:
+    FrameRenderer()
+        : width(0), height(0), fullRedraw(true), lastBytes(0), lastCells(0),
+          cursorRow(-1), cursorCol(-1), currentColor(-1) {}
+
+    // Start a new back frame: resizes if needed and blanks it
+    void beginFrame(int frameWidth, int frameHeight) {
+        if (frameWidth != width || frameHeight != height) {
+            width = frameWidth;
+            height = frameHeight;
+            front.assign(static_cast<std::size_t>(width) * height, FrameCell{ ' ', COLOR_DEFAULT });
+            fullRedraw = true;
+        }
+        back.assign(static_cast<std::size_t>(width) * height, FrameCell{ ' ', COLOR_DEFAULT });
+    }
+
+    void put(int r, int c, char glyph, unsigned char color) {
+        if (r < 0 || r >= height || c < 0 || c >= width) return;
+        back[static_cast<std::size_t>(r) * width + c] = FrameCell{ glyph, color };
+    }
+
+    void text(int r, int c, const std::string& s, unsigned char color = COLOR_DEFAULT) {
+        for (std::size_t i = 0; i < s.size(); i++) put(r, c + static_cast<int>(i), s[i], color);
+    }
+
+    // Forget what the terminal shows (e.g. after something else cleared it): next frame repaints fully
+    void invalidate() { fullRedraw = true; }
+
+    // Diff back against front, write the changes through 'sink' in ONE call, swap frames.
+    // The cursor is left on the line below the frame with the rest of the screen cleared,
+    // so prompts printed afterwards never leave stale text behind. Returns bytes written.
+    std::size_t present(const Sink& sink) {
+        out.clear();
+        cursorRow = cursorCol = -1;
+        currentColor = -1;
+        lastCells = 0;
+        if (fullRedraw) {
+            out += "\x1b[0m\x1b[2J";
+        }
+
+        for (int r = 0; r < height; r++) {
+            const FrameCell* b = &back[static_cast<std::size_t>(r) * width];
+            const FrameCell* f = &front[static_cast<std::size_t>(r) * width];
+            int c = 0;
+            while (c < width) {
+                if (!fullRedraw && b[c] == f[c]) { c++; continue; }
+                // Start of a changed run; extend it across small unchanged gaps
+                int end = c + 1;
+                int lastChanged = c;
+                while (end < width && end - lastChanged <= MAX_REWRITE_GAP) {
+                    if (fullRedraw || b[end] != f[end]) lastChanged = end;
+                    end++;
+                }
+                for (int k = c; k <= lastChanged; k++) emitCell(r, k, b[k]);
+                lastCells += lastChanged - c + 1;
+                c = lastChanged + 1;
+            }
+        }
+
+        // Park the cursor below the frame and clear anything printed there last time
+        out += "\x1b[0m\x1b[";
+        appendInt(height + 1);
+        out += ";1H\x1b[J";
+
+        front.swap(back);
+        fullRedraw = false;
+        lastBytes = out.size();
+        sink(out.data(), out.size());
+        MAZE_COUNT(COUNTER_FRAMES, 1);
+        MAZE_COUNT(COUNTER_CELLS_REDRAWN, lastCells);
+        MAZE_COUNT(COUNTER_CONSOLE_BYTES, lastBytes);
+        return lastBytes;
+    }
+
+    std::size_t lastFrameBytes() const { return lastBytes; }
+    std::size_t lastFrameCells() const { return lastCells; } // Cells re-sent in the last frame
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+};
+
+// Sink that writes a frame to stdout with a single fwrite + flush
+inline void stdoutSink(const char* data, std::size_t size) {
+    std::fwrite(data, 1, size, stdout);
+    std::fflush(stdout);
+}
+
+// Sink that discards frames (benchmarks measure rendering cost without a terminal)
+inline void nullSink(const char*, std::size_t) {}
+
+// --- Maze view ---
+// Draws a game (MazeSim, or any fixed-size BasicMazeGame) into a renderer's back frame: a title line, the board (each cell two
+// columns wide, "P " / "# " like the classic display) and the status line. Boards larger
+// than the viewport are shown through a window centred on the player. 'footerRows' blank
+// rows are added below the status line for the caller's own messages (the real-time loop
+// has no prompt area under the frame); the frame is then at least a full view wide, so
+// messages of any length don't resize it.
+
+const unsigned char COLOR_WALL = 13;   // Magenta / Purple
+const unsigned char COLOR_PLAYER = 14; // Yellow
+const unsigned char COLOR_ENEMY = 12;  // Bright Red
+const unsigned char COLOR_ITEM = 11;   // Bright Cyan / Yellowish
+const unsigned char COLOR_EXIT = 10;   // Bright Green
+
+const int DEFAULT_VIEW_ROWS = 30; // Max board rows shown at once
+const int DEFAULT_VIEW_COLS = 40; // Max board columns shown at once (80 terminal columns)
+
+template <int W, int H>
+inline void drawMazeFrame(FrameRenderer& renderer, const BasicMazeGame<W, H>& sim,
+                          int viewRows = DEFAULT_VIEW_ROWS, int viewCols = DEFAULT_VIEW_COLS, int footerRows = 0) {
+    const MazeGrid& maze = sim.getGrid();
+    const int rows = maze.getRows() < viewRows ? maze.getRows() : viewRows;
+    const int cols = maze.getCols() < viewCols ? maze.getCols() : viewCols;
+
+    // Window origin: centre on the player, clamped to the board
+    int top = sim.getPlayerX() - rows / 2;
+    int left = sim.getPlayerY() - cols / 2;
+    if (top > maze.getRows() - rows) top = maze.getRows() - rows;
+    if (left > maze.getCols() - cols) left = maze.getCols() - cols;
+    if (top < 0) top = 0;
+    if (left < 0) left = 0;
+
+    std::string status = "Score: " + std::to_string(sim.getScore()) +
+                         " | Moves: " + std::to_string(sim.getMoves()) +
+                         " | Collectibles left: " + std::to_string(sim.getCollectiblesRemaining());
+    if (sim.getParMoves() >= 0) status += " | Par: " + std::to_string(sim.getLevelMoves()) + "/" + std::to_string(sim.getParMoves());
+    int width = cols * 2;
+    if (static_cast<int>(status.size()) > width) width = static_cast<int>(status.size());
+    if (footerRows > 0 && width < viewCols * 2) width = viewCols * 2;
+    renderer.beginFrame(width, rows + 2 + (footerRows > 0 ? footerRows : 0));
+
+    renderer.text(0, 0, "--- Maze Game --- Level: " + std::to_string(sim.getLevel()) + " ---");
+
+    // Board cells
+    for (int i = 0; i < rows; i++) {
+        const char* row = maze.row(top + i) + left;
+        for (int j = 0; j < cols; j++) {
+            char cell = row[j];
+            unsigned char color = COLOR_DEFAULT;
+            if (cell == '#') color = COLOR_WALL;
+            else if (cell == '*') color = COLOR_ITEM;
+            else if (cell == 'E') color = COLOR_EXIT;
+            renderer.put(1 + i, j * 2, cell, color);
+        }
+    }
+
+    // Enemies come from the occupancy index: one O(1) lookup per visible cell,
+    // however many enemies exist on the rest of the board
+    const OccupancyGrid& occupancy = sim.getOccupancy();
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            int id = occupancy.firstAt(top + i, left + j);
+            if (id >= 0) renderer.put(1 + i, j * 2, ENEMY_SYMBOL, COLOR_ENEMY);
+        }
+    }
+    const Player& player = sim.getPlayer();
+    renderer.put(1 + player.getX() - top, (player.getY() - left) * 2, player.getSymbol(), COLOR_PLAYER);
+
+    renderer.text(rows + 1, 0, status);
+}
+
+#endif // MAZE_RENDERER_H
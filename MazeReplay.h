@@ -0,0 +1,266 @@
+// MazeReplay.h
+#ifndef MAZE_REPLAY_H // Start of include guard
+#define MAZE_REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MazeSave.h" // Embedded starting state, snapshots for keyframes
+#include "MazeSim.h"  // The game being recorded / replayed
+
+// Input recording and replay.
+// The sim is deterministic: given its starting state and settings, the sequence of
+// actions fixes everything else (levels depend on (seed, level), enemies on (seed, tick,
+// id)). So a session is recorded as its starting state plus one entry per action:
+//
+//   ReplayHeader  - magic, version, seed, settings, sizes
+//   start state   - a complete binary save (MazeSave.h) of the game when recording began
+//   actions       - 2 bits per action (up, down, left, right), four to a byte, LSB first
+//
+// Real-time sessions (MazeSim::setTurnBased(false)) also have to log when enemies moved, so
+// their entries are 4 bits, two to a byte: 0 = enemy step, otherwise the SimAction.
+// An hour of play is a few KB on top of the start state. The log is flushed every
+// FLUSH_EVERY actions (header count included), so a crash loses at most that many.
+
+const char REPLAY_MAGIC[8] = {'M', 'A', 'Z', 'E', 'R', 'E', 'P', 'L'};
+const std::uint32_t REPLAY_VERSION = 2; // 2: + flags (version 1 logs are all turn-based)
+const std::uint8_t REPLAY_REAL_TIME = 1; // ReplayHeader::flags: 4-bit entries with enemy steps
+
+struct ReplayHeader {
+    char magic[8];             // REPLAY_MAGIC
+    std::uint32_t version;     // REPLAY_VERSION
+    std::uint32_t headerBytes; // sizeof(ReplayHeader) when written
+    std::uint64_t seed;        // Game seed (also in the start state; here for quick inspection)
+    std::uint64_t stateBytes;  // Size of the embedded start state
+    std::uint64_t actionCount; // Actions recorded so far
+    std::uint32_t chaseRadius; // Settings that change how the game plays out
+    std::uint8_t behavior, conflictPolicy, algorithm;
+    std::uint8_t flags;        // REPLAY_REAL_TIME (was reserved, always 0, in version 1)
+};
+static_assert(sizeof(ReplayHeader) % 8 == 0, "start state stays 8-byte aligned");
+
+// Appends the player's actions to a replay log as the game is played
+class InputRecorder {
+private:
+    static constexpr std::uint64_t FLUSH_EVERY = 256;
+
+    std::FILE* file;
+    std::uint64_t count;
+    unsigned char pending; // Entries waiting for the rest of their byte
+    std::uint64_t lastFlush;
+    unsigned bits;         // Bits per entry: 2 (turn-based) or 4 (real-time)
+
+    void append(unsigned code) {
+        const unsigned perByte = 8 / bits;
+        pending |= static_cast<unsigned char>(code << (bits * (count % perByte)));
+        count++;
+        if (count % perByte == 0) {
+            std::fputc(pending, file);
+            pending = 0;
+        }
+        if (count - lastFlush >= FLUSH_EVERY) flush();
+    }
+
+public:
+    InputRecorder() : file(nullptr), count(0), pending(0), lastFlush(0), bits(2) {}
+    ~InputRecorder() { stop(); }
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    // Start a new log in 'filename' from the current state of 'sim' (any previous log is closed)
+    bool start(const std::string& filename, const MazeSim& sim, std::string* error = nullptr) {
+        stop();
+        file = std::fopen(filename.c_str(), "wb");
+        if (!file) {
+            if (error) *error = "Could not open file " + filename + " for recording!";
+            return false;
+        }
+        const SaveSnapshot state = sim.snapshot();
+        ReplayHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+        header.version = REPLAY_VERSION;
+        header.headerBytes = sizeof(ReplayHeader);
+        header.seed = sim.getSeed();
+        header.stateBytes = finishSaveHeader(state).fileBytes;
+        header.chaseRadius = sim.getChaseRadius();
+        header.behavior = static_cast<std::uint8_t>(sim.getEnemyBehavior());
+        header.conflictPolicy = static_cast<std::uint8_t>(sim.getEnemyConflictPolicy());
+        header.algorithm = static_cast<std::uint8_t>(sim.getMazeAlgorithm());
+        header.flags = sim.isTurnBased() ? 0 : REPLAY_REAL_TIME;
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1 || !writeSaveData(file, state) || std::fflush(file) != 0) {
+            if (error) *error = "Error writing replay log " + filename + ".";
+            stop();
+            return false;
+        }
+        count = 0;
+        pending = 0;
+        lastFlush = 0;
+        bits = sim.isTurnBased() ? 2 : 4;
+        return true;
+    }
+
+    bool isRecording() const { return file != nullptr; }
+    std::uint64_t actionCount() const { return count; } // Entries, enemy steps included
+
+    // Log one action as it is handed to MazeSim::step(); ACTION_NONE is not logged (step ignores it)
+    void record(SimAction action) {
+        if (!file || action < ACTION_UP || action > ACTION_RIGHT) return;
+        append(bits == 2 ? action - ACTION_UP : action);
+    }
+
+    // Log a MazeSim::tickEnemies() call (real-time logs only; turn-based games never make one)
+    void recordEnemyStep() {
+        if (file && bits == 4) append(0);
+    }
+
+    // Make everything recorded so far readable: the partial last byte is written (and
+    // rewritten once it fills up) and the header's count is brought up to date
+    void flush() {
+        if (!file) return;
+        if (count % (8 / bits)) {
+            std::fputc(pending, file);
+            std::fseek(file, -1, SEEK_CUR);
+        }
+        const long end = std::ftell(file);
+        std::fseek(file, static_cast<long>(offsetof(ReplayHeader, actionCount)), SEEK_SET);
+        std::fwrite(&count, sizeof(count), 1, file);
+        std::fseek(file, end, SEEK_SET);
+        std::fflush(file);
+        lastFlush = count;
+    }
+
+    void stop() {
+        if (!file) return;
+        flush();
+        std::fclose(file);
+        file = nullptr;
+    }
+};
+
+// Plays a replay log back headless, as fast as the sim runs. seek() can jump to any step:
+// while playing forward it keeps a keyframe (MazeSim::snapshot()) every 'interval' steps,
+// so jumping back - or forward into ground already covered - restores the nearest
+// keyframe and simulates at most interval - 1 steps. Keyframes on the same level share
+// their wall plane, so each costs O(items + enemies) memory.
+class ReplayPlayer {
+private:
+    ReplayHeader header;
+    std::vector<unsigned char> actions;    // Packed, 'bits' bits per entry
+    unsigned bits;
+    std::uint64_t count;
+    std::unique_ptr<MazeSim> sim;
+    std::uint64_t position;                // Actions applied to 'sim' so far
+    std::uint64_t interval;                // Steps between keyframes (0 = no keyframes)
+    std::vector<SaveSnapshot> keyframes;   // keyframes[k]: state after k * interval actions
+
+    // Back to keyframe 'k' (0 = the start state)
+    void restoreKeyframe(std::size_t k) {
+        sim->restore(keyframes[k]);
+        position = k * interval;
+    }
+
+public:
+    ReplayPlayer() : bits(2), count(0), position(0), interval(4096) { std::memset(&header, 0, sizeof(header)); }
+
+    // Steps between keyframes; takes effect for keyframes recorded from now on (0 = none)
+    void setKeyframeInterval(std::uint64_t steps) {
+        interval = steps;
+        if (!keyframes.empty()) keyframes.resize(1);
+    }
+
+    // Read a log and set the game up at step 0. False (and 'error') if it is not a valid log.
+    bool open(const std::string& filename, std::string* error = nullptr) {
+        MappedFile file;
+        if (!file.open(filename)) {
+            if (error) *error = "Could not open replay log " + filename + "!";
+            return false;
+        }
+        const unsigned char* data = file.data();
+        const std::size_t bytes = file.size();
+        if (bytes < sizeof(ReplayHeader) || std::memcmp(data, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) {
+            if (error) *error = filename + " is not a replay log.";
+            return false;
+        }
+        ReplayHeader loaded;
+        std::memcpy(&loaded, data, sizeof(loaded));
+        if (loaded.version < 1 || loaded.version > REPLAY_VERSION || loaded.headerBytes != sizeof(ReplayHeader) ||
+            loaded.stateBytes > bytes - sizeof(ReplayHeader)) {
+            if (error) *error = "Unsupported or truncated replay log " + filename + ".";
+            return false;
+        }
+        const std::size_t actionBytes = bytes - sizeof(ReplayHeader) - static_cast<std::size_t>(loaded.stateBytes);
+        const bool realTime = (loaded.flags & REPLAY_REAL_TIME) != 0;
+        if (loaded.actionCount > static_cast<std::uint64_t>(actionBytes) * (realTime ? 2 : 4)) {
+            if (error) *error = "Replay log " + filename + " is missing actions.";
+            return false;
+        }
+
+        std::unique_ptr<MazeSim> game(new MazeSim(MIN_MAZE_DIMENSION, loaded.seed));
+        game->setEnemyConflictPolicy(static_cast<EnemyConflictPolicy>(loaded.conflictPolicy));
+        game->setMazeAlgorithm(static_cast<MazeAlgorithm>(loaded.algorithm));
+        game->setChaseRadius(loaded.chaseRadius);
+        game->setEnemyBehavior(static_cast<EnemyBehavior>(loaded.behavior));
+        game->setTurnBased(!realTime);
+        const unsigned char* state = data + sizeof(ReplayHeader);
+        if (!game->loadSaveData(state, static_cast<std::size_t>(loaded.stateBytes), error)) return false;
+
+        header = loaded;
+        actions.assign(state + loaded.stateBytes, data + bytes);
+        bits = realTime ? 4 : 2;
+        count = loaded.actionCount;
+        sim.swap(game);
+        position = 0;
+        keyframes.clear();
+        keyframes.push_back(sim->snapshot());
+        return true;
+    }
+
+    std::uint64_t actionCount() const { return count; }
+    std::uint64_t getPosition() const { return position; }
+    std::size_t keyframeCount() const { return keyframes.size(); }
+    const ReplayHeader& getHeader() const { return header; }
+    MazeSim& getSim() { return *sim; }
+
+    // Entry 'i' of the log; ACTION_NONE stands for an enemy step (real-time logs)
+    SimAction actionAt(std::uint64_t i) const {
+        const unsigned perByte = 8 / bits;
+        const unsigned code = (actions[i / perByte] >> (bits * (i % perByte))) & ((1u << bits) - 1);
+        return static_cast<SimAction>(bits == 2 ? ACTION_UP + code : code);
+    }
+
+    // Move the game to the state after 'target' actions (clamped to the log). Returns the
+    // position reached.
+    std::uint64_t seek(std::uint64_t target) {
+        if (!sim) return 0;
+        if (target > count) target = count;
+        if (interval) {
+            // Nearest keyframe at or before the target, if it beats carrying on from here
+            std::size_t k = static_cast<std::size_t>(target / interval);
+            if (k >= keyframes.size()) k = keyframes.size() - 1;
+            if (target < position || k * interval > position) restoreKeyframe(k);
+        } else if (target < position) {
+            restoreKeyframe(0);
+        }
+        while (position < target) {
+            const SimAction action = actionAt(position);
+            if (action == ACTION_NONE) sim->tickEnemies();
+            else sim->step(action);
+            position++;
+            if (interval && position % interval == 0 && position / interval == keyframes.size()) {
+                keyframes.push_back(sim->snapshot());
+            }
+        }
+        return position;
+    }
+
+    // Play the whole log
+    std::uint64_t run() { return seek(count); }
+};
+
+#endif // MAZE_REPLAY_H
@@ -0,0 +1,260 @@
+// MazeSave.h
+#ifndef MAZE_SAVE_H // Start of include guard
+#define MAZE_SAVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Pieces of the binary save format used by MazeSim::saveGame / loadGame.
+//
+// File layout (little-endian, every section 8-byte aligned):
+//   SaveHeader        - magic, version, sizes, game stats, section offsets, CRC-32
+//   wall plane        - rows * wordsPerRow uint64 words, exactly MazeGrid's bit plane
+//   collectible list  - itemCount (x, y) int32 pairs; only '*' squares are stored
+//   enemy array       - enemyCount int32 x values, then enemyCount int32 y values (EnemyStore's SoA)
+// Everything that is not a wall, an item or the exit is an open square, so the grid needs
+// no per-cell characters on disk: a 10k x 10k board is 12.5 MB instead of 100 MB of text.
+// The CRC covers the whole file (header included, its crc field taken as zero).
+
+const char SAVE_MAGIC[8] = {'M', 'A', 'Z', 'E', 'S', 'A', 'V', 'E'};
+const std::uint32_t SAVE_VERSION = 3;            // 2: + levelRngState, 3: + parMoves, levelStartMoves
+const std::uint32_t SAVE_HEADER_BYTES_V1 = 128;  // Version 1 headers end before levelRngState
+const std::uint32_t SAVE_HEADER_BYTES_V2 = 136;  // Version 2 headers end before parMoves
+const std::uint32_t SAVE_BYTE_ORDER = 0x01020304; // Reads back differently on a big-endian machine
+
+struct SaveHeader {
+    char magic[8];            // SAVE_MAGIC
+    std::uint32_t version;    // SAVE_VERSION; readers reject versions they don't know
+    std::uint32_t headerBytes; // sizeof(SaveHeader) when written
+    std::uint32_t byteOrder;  // SAVE_BYTE_ORDER as written by the saving machine
+    std::uint32_t crc;        // CRC-32 of the whole file with this field zeroed
+    std::uint64_t fileBytes;  // Total size, so truncation is caught before the CRC pass
+    std::int32_t rows, cols;
+    std::int32_t level, score, moves, collectibles;
+    std::int32_t playerX, playerY;
+    std::int32_t exitX, exitY; // -1 when the board has no exit square
+    std::uint64_t seed;       // Game seed and enemy tick: a loaded game plays on identically
+    std::uint32_t tick;
+    std::uint32_t reserved;
+    std::uint64_t wallOffset;
+    std::uint64_t itemOffset, itemCount;
+    std::uint64_t enemyOffset, enemyCount;
+    std::uint64_t levelRngState; // Item / enemy placement stream, so a restored game draws the same squares
+    std::int32_t parMoves;       // The level's par (-1 = none), and the move count it started at
+    std::int32_t levelStartMoves;
+};
+static_assert(sizeof(SaveHeader) % 8 == 0, "sections after the header must stay 8-byte aligned");
+static_assert(offsetof(SaveHeader, levelRngState) == SAVE_HEADER_BYTES_V1, "fields are only ever appended");
+static_assert(offsetof(SaveHeader, parMoves) == SAVE_HEADER_BYTES_V2, "fields are only ever appended");
+
+inline bool hasSaveMagic(const void* data, std::size_t bytes) {
+    return bytes >= sizeof(SAVE_MAGIC) && std::memcmp(data, SAVE_MAGIC, sizeof(SAVE_MAGIC)) == 0;
+}
+
+// CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320), slicing-by-8: eight table lookups
+// per 8 input bytes instead of one per byte, so checking a save runs at GB/s rather than
+// becoming the slow part of loading.
+class Crc32 {
+private:
+    std::uint32_t table[8][256];
+
+    Crc32() {
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+            table[0][i] = c;
+        }
+        for (std::uint32_t i = 0; i < 256; i++) {
+            for (int t = 1; t < 8; t++) table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+        }
+    }
+
+    static const Crc32& instance() {
+        static const Crc32 crc; // Built once, thread-safe since C++11
+        return crc;
+    }
+
+public:
+    // Continue a running CRC ('crc' = 0 to start) over 'bytes' more bytes
+    static std::uint32_t update(std::uint32_t crc, const void* data, std::size_t bytes) {
+        const std::uint32_t (*t)[256] = instance().table;
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        crc = ~crc;
+        while (bytes >= 8) {
+            std::uint32_t lo, hi;
+            std::memcpy(&lo, p, 4); // Little-endian loads (see SAVE_BYTE_ORDER)
+            std::memcpy(&hi, p + 4, 4);
+            lo ^= crc;
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                  t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+            p += 8;
+            bytes -= 8;
+        }
+        while (bytes--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        return ~crc;
+    }
+};
+
+// Read-only view of a whole file. On POSIX systems the file is mmap'ed, so the loader
+// parses straight out of the page cache with no intermediate buffer; elsewhere it falls
+// back to one read into memory.
+class MappedFile {
+private:
+    const unsigned char* bytes;
+    std::size_t length;
+#if defined(_WIN32)
+    std::vector<unsigned char> buffer;
+#endif
+
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename) {
+        close();
+#if defined(_WIN32)
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return false;
+        buffer.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        if (!buffer.empty() && !file.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) return false;
+        bytes = buffer.data();
+        length = buffer.size();
+        return true;
+#else
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (::fstat(fd, &info) != 0) { ::close(fd); return false; }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) { ::close(fd); length = 0; return false; }
+            ::madvise(mapped, length, MADV_SEQUENTIAL); // One front-to-back pass: read ahead aggressively
+            bytes = static_cast<const unsigned char*>(mapped);
+        }
+        ::close(fd); // The mapping stays valid without the descriptor
+        return true;
+#endif
+    }
+
+    void close() {
+#if defined(_WIN32)
+        buffer.clear();
+#else
+        if (bytes) ::munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+};
+
+// Everything a save file holds, captured in memory. Taking one is cheap - the wall plane is
+// shared copy-on-write with the live grid (MazeGrid::shareWallPlane), items are a short
+// list, enemies two arrays - so the game thread can hand it to a background writer
+// (AutoSave.h) and carry on while the file is written.
+struct SaveSnapshot {
+    SaveHeader header; // Game fields filled in by MazeSim::snapshot(); the rest by writeSaveFile
+    std::shared_ptr<const std::uint64_t[]> walls; // rows * wordsPerRow words
+    std::vector<std::int32_t> items;              // x, y pairs
+    std::vector<std::int32_t> enemyXs, enemyYs;
+};
+
+// Header for 'snapshot' with the format fields, section offsets and CRC filled in
+inline SaveHeader finishSaveHeader(const SaveSnapshot& snapshot) {
+    SaveHeader header = snapshot.header;
+    std::memcpy(header.magic, SAVE_MAGIC, sizeof(SAVE_MAGIC));
+    header.version = SAVE_VERSION;
+    header.headerBytes = sizeof(SaveHeader);
+    header.byteOrder = SAVE_BYTE_ORDER;
+    header.crc = 0;
+    const std::size_t wallBytes = static_cast<std::size_t>(header.rows) * ((static_cast<std::size_t>(header.cols) + 63) / 64) *
+                                  sizeof(std::uint64_t);
+    const std::size_t itemBytes = snapshot.items.size() * sizeof(std::int32_t);
+    const std::size_t enemyBytes = snapshot.enemyXs.size() * sizeof(std::int32_t);
+    header.wallOffset = sizeof(SaveHeader);
+    header.itemOffset = header.wallOffset + wallBytes; // Whole words, so still 8-byte aligned
+    header.itemCount = snapshot.items.size() / 2;
+    header.enemyOffset = header.itemOffset + itemBytes;
+    header.enemyCount = snapshot.enemyXs.size();
+    header.fileBytes = header.enemyOffset + 2 * enemyBytes;
+
+    // Everything is in memory already, so the CRC goes into the header before anything is written
+    std::uint32_t crc = Crc32::update(0, &header, sizeof(header));
+    crc = Crc32::update(crc, snapshot.walls.get(), wallBytes);
+    crc = Crc32::update(crc, snapshot.items.data(), itemBytes);
+    crc = Crc32::update(crc, snapshot.enemyXs.data(), enemyBytes);
+    crc = Crc32::update(crc, snapshot.enemyYs.data(), enemyBytes);
+    header.crc = crc;
+    return header;
+}
+
+// Append a complete save (header + sections, header.fileBytes in all) for 'snapshot' to an
+// open file. Also used to embed a starting state in other files (see MazeReplay.h).
+inline bool writeSaveData(std::FILE* file, const SaveSnapshot& snapshot) {
+    const SaveHeader header = finishSaveHeader(snapshot);
+    const std::size_t wallBytes = static_cast<std::size_t>(header.itemOffset - header.wallOffset);
+    const std::size_t itemBytes = snapshot.items.size() * sizeof(std::int32_t);
+    const std::size_t enemyBytes = snapshot.enemyXs.size() * sizeof(std::int32_t);
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && wallBytes) ok = std::fwrite(snapshot.walls.get(), wallBytes, 1, file) == 1;
+    if (ok && itemBytes) ok = std::fwrite(snapshot.items.data(), itemBytes, 1, file) == 1;
+    if (ok && enemyBytes) {
+        ok = std::fwrite(snapshot.enemyXs.data(), enemyBytes, 1, file) == 1 &&
+             std::fwrite(snapshot.enemyYs.data(), enemyBytes, 1, file) == 1;
+    }
+    return ok;
+}
+
+// Write 'snapshot' to 'filename' atomically: the file is written to filename + ".tmp",
+// flushed to disk and then renamed over the old save, so a crash or a full disk mid-write
+// leaves the previous save intact. Returns false (and fills 'error') on failure.
+inline bool writeSaveFile(const SaveSnapshot& snapshot, const std::string& filename, std::string* error = nullptr) {
+    const std::string tempName = filename + ".tmp";
+    std::FILE* file = std::fopen(tempName.c_str(), "wb");
+    if (!file) {
+        if (error) *error = "Could not open file " + tempName + " for saving!";
+        return false;
+    }
+    bool ok = writeSaveData(file, snapshot);
+    ok = std::fflush(file) == 0 && ok;
+#if !defined(_WIN32)
+    ok = ok && ::fsync(::fileno(file)) == 0; // On disk before the rename makes it the save
+#endif
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(tempName.c_str());
+        if (error) *error = "Error writing save file " + tempName + ".";
+        return false;
+    }
+#if defined(_WIN32)
+    std::remove(filename.c_str()); // rename() does not replace an existing file here
+#endif
+    if (std::rename(tempName.c_str(), filename.c_str()) != 0) {
+        std::remove(tempName.c_str());
+        if (error) *error = "Could not replace " + filename + " with the new save.";
+        return false;
+    }
+    return true;
+}
+
+#endif // MAZE_SAVE_H
@@ -0,0 +1,394 @@
+// MazeServer.cpp
+// Multi-session game server and its load generator (Linux):
+//
+//   MazeServer serve [address] [boardSize] [workers]        - host games until Ctrl+C
+//   MazeServer load [address|self] [sessions] [keys] [keysPerSecond] [boardSize] [workers]
+//                                                           - p50 / p99 key latency over many sessions
+//
+// Addresses are unix:/path or tcp:PORT (loopback only); see MazeServer.h for the protocol.
+// "load self" starts a server in this process on a temporary Unix socket first, using
+// boardSize / workers, so one command measures the whole round trip. keysPerSecond paces each
+// session like a person at the keyboard; 0 sends every key as soon as the last one is
+// answered, which measures queueing at full load rather than per-key cost.
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "MazeServer.h"      // GameServer + frame format
+#include "Instrumentation.h" // LatencyHistogram
+
+using namespace std;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) { stopRequested = 1; }
+
+// Every session is a descriptor on both ends: lift the soft limit as far as the hard one allows
+static size_t raiseDescriptorLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return 1024;
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    return static_cast<size_t>(limit.rlim_cur);
+}
+
+// Resident set size of this process, from /proc
+static size_t residentBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long pages = 0, resident = 0;
+    const int n = fscanf(f, "%lu %lu", &pages, &resident);
+    fclose(f);
+    return n == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+// Peak resident set size (VmHWM), from /proc
+static size_t peakResidentBytes() {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmHWM: %zu kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb * 1024;
+}
+
+static int runServe(const string& address, int boardSize, unsigned workers) {
+    raiseDescriptorLimit();
+    const size_t baseline = residentBytes();
+    GameServer server(boardSize, workers, static_cast<uint64_t>(time(0)));
+    string error;
+    if (!server.start(address, &error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+    cout << "listening    : " << address << " (" << server.workerCount() << " workers, " << boardSize << " x "
+         << boardSize << " boards) - Ctrl+C to stop" << endl;
+
+    uint64_t lastKeys = 0;
+    auto last = chrono::steady_clock::now();
+    while (!stopRequested) {
+        this_thread::sleep_for(chrono::milliseconds(200));
+        const auto now = chrono::steady_clock::now();
+        if (now - last < chrono::seconds(5)) continue;
+        const uint64_t keys = server.keysHandled();
+        const size_t sessions = server.sessionCount();
+        if (keys != lastKeys || sessions) {
+            const double seconds = chrono::duration<double>(now - last).count();
+            const size_t rss = residentBytes();
+            printf("sessions %6zu | keys/s %10.0f | RSS %7.1f MB (%.1f KB per session)\n", sessions,
+                   (keys - lastKeys) / seconds, rss / 1048576.0,
+                   sessions && rss > baseline ? (rss - baseline) / 1024.0 / sessions : 0.0);
+            fflush(stdout);
+        }
+        lastKeys = keys;
+        last = now;
+    }
+    server.stop();
+    cout << "\nkeys handled : " << server.keysHandled() << " (peak " << server.peakSessionCount() << " sessions)\n";
+    cout << "frames sent  : " << server.fullFrames() << " full, " << server.deltaFrames() << " delta, "
+         << server.bytesSent() << " bytes" << endl;
+    return 0;
+}
+
+// One simulated player: waits for the reply to its last key before sending the next
+struct LoadClient {
+    int fd;
+    vector<unsigned char> in; // Bytes received, not yet parsed into frames
+    size_t keysLeft;
+    bool awaitingReply;
+    bool quitting;
+    bool caught;
+    chrono::steady_clock::time_point sentAt;
+    chrono::steady_clock::time_point nextAt; // When a paced client sends its next key
+    int rows, cols;
+    vector<char> board; // Mirror built from full frames + deltas, to check the deltas
+};
+
+struct LoadTotals {
+    LatencyHistogram latencyNs;
+    uint64_t fullFrames = 0, deltaFrames = 0, deltaBytes = 0, mismatches = 0, finished = 0, failed = 0;
+};
+
+// Apply one frame to the client's mirror. Returns false on a malformed frame.
+static bool applyFrame(LoadClient& c, const unsigned char* frame, size_t length, LoadTotals& totals) {
+    if (length + 4 < FRAME_HEADER_BYTES) return false;
+    const unsigned char type = frame[0];
+    const unsigned events = frame[1];
+    const int px = static_cast<int>(readU16(frame + 2)), py = static_cast<int>(readU16(frame + 4));
+    const unsigned char* body = frame + FRAME_HEADER_BYTES - 4;
+    const size_t bodyBytes = length + 4 - FRAME_HEADER_BYTES;
+    if (type == FRAME_BYE) return true;
+    if (type == FRAME_FULL) {
+        if (bodyBytes < 4) return false;
+        c.rows = static_cast<int>(readU16(body));
+        c.cols = static_cast<int>(readU16(body + 2));
+        if (bodyBytes != 4 + static_cast<size_t>(c.rows) * c.cols) return false;
+        c.board.assign(body + 4, body + bodyBytes);
+        totals.fullFrames++;
+    } else if (type == FRAME_DELTA) {
+        if (bodyBytes < 2) return false;
+        const size_t count = readU16(body);
+        if (bodyBytes != 2 + count * DELTA_CELL_BYTES || c.board.empty()) return false;
+        for (size_t k = 0; k < count; k++) {
+            const unsigned char* cell = body + 2 + k * DELTA_CELL_BYTES;
+            const int x = static_cast<int>(readU16(cell)), y = static_cast<int>(readU16(cell + 2));
+            if (x >= c.rows || y >= c.cols) return false;
+            c.board[static_cast<size_t>(x) * c.cols + y] = static_cast<char>(cell[4]);
+        }
+        totals.deltaFrames++;
+        totals.deltaBytes += length + 4;
+    } else {
+        return false;
+    }
+    // The mirror must show the player where the header says it is
+    if (px >= c.rows || py >= c.cols || c.board[static_cast<size_t>(px) * c.cols + py] != 'P') totals.mismatches++;
+    if (events & EVENT_CAUGHT) c.caught = true;
+    return true;
+}
+
+static int runLoad(string address, size_t sessions, size_t keysPerSession, double keysPerSecond, int boardSize,
+                   unsigned workers) {
+    const size_t descriptors = raiseDescriptorLimit();
+    unique_ptr<GameServer> local;
+    if (address == "self") {
+        address = "unix:/tmp/mazeserver_load_" + to_string(getpid()) + ".sock";
+        // Both ends of every connection live in this process
+        if (sessions * 2 + 64 > descriptors) {
+            sessions = descriptors > 64 ? (descriptors - 64) / 2 : 1;
+            cerr << "Descriptor limit " << descriptors << ": running " << sessions << " sessions" << endl;
+        }
+        local.reset(new GameServer(boardSize, workers, 2024));
+        string error;
+        if (!local->start(address, &error)) {
+            cerr << error << endl;
+            return 1;
+        }
+    } else if (sessions + 64 > descriptors) {
+        sessions = descriptors > 64 ? descriptors - 64 : 1;
+        cerr << "Descriptor limit " << descriptors << ": running " << sessions << " sessions" << endl;
+    }
+    ServerAddress target;
+    string error;
+    if (!parseServerAddress(address, target, &error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    const size_t rssBefore = residentBytes();
+
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    vector<LoadClient> clients(sessions);
+    auto connectStart = chrono::steady_clock::now();
+    for (size_t i = 0; i < sessions; i++) {
+        LoadClient& c = clients[i];
+        c.fd = openServerSocket(target, false, &error); // Blocking connect: waits its turn in the backlog
+        if (c.fd < 0) {
+            cerr << "Session " << i << ": " << error << endl;
+            clients.resize(i);
+            break;
+        }
+        setNonBlocking(c.fd);
+        c.keysLeft = keysPerSession;
+        c.awaitingReply = true; // The welcome frame
+        c.quitting = c.caught = false;
+        c.rows = c.cols = 0;
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+    const double connectMs = chrono::duration<double, milli>(chrono::steady_clock::now() - connectStart).count();
+
+    LoadTotals totals;
+    mt19937 gen(7);
+    size_t open = clients.size();
+    // Mostly moves; now and then a save or a load, like a person playing
+    auto nextKey = [&](LoadClient& c) -> char {
+        if (c.caught) {
+            c.caught = false;
+            return 'n';
+        }
+        const unsigned r = gen() % 200;
+        if (r == 0) return 'v';
+        if (r == 1) return 'l';
+        return "wasd"[r % 4];
+    };
+    auto sendKey = [&](LoadClient& c, char key) {
+        c.sentAt = chrono::steady_clock::now();
+        c.awaitingReply = true;
+        if (send(c.fd, &key, 1, MSG_NOSIGNAL) != 1) {
+            totals.failed++;
+            c.awaitingReply = false;
+        }
+    };
+    auto sendNext = [&](LoadClient& c) {
+        if (c.keysLeft > 0) {
+            c.keysLeft--;
+            sendKey(c, nextKey(c));
+        } else if (!c.quitting) {
+            c.quitting = true;
+            sendKey(c, 'q');
+        }
+    };
+    auto closeClient = [&](LoadClient& c) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+        close(c.fd);
+        c.fd = -1;
+        open--;
+    };
+
+    // Paced sessions wait here for their next key's turn: (due time, client)
+    typedef chrono::steady_clock::time_point TimePoint;
+    priority_queue<pair<TimePoint, size_t>, vector<pair<TimePoint, size_t>>, greater<pair<TimePoint, size_t>>> due;
+    const chrono::nanoseconds period(keysPerSecond > 0 ? static_cast<long long>(1e9 / keysPerSecond) : 0);
+
+    const auto start = chrono::steady_clock::now();
+    vector<epoll_event> events(1024);
+    unsigned char buffer[65536];
+    while (open > 0) {
+        int timeoutMs = 5000;
+        if (!due.empty()) {
+            const auto wait = chrono::duration_cast<chrono::milliseconds>(due.top().first - chrono::steady_clock::now());
+            timeoutMs = wait.count() < 0 ? 0 : static_cast<int>(wait.count()) + 1;
+        }
+        const int n = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeoutMs);
+        if (n == 0 && due.empty()) {
+            cerr << "No reply for 5 s with " << open << " sessions still open" << endl;
+            break;
+        }
+        for (int e = 0; e < n; e++) {
+            LoadClient& c = clients[events[e].data.u64];
+            if (c.fd < 0) continue;
+            const ssize_t got = recv(c.fd, buffer, sizeof(buffer), 0);
+            if (got <= 0) {
+                if (got < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                if (!c.quitting) totals.failed++;
+                closeClient(c);
+                continue;
+            }
+            c.in.insert(c.in.end(), buffer, buffer + got);
+            size_t pos = 0;
+            bool bad = false;
+            while (c.in.size() - pos >= 4) {
+                const size_t length = readU32(&c.in[pos]);
+                if (c.in.size() - pos - 4 < length) break;
+                const unsigned char* frame = &c.in[pos + 4];
+                if (!applyFrame(c, frame, length, totals)) bad = true;
+                const bool bye = frame[0] == FRAME_BYE;
+                pos += 4 + length;
+                if (!c.awaitingReply) continue;
+                const auto now = chrono::steady_clock::now();
+                const bool welcome = c.keysLeft == keysPerSession && !c.quitting;
+                if (!welcome)
+                    totals.latencyNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(now - c.sentAt).count()));
+                c.awaitingReply = false;
+                if (bye) break;
+                if (period.count() == 0) {
+                    sendNext(c);
+                } else {
+                    // Keys on a fixed schedule (not "period after the reply"), starting at a
+                    // random point of the first period so sessions don't all fire together
+                    c.nextAt = welcome ? now + chrono::nanoseconds(gen() % period.count()) : c.nextAt + period;
+                    due.emplace(c.nextAt < now ? now : c.nextAt, static_cast<size_t>(events[e].data.u64));
+                }
+            }
+            c.in.erase(c.in.begin(), c.in.begin() + static_cast<ptrdiff_t>(pos));
+            if (bad) {
+                totals.failed++;
+                closeClient(c);
+            } else if (c.quitting && !c.awaitingReply) {
+                totals.finished++;
+                closeClient(c);
+            }
+        }
+        const auto now = chrono::steady_clock::now();
+        while (!due.empty() && due.top().first <= now) {
+            LoadClient& c = clients[due.top().second];
+            due.pop();
+            if (c.fd >= 0) sendNext(c);
+        }
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    const size_t rssPeak = peakResidentBytes();
+    for (LoadClient& c : clients) {
+        if (c.fd >= 0) close(c.fd);
+    }
+    close(epollFd);
+
+    const LatencyHistogram& h = totals.latencyNs;
+    cout << "sessions     : " << clients.size() << " connected in " << connectMs << " ms, " << totals.finished
+         << " finished, " << totals.failed << " failed\n";
+    cout << "keys         : " << h.count() << " in " << seconds << " s (" << h.count() / seconds << " keys/s)\n";
+    printf("latency (us) : p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  mean %.1f\n", h.percentile(0.5) / 1000.0,
+           h.percentile(0.9) / 1000.0, h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0, h.max() / 1000.0,
+           h.mean() / 1000.0);
+    cout << "frames       : " << totals.deltaFrames << " delta (" << (totals.deltaFrames ? totals.deltaBytes / totals.deltaFrames : 0)
+         << " bytes each on average), " << totals.fullFrames << " full\n";
+    cout << "board check  : " << (totals.mismatches ? to_string(totals.mismatches) + " frames DISAGREE with the header" : "every frame consistent") << "\n";
+    if (local) {
+        // Server sessions plus this client's per-session buffers: peak RSS over the run
+        printf("memory       : %.1f KB per session (server + client, %zu workers)\n",
+               rssPeak > rssBefore && !clients.empty() ? (rssPeak - rssBefore) / 1024.0 / clients.size() : 0.0,
+               static_cast<size_t>(local->workerCount()));
+        local->stop();
+    }
+    cout.flush();
+    return totals.failed || totals.mismatches ? 1 : 0;
+}
+
+static void printUsage() {
+    cerr << "Usage:\n"
+         << "  MazeServer serve [unix:/path | tcp:PORT] [boardSize] [workers]\n"
+         << "  MazeServer load [unix:/path | tcp:PORT | self] [sessions] [keysPerSession] [keysPerSecond] [boardSize] [workers]\n";
+}
+
+// Frames can't describe boards past GameServer::MAX_BOARD_SIZE; refuse them up front rather
+// than have the server quietly play a smaller one
+static bool boardSizeFits(int boardSize) {
+    if (boardSize <= GameServer::MAX_BOARD_SIZE) return true;
+    cerr << "boardSize " << boardSize << " is too large: frames carry coordinates as u16 (at most "
+         << GameServer::MAX_BOARD_SIZE << ")" << endl;
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    string mode = argv[1];
+    if (mode == "serve") {
+        string address = argc > 2 ? argv[2] : "tcp:7878";
+        int boardSize = argc > 3 ? atoi(argv[3]) : MAZE_DIMENSION;
+        unsigned workers = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : 0;
+        if (!boardSizeFits(boardSize)) return 1;
+        return runServe(address, boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, workers);
+    }
+    if (mode == "load") {
+        string address = argc > 2 ? argv[2] : "self";
+        size_t sessions = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000;
+        size_t keys = argc > 4 ? strtoull(argv[4], nullptr, 10) : 100;
+        double keysPerSecond = argc > 5 ? atof(argv[5]) : 0.0;
+        int boardSize = argc > 6 ? atoi(argv[6]) : MAZE_DIMENSION;
+        unsigned workers = argc > 7 ? static_cast<unsigned>(atoi(argv[7])) : 0;
+        if (!boardSizeFits(boardSize)) return 1;
+        return runLoad(address, sessions < 1 ? 1 : sessions, keys, keysPerSecond < 0 ? 0.0 : keysPerSecond,
+                       boardSize < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : boardSize, workers);
+    }
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,534 @@
+// MazeServer.h
+#ifndef MAZE_SERVER_H // Start of include guard
+#define MAZE_SERVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "MazeSim.h" // Headless game core, one per session
+
+// Many games in one process (Linux only: epoll). Clients connect over a Unix domain socket or
+// loopback TCP and send the console game's keys as single bytes:
+//   w a s d   move            v   save (to the session's own in-memory slot)
+//   n         new game        l   load that slot
+//   q         quit            anything else: ignored, but still answered
+// Every key is answered with exactly one frame, so a client always knows when its key has
+// been handled. The first frame after connecting is a full one.
+//
+// Frames are little-endian:
+//   u32 length          bytes after this field
+//   u8  type            FRAME_FULL / FRAME_DELTA / FRAME_BYE
+//   u8  events          SimEvent mask of the key (0 for non-moves)
+//   u16 playerX, playerY, collectiblesLeft
+//   i32 score, moves, level, par (-1 = none), levelMoves
+//   FULL : u16 rows, u16 cols, rows * cols glyphs ('#', ' ', '*', 'E', 'X', 'P')
+//   DELTA: u16 count, count * (u16 x, u16 y, u8 glyph) - only the squares whose glyph may
+//          have changed (where the player and the enemies were and are)
+//   BYE  : nothing; the server closes the connection after it
+// Boards are at most GameServer::MAX_BOARD_SIZE (65535) a side, so sizes and squares fit u16.
+// A move is usually a 40-60 byte delta. New levels, new games and loads send a full frame.
+//
+// Threads: 'workers' reactor threads, each with its own epoll set. All of them wait on the
+// listening socket (EPOLLEXCLUSIVE, so one is woken per connection) and a session stays on
+// the worker that accepted it, so sessions never share a lock and each worker runs its
+// sessions' keys back to back. A session reads at most MAX_KEYS_PER_TURN keys per wake-up and
+// a client that doesn't read its frames only stops its own session (no EPOLLIN until its
+// output drains), so one busy or slow client can't hold the others up. Game updates run
+// inline; keep boards small (a new level costs ~30 ms at 1001 x 1001).
+
+enum FrameType : unsigned char {
+    FRAME_FULL  = 1,
+    FRAME_DELTA = 2,
+    FRAME_BYE   = 3
+};
+
+const std::size_t FRAME_HEADER_BYTES = 32; // Including the length field
+const std::size_t DELTA_CELL_BYTES = 5;
+
+inline void appendU16(std::vector<unsigned char>& out, unsigned v) {
+    out.push_back(static_cast<unsigned char>(v));
+    out.push_back(static_cast<unsigned char>(v >> 8));
+}
+
+inline void appendU32(std::vector<unsigned char>& out, std::uint32_t v) {
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<unsigned char>(v >> shift));
+}
+
+inline std::uint32_t readU32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+inline unsigned readU16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+
+// What a client sees on (x, y): the player over enemies over the board itself
+inline char sessionGlyph(const MazeSim& sim, int x, int y) {
+    if (x == sim.getPlayerX() && y == sim.getPlayerY()) return 'P';
+    if (sim.getOccupancy().occupied(x, y)) return ENEMY_SYMBOL;
+    return sim.getGrid().at(x, y);
+}
+
+// Length placeholder, type, events and the status fields; the caller appends the body and
+// then calls finishFrame() to fill in the length
+inline std::size_t beginFrame(std::vector<unsigned char>& out, FrameType type, unsigned events, const MazeSim& sim) {
+    const std::size_t start = out.size();
+    appendU32(out, 0);
+    out.push_back(type);
+    out.push_back(static_cast<unsigned char>(events));
+    appendU16(out, static_cast<unsigned>(sim.getPlayerX()));
+    appendU16(out, static_cast<unsigned>(sim.getPlayerY()));
+    appendU16(out, static_cast<unsigned>(sim.getCollectiblesRemaining()));
+    appendU32(out, static_cast<std::uint32_t>(sim.getScore()));
+    appendU32(out, static_cast<std::uint32_t>(sim.getMoves()));
+    appendU32(out, static_cast<std::uint32_t>(sim.getLevel()));
+    appendU32(out, static_cast<std::uint32_t>(sim.getParMoves()));
+    appendU32(out, static_cast<std::uint32_t>(sim.getLevelMoves()));
+    return start;
+}
+
+inline void finishFrame(std::vector<unsigned char>& out, std::size_t start) {
+    const std::uint32_t length = static_cast<std::uint32_t>(out.size() - start - 4);
+    for (int k = 0; k < 4; k++) out[start + k] = static_cast<unsigned char>(length >> (8 * k));
+}
+
+inline void appendFullFrame(std::vector<unsigned char>& out, const MazeSim& sim, unsigned events) {
+    const std::size_t start = beginFrame(out, FRAME_FULL, events, sim);
+    const MazeGrid& grid = sim.getGrid();
+    appendU16(out, static_cast<unsigned>(grid.getRows()));
+    appendU16(out, static_cast<unsigned>(grid.getCols()));
+    for (int x = 0; x < grid.getRows(); x++) {
+        const char* row = grid.row(x);
+        out.insert(out.end(), row, row + grid.getCols());
+    }
+    // Entities on top, like the console renderer
+    const EnemyStore& enemies = sim.getEnemies();
+    const std::size_t board = out.size() - static_cast<std::size_t>(grid.getRows()) * grid.getCols();
+    for (std::size_t i = 0; i < enemies.size(); i++)
+        out[board + static_cast<std::size_t>(enemies.getX(i)) * grid.getCols() + enemies.getY(i)] = ENEMY_SYMBOL;
+    out[board + static_cast<std::size_t>(sim.getPlayerX()) * grid.getCols() + sim.getPlayerY()] = 'P';
+    finishFrame(out, start);
+}
+
+// 'cells' holds (x << 16 | y) for every square that may have changed; sorted and de-duplicated here
+inline void appendDeltaFrame(std::vector<unsigned char>& out, const MazeSim& sim, unsigned events,
+                             std::vector<std::uint32_t>& cells) {
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    const std::size_t start = beginFrame(out, FRAME_DELTA, events, sim);
+    appendU16(out, static_cast<unsigned>(cells.size()));
+    for (std::uint32_t cell : cells) {
+        const int x = static_cast<int>(cell >> 16), y = static_cast<int>(cell & 0xFFFF);
+        appendU16(out, static_cast<unsigned>(x));
+        appendU16(out, static_cast<unsigned>(y));
+        out.push_back(static_cast<unsigned char>(sessionGlyph(sim, x, y)));
+    }
+    finishFrame(out, start);
+}
+
+// "unix:/path/to/socket", "tcp:PORT" or "tcp:127.0.0.1:PORT". TCP is loopback only.
+struct ServerAddress {
+    bool unixSocket;
+    std::string path;
+    int port;
+};
+
+inline bool parseServerAddress(const std::string& text, ServerAddress& address, std::string* error = nullptr) {
+    address = ServerAddress{ false, "", 0 };
+    if (text.compare(0, 5, "unix:") == 0 && text.size() > 5) {
+        address.unixSocket = true;
+        address.path = text.substr(5);
+        if (address.path.size() >= sizeof(sockaddr_un().sun_path)) {
+            if (error) *error = "Socket path is too long: " + address.path;
+            return false;
+        }
+        return true;
+    }
+    std::string port = text.compare(0, 4, "tcp:") == 0 ? text.substr(4) : text;
+    if (port.compare(0, 10, "127.0.0.1:") == 0) port = port.substr(10);
+    address.port = std::atoi(port.c_str());
+    if (address.port <= 0 || address.port > 65535 || port.find_first_not_of("0123456789") != std::string::npos) {
+        if (error) *error = "Expected unix:/path, tcp:PORT or tcp:127.0.0.1:PORT, got \"" + text + "\".";
+        return false;
+    }
+    return true;
+}
+
+// Connected or listening socket for 'address' (-1 and 'error' on failure)
+inline int openServerSocket(const ServerAddress& address, bool listening, std::string* error = nullptr) {
+    const int fd = socket(address.unixSocket ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        if (error) *error = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+    sockaddr_un un;
+    sockaddr_in in;
+    sockaddr* sa;
+    socklen_t length;
+    if (address.unixSocket) {
+        std::memset(&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        std::memcpy(un.sun_path, address.path.c_str(), address.path.size());
+        sa = reinterpret_cast<sockaddr*>(&un);
+        length = sizeof(un);
+        if (listening) unlink(address.path.c_str()); // A socket file left by an earlier run
+    } else {
+        std::memset(&in, 0, sizeof(in));
+        in.sin_family = AF_INET;
+        in.sin_port = htons(static_cast<std::uint16_t>(address.port));
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sa = reinterpret_cast<sockaddr*>(&in);
+        length = sizeof(in);
+        int one = 1;
+        if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        else setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    const bool ok = listening ? bind(fd, sa, length) == 0 && listen(fd, SOMAXCONN) == 0 : connect(fd, sa, length) == 0;
+    if (!ok) {
+        if (error) *error = std::string(listening ? "bind/listen: " : "connect: ") + std::strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+inline bool setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+class GameServer {
+public:
+    static constexpr std::size_t MAX_KEYS_PER_TURN = 256;     // Keys read per session per wake-up
+    static constexpr std::size_t MAX_PENDING_OUTPUT = 1 << 16; // Stop reading a session past this much unsent output
+
+private:
+    struct Session {
+        int fd;
+        bool closing;                        // 'q' seen: close once the BYE frame is out
+        std::uint32_t watching;              // epoll events currently registered
+        std::size_t slot;                    // Index in the worker's session list
+        std::size_t outPos;                  // First unsent byte of 'out'
+        std::vector<unsigned char> out;      // Frames not yet written
+        std::unique_ptr<SaveSnapshot> saved; // 'v' slot (only allocated once used)
+        MazeSim sim;
+
+        Session(int socket, int boardSize, std::uint64_t seed)
+            : fd(socket), closing(false), watching(EPOLLIN), slot(0), outPos(0), sim(boardSize, seed) {}
+    };
+
+    struct Worker {
+        int epollFd;
+        std::thread thread;
+        std::vector<std::unique_ptr<Session>> sessions;
+        std::vector<std::uint32_t> cells; // Delta scratch
+        std::atomic<std::uint64_t> keys, bytesOut, fullFrames, deltaFrames;
+        std::atomic<std::size_t> sessionCount;
+
+        Worker() : epollFd(-1), keys(0), bytesOut(0), fullFrames(0), deltaFrames(0), sessionCount(0) {}
+    };
+
+    int boardSize;
+    std::uint64_t seed;
+    std::atomic<std::uint64_t> nextSession; // Seeds each new session's game
+    int listenFd;
+    int stopFd;                             // eventfd; readable once stop() is called
+    ServerAddress address;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> peakSessions;
+
+    // Tags telling the two special descriptors apart from sessions in epoll_event.data.ptr
+    static void* listenTag() { return reinterpret_cast<void*>(static_cast<std::uintptr_t>(1)); }
+    static void* stopTag() { return reinterpret_cast<void*>(static_cast<std::uintptr_t>(2)); }
+
+    void watch(Worker& w, Session& s, std::uint32_t events, int op) {
+        epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = &s;
+        epoll_ctl(w.epollFd, op, s.fd, &ev);
+    }
+
+    void acceptSessions(Worker& w) {
+        // A few per wake-up, so a burst of connections is spread over the workers
+        for (int k = 0; k < 16; k++) {
+            const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN (another worker took it) or out of descriptors
+            if (!address.unixSocket) {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            }
+            std::unique_ptr<Session> s(new Session(fd, boardSize, mix64(seed + nextSession.fetch_add(1, std::memory_order_relaxed))));
+            s->slot = w.sessions.size();
+            appendFullFrame(s->out, s->sim, EVENT_NONE);
+            w.fullFrames.fetch_add(1, std::memory_order_relaxed);
+            watch(w, *s, EPOLLIN, EPOLL_CTL_ADD);
+            w.sessions.push_back(std::move(s));
+            w.sessionCount.fetch_add(1, std::memory_order_relaxed);
+            const std::size_t total = sessionCount();
+            std::size_t peak = peakSessions.load(std::memory_order_relaxed);
+            while (total > peak && !peakSessions.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {}
+            flush(w, *w.sessions.back());
+        }
+    }
+
+    void closeSession(Worker& w, Session& s) {
+        epoll_ctl(w.epollFd, EPOLL_CTL_DEL, s.fd, nullptr);
+        close(s.fd);
+        const std::size_t slot = s.slot;
+        w.sessions[slot].swap(w.sessions.back());
+        w.sessions[slot]->slot = slot;
+        w.sessions.pop_back(); // Frees 's'
+        w.sessionCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Write what we can. Returns false if the session was closed.
+    bool flush(Worker& w, Session& s) {
+        while (s.outPos < s.out.size()) {
+            const ssize_t n = send(s.fd, s.out.data() + s.outPos, s.out.size() - s.outPos, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                closeSession(w, s);
+                return false;
+            }
+            s.outPos += static_cast<std::size_t>(n);
+            w.bytesOut.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+        }
+        if (s.outPos == s.out.size()) {
+            s.out.clear();
+            s.outPos = 0;
+            if (s.closing) {
+                closeSession(w, s);
+                return false;
+            }
+        }
+        // Unsent output: wait for the socket to drain, and past MAX_PENDING_OUTPUT stop taking
+        // this session's keys until it has
+        const std::size_t pending = s.out.size() - s.outPos;
+        const std::uint32_t wanted = pending == 0 ? EPOLLIN : pending < MAX_PENDING_OUTPUT ? EPOLLIN | EPOLLOUT : EPOLLOUT;
+        if (wanted != s.watching) {
+            s.watching = wanted;
+            watch(w, s, wanted, EPOLL_CTL_MOD);
+        }
+        return true;
+    }
+
+    // Apply one key and append its frame
+    void handleKey(Worker& w, Session& s, char key) {
+        MazeSim& sim = s.sim;
+        switch (key) {
+            case 'w': case 'a': case 's': case 'd':
+            case 'W': case 'A': case 'S': case 'D': {
+                // Where everything stands now: these squares may look different afterwards
+                std::vector<std::uint32_t>& cells = w.cells;
+                cells.clear();
+                const EnemyStore& enemies = sim.getEnemies();
+                cells.push_back(static_cast<std::uint32_t>(sim.getPlayerX()) << 16 | static_cast<std::uint32_t>(sim.getPlayerY()));
+                for (std::size_t i = 0; i < enemies.size(); i++)
+                    cells.push_back(static_cast<std::uint32_t>(enemies.getX(i)) << 16 | static_cast<std::uint32_t>(enemies.getY(i)));
+                const unsigned events = sim.step(actionFromKey(key));
+                if (events & EVENT_LEVEL_COMPLETE) {
+                    appendFullFrame(s.out, sim, events); // New board (and maybe a new enemy)
+                    w.fullFrames.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                cells.push_back(static_cast<std::uint32_t>(sim.getPlayerX()) << 16 | static_cast<std::uint32_t>(sim.getPlayerY()));
+                for (std::size_t i = 0; i < enemies.size(); i++)
+                    cells.push_back(static_cast<std::uint32_t>(enemies.getX(i)) << 16 | static_cast<std::uint32_t>(enemies.getY(i)));
+                appendDeltaFrame(s.out, sim, events, cells);
+                w.deltaFrames.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            case 'v': case 'V':
+                // A snapshot costs O(items + enemies); the wall plane is shared, not copied
+                s.saved.reset(new SaveSnapshot(sim.snapshot()));
+                break;
+            case 'l': case 'L':
+                if (s.saved && sim.restore(*s.saved)) {
+                    appendFullFrame(s.out, sim, EVENT_NONE);
+                    w.fullFrames.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                break;
+            case 'n': case 'N':
+                sim.newGame();
+                appendFullFrame(s.out, sim, EVENT_NONE);
+                w.fullFrames.fetch_add(1, std::memory_order_relaxed);
+                return;
+            case 'q': case 'Q': {
+                const std::size_t start = beginFrame(s.out, FRAME_BYE, EVENT_NONE, sim);
+                finishFrame(s.out, start);
+                s.closing = true;
+                return;
+            }
+            default:
+                break;
+        }
+        // Nothing on the board changed: an empty delta, so the key is still answered
+        w.cells.clear();
+        appendDeltaFrame(s.out, sim, EVENT_NONE, w.cells);
+        w.deltaFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void readKeys(Worker& w, Session& s) {
+        char keys[MAX_KEYS_PER_TURN];
+        ssize_t n;
+        do {
+            n = recv(s.fd, keys, sizeof(keys), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeSession(w, s); // Client went away
+            return;
+        }
+        if (n < 0) return;
+        std::size_t handled = 0;
+        for (ssize_t i = 0; i < n && !s.closing; i++) {
+            if (keys[i] == '\n' || keys[i] == '\r' || keys[i] == ' ') continue; // Line-mode clients (nc)
+            handleKey(w, s, keys[i]);
+            handled++;
+        }
+        w.keys.fetch_add(handled, std::memory_order_relaxed);
+        flush(w, s);
+    }
+
+    void run(Worker& w) {
+        epoll_event events[256];
+        for (;;) {
+            const int n = epoll_wait(w.epollFd, events, 256, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (int i = 0; i < n; i++) {
+                void* tag = events[i].data.ptr;
+                if (tag == stopTag()) {
+                    while (!w.sessions.empty()) closeSession(w, *w.sessions.back());
+                    return;
+                }
+                if (tag == listenTag()) {
+                    acceptSessions(w);
+                    continue;
+                }
+                Session& s = *static_cast<Session*>(tag);
+                // Events carry the session itself, and a session appears at most once per
+                // batch, so one closed earlier in the batch is never looked at again
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeSession(w, s);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    if (!flush(w, s)) continue;
+                }
+                if (events[i].events & EPOLLIN) readKeys(w, s);
+            }
+        }
+    }
+
+public:
+    static constexpr int MAX_BOARD_SIZE = 65535; // Frames carry rows, cols and squares as u16
+
+    // Sessions play boardSize x boardSize games; each one's seed comes from 'serverSeed' and
+    // the order sessions connect in. 'threads' = 0 means one per hardware thread. 'size' is
+    // clamped to MIN_MAZE_DIMENSION .. MAX_BOARD_SIZE.
+    GameServer(int size, unsigned threads, std::uint64_t serverSeed)
+        : boardSize(size < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : size > MAX_BOARD_SIZE ? MAX_BOARD_SIZE : size), seed(serverSeed), nextSession(0), listenFd(-1), stopFd(-1), address{ false, "", 0 },
+          peakSessions(0) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; i++) workers.emplace_back(new Worker());
+    }
+
+    ~GameServer() { stop(); }
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Bind 'addressText' and start the workers. False (and 'error') if the socket can't be opened.
+    bool start(const std::string& addressText, std::string* error = nullptr) {
+        if (!parseServerAddress(addressText, address, error)) return false;
+        listenFd = openServerSocket(address, true, error);
+        if (listenFd < 0) return false;
+        setNonBlocking(listenFd);
+        stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        for (auto& w : workers) {
+            w->epollFd = epoll_create1(EPOLL_CLOEXEC);
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+            ev.data.ptr = listenTag();
+            epoll_ctl(w->epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+            ev.events = EPOLLIN;
+            ev.data.ptr = stopTag();
+            epoll_ctl(w->epollFd, EPOLL_CTL_ADD, stopFd, &ev);
+        }
+        for (auto& w : workers) {
+            Worker* worker = w.get();
+            w->thread = std::thread([this, worker] { run(*worker); });
+        }
+        return true;
+    }
+
+    // Close every session and join the workers (also done by the destructor)
+    void stop() {
+        if (listenFd < 0) return;
+        const std::uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {} // Level-triggered: wakes every worker
+        for (auto& w : workers) {
+            if (w->thread.joinable()) w->thread.join();
+            close(w->epollFd);
+            w->epollFd = -1;
+        }
+        close(listenFd);
+        close(stopFd);
+        listenFd = stopFd = -1;
+        if (address.unixSocket) unlink(address.path.c_str());
+    }
+
+    unsigned workerCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // Totals over every worker; cheap, safe to call while the server runs
+    std::size_t sessionCount() const {
+        std::size_t n = 0;
+        for (auto& w : workers) n += w->sessionCount.load(std::memory_order_relaxed);
+        return n;
+    }
+    std::size_t peakSessionCount() const { return peakSessions.load(std::memory_order_relaxed); }
+    std::uint64_t keysHandled() const {
+        std::uint64_t n = 0;
+        for (auto& w : workers) n += w->keys.load(std::memory_order_relaxed);
+        return n;
+    }
+    std::uint64_t bytesSent() const {
+        std::uint64_t n = 0;
+        for (auto& w : workers) n += w->bytesOut.load(std::memory_order_relaxed);
+        return n;
+    }
+    std::uint64_t fullFrames() const {
+        std::uint64_t n = 0;
+        for (auto& w : workers) n += w->fullFrames.load(std::memory_order_relaxed);
+        return n;
+    }
+    std::uint64_t deltaFrames() const {
+        std::uint64_t n = 0;
+        for (auto& w : workers) n += w->deltaFrames.load(std::memory_order_relaxed);
+        return n;
+    }
+};
+
+#endif // MAZE_SERVER_H
@@ -0,0 +1,1213 @@
+// MazeSim.h
+#ifndef MAZE_SIM_H // Start of include guard
+#define MAZE_SIM_H
+
+#include <cctype>
+#include <cstddef>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Maze.h"     // Player
+#include "MazeGrid.h" // Runtime-sized flat grid + wall bitmap
+#include "OccupancyGrid.h" // "Who is at (x, y)" index for enemies
+#include "EnemyStore.h" // Struct-of-arrays enemy storage + batched move kernel
+#include "MazeRandom.h" // Counter-based RNG for enemy moves
+#include "TaskPool.h"   // Optional worker threads for enemy updates
+#include "FlowField.h"  // Shared distance-to-player field for chasing enemies
+#include "MazeGenerator.h" // Perfect-maze generation algorithms
+#include "FreeCellIndex.h" // Random placement of items and enemies, bounded however full the board is
+#include "MazeSave.h"      // Binary save format, CRC-32, mmap reader
+#include "Instrumentation.h" // Stage timers (compiled out unless MAZE_INSTRUMENT)
+#include "MazeSolver.h"    // Reachability checks and par routes for new levels
+#include "LevelPipeline.h" // Next levels built ahead on a worker thread
+#include "UndoHistory.h"   // Per-step deltas for undo / redo
+
+// Headless simulation core: all of the game rules, none of the console.
+// Nothing in here includes windows.h / conio.h, prints, or sleeps, so it builds on Linux
+// and can be stepped as fast as the CPU allows. The console front end (Maze.cpp) wraps it
+// and turns the returned event codes into colored messages and pauses.
+
+// Renamed from SIZE to avoid potential conflicts (e.g., with windows.h macros)
+// Default board size; the actual size is chosen at runtime (see MazeSim constructor)
+const int MAZE_DIMENSION = 10;
+const int MIN_MAZE_DIMENSION = 5; // Smallest board that still has room for start, exit and items
+
+const int PAR_BONUS = 50; // Points for finishing a level in par moves or fewer
+// Par needs the distances between every item, which costs a multi-source BFS over the whole
+// board (~80 ms at 1001 x 1001); bigger boards get no par. Reachability is always checked.
+const std::size_t PAR_MAX_CELLS = std::size_t(1) << 20;
+const int MAX_LAYOUT_ATTEMPTS = 8; // Layouts tried per level before settling for one whose exit can't be reached
+
+// One player input per step
+enum SimAction : unsigned char {
+    ACTION_NONE = 0,
+    ACTION_UP,    // 'w'
+    ACTION_DOWN,  // 's'
+    ACTION_LEFT,  // 'a'
+    ACTION_RIGHT  // 'd'
+};
+
+// Bit flags returned by step(); several can be set at once (e.g. MOVED | COLLECTED)
+enum SimEvent : unsigned {
+    EVENT_NONE           = 0,
+    EVENT_MOVED          = 1 << 0, // Player moved (and, when turn-based, enemies took their turn)
+    EVENT_BLOCKED        = 1 << 1, // Move hit a wall / edge, nothing happened
+    EVENT_COLLECTED      = 1 << 2, // Player picked up a '*'
+    EVENT_CAUGHT         = 1 << 3, // Enemy and player share a cell - game over
+    EVENT_LEVEL_COMPLETE = 1 << 4, // Exit reached with everything collected; next level is loaded
+    EVENT_EXIT_LOCKED    = 1 << 5, // Standing on the exit with collectibles left
+    EVENT_PAR            = 1 << 6  // Set with EVENT_LEVEL_COMPLETE when the level took par moves or fewer
+};
+
+// How enemies pick their moves
+enum EnemyBehavior {
+    ENEMIES_WANDER, // Classic random walk
+    ENEMIES_CHASE   // Step along a shared flow field towards the player, wander when out of reach
+};
+
+// Map the keys main() understands to actions (anything else is ACTION_NONE)
+inline SimAction actionFromKey(char key) {
+    switch (std::tolower(static_cast<unsigned char>(key))) {
+        case 'w': return ACTION_UP;
+        case 's': return ACTION_DOWN;
+        case 'a': return ACTION_LEFT;
+        case 'd': return ACTION_RIGHT;
+        default: return ACTION_NONE;
+    }
+}
+
+// Board size marker for BasicMazeGame: the size is chosen at runtime (the MazeSim default)
+const int DYNAMIC_BOARD = 0;
+
+// The game, for a board of W columns by H rows fixed at compile time, or of any size chosen
+// at runtime when both are DYNAMIC_BOARD (MazeSim, below). Both share every line of code;
+// a fixed size only turns the hot paths' bounds, row stride and exit square into constants
+// (movePlayer, checkGameState, the enemies' wander kernel, the reachability pass of a new
+// level), and a fixed-size lattice level starts from a wall plane built at compile time.
+// Boards are square, so W == H.
+template <int W, int H>
+class BasicMazeGame {
+public:
+    static constexpr bool FIXED = W != DYNAMIC_BOARD;
+
+private:
+    static_assert(W == H, "BasicMazeGame boards are square");
+    static_assert(!FIXED || W >= MIN_MAZE_DIMENSION, "Board too small for start, exit and items");
+
+    static constexpr std::size_t FIXED_WORDS_PER_ROW = FIXED ? (static_cast<std::size_t>(W) + 63) / 64 : 0;
+
+    // Flat grid (one contiguous buffer + bit-packed wall plane); H x W when FIXED
+    MazeGrid maze;
+    int dimension; // Side length of the (square) board
+    Player player;  // By value: a game is one object, not one allocation per entity
+    EnemyStore enemies;      // All enemies, struct-of-arrays; ids are indices
+    OccupancyGrid occupancy; // Enemy positions, kept current by moveEnemies() / placement
+    int score;
+    int moves;
+    int level;
+    int collectibles;
+    bool gameOver;
+    std::uint64_t seed;         // Keys the enemies' counter-based RNG
+    std::uint32_t tick;         // Enemy update counter (one per moveEnemies call)
+    std::unique_ptr<TaskPool> pool; // Worker threads for enemy updates (null = single-threaded)
+    EnemyConflictPolicy conflictPolicy;
+    EnemyBehavior enemyBehavior;
+    bool turnBased;       // Enemies move after every player move (classic) or only on tickEnemies()
+    FlowField chaseField; // Distance to the player; only maintained while chasing
+    MazeAlgorithm algorithm; // Used for every newly generated level
+    FreeCellIndex freeCells; // Open squares with no item, player or enemy on them
+    SplitMix64 levelRng;     // Item / enemy placement for the current level
+    int placementShortfall;  // Items + enemies the last level setup had no room for
+    std::vector<std::int32_t> itemSquares; // x, y pairs of the '*' squares, so saves never scan the board
+    int exitX, exitY;        // Exit square (-1, -1 if a loaded board has none); the exit and enemy rules go by it
+    LevelSolver solver;      // Reachability + par route; scratch buffers reused between levels
+    MazeGeneratorScratch generatorScratch; // Layout generation buffers, reused the same way
+    int parMoves;            // Shortest route through every item to the exit (-1 = unknown)
+    int levelStartMoves;     // 'moves' when the current level began
+    int rejectedLayouts;     // Layouts thrown away because the exit was unreachable (whole game)
+    std::unique_ptr<LevelPipeline> pipeline; // Next levels built ahead (null = build on the spot)
+    LevelSetup setupScratch;  // Reused by levels built on the spot
+    UndoHistory history;      // Undo / redo records (capacity 0 = off, the default)
+    UndoRecord pendingRecord; // Filled in by the step being recorded, pushed once it changed something
+    bool recording;           // A step is being recorded into pendingRecord
+    std::vector<std::int32_t> stepStartXs, stepStartYs; // Enemy squares when that step began
+
+    // Each level's layout depends only on (seed, level)
+    static std::uint64_t levelSeedFor(std::uint64_t gameSeed, int gameLevel) {
+        return mix64(gameSeed ^ (static_cast<std::uint64_t>(gameLevel) * 0x9E3779B97F4A7C15ull));
+    }
+    std::uint64_t levelSeed() const { return levelSeedFor(seed, level); }
+
+    // Full re-index after the board changed wholesale (new level, load)
+    void rebuildFreeCells() {
+        freeCells.rebuild(maze);
+        freeCells.erase(player.getX(), player.getY());
+        for (std::size_t i = 0; i < enemies.size(); i++) freeCells.erase(enemies.getX(i), enemies.getY(i));
+    }
+
+    // (x, y) was just left by an entity: it is free again if nothing else is on it
+    void releaseSquare(int x, int y) {
+        if (maze.get(x, y) == ' ' && !occupancy.occupied(x, y) && !(x == player.getX() && y == player.getY()))
+            freeCells.insert(x, y);
+    }
+
+    // Enemy 'id' onto a random free square; with none left it shares the previous enemy's
+    // square (or the start's neighbour) and counts as a shortfall
+    void placeEnemyRandomly(int id) {
+        int x, y;
+        if (freeCells.takeRandom(levelRng, x, y)) {
+            setEnemyPosition(id, x, y);
+            return;
+        }
+        placementShortfall++;
+        if (id > 0) setEnemyPosition(id, enemies.getX(id - 1), enemies.getY(id - 1));
+        else if (maze.at(1, 2) == ' ') setEnemyPosition(id, 1, 2);
+        else setEnemyPosition(id, 2, 1);
+    }
+
+    void placeStartingEnemy() {
+        // (5, 5) if it is an open, reachable square; never carve a wall for it (that could open
+        // a pocket the level check never saw), so otherwise a random free square
+        int start_enemy_x = 5;
+        int start_enemy_y = 5;
+        if (start_enemy_x < dimension - 1 && start_enemy_y < dimension - 1 && freeCells.contains(start_enemy_x, start_enemy_y)) {
+             addEnemy(start_enemy_x, start_enemy_y);
+        } else {
+             placeEnemyRandomly(addEnemy(1, 1)); // Registered first, then moved off the start square
+        }
+    }
+
+    // Take squares the start can't reach (per the last flood of 'grid') out of 'free', so no
+    // item or enemy is ever placed where the player could not get to it
+    static void dropUnreachableSquares(FreeCellIndex& free, const MazeGrid& grid, const ReachabilityMap& reach) {
+        const int rows = FIXED ? H : grid.getRows();
+        const std::size_t wordsPerRow = FIXED ? FIXED_WORDS_PER_ROW : grid.getWordsPerRow();
+        for (int x = 0; x < rows; x++) {
+            const std::uint64_t* walls = grid.wallRow(x);
+            const std::uint64_t* reached = reach.row(x);
+            for (std::size_t w = 0; w < wordsPerRow; w++) {
+                for (std::uint64_t cut = ~walls[w] & ~reached[w]; cut; cut &= cut - 1) {
+                    free.erase(x, static_cast<int>(w * 64 + lowestBitIndex(cut)));
+                }
+            }
+        }
+    }
+
+    // Walls and exit for one level into 'grid'. A layout whose exit can't be reached from the
+    // start is rejected and generated again from the next seed in line (up to
+    // MAX_LAYOUT_ATTEMPTS); leaves 'levelSolver' holding the flood of the accepted layout.
+    // Returns how many layouts were rejected.
+    static int generateLayout(MazeGrid& grid, LevelSolver& levelSolver, MazeGeneratorScratch& generatorBuffers,
+                              int size, MazeAlgorithm mazeAlgorithm, std::uint64_t seedOfLevel) {
+        const int exit = size - 2; // Use dimension - 2 for exit position
+        if constexpr (FIXED) {
+            if (mazeAlgorithm == MAZE_LATTICE) {
+                // The lattice never changes: adopt the compile-time plane copy-on-write. The
+                // static owner keeps it shared, so the first write that would flip a wall copies
+                // it instead of touching the constant; play never flips one.
+                static constexpr LatticePlane<H, W> LATTICE{};
+                static const std::shared_ptr<const std::uint64_t[]> plane(LATTICE.words, [](const std::uint64_t*) {});
+                grid.assignWallPlane(H, W, plane);
+                grid.set(exit, exit, 'E');
+                levelSolver.flood(grid, 1, 1);
+                return 0; // Always solvable
+            }
+        }
+        for (int attempt = 0; ; attempt++) {
+            // Attempt 0 uses the level seed itself, so solvable levels are exactly what they always were
+            MazeGenerator::generate(grid, size, size, mazeAlgorithm,
+                                    attempt == 0 ? seedOfLevel : mix64(seedOfLevel + static_cast<std::uint64_t>(attempt)),
+                                    generatorBuffers);
+            grid.set(1, 1, ' '); // Ensure start is clear
+            grid.set(exit, exit, 'E');
+            if (levelSolver.flood(grid, 1, 1).reached(exit, exit) || attempt + 1 == MAX_LAYOUT_ATTEMPTS) return attempt;
+        }
+    }
+
+    // Up to 'wanted' items on random free squares (FreeCellIndex::takeRandom each). Returns how many fit.
+    static int placeItems(MazeGrid& grid, FreeCellIndex& free, SplitMix64& rng, int wanted,
+                          std::vector<std::int32_t>& items) {
+        int placed = 0;
+        int r, c;
+        while (placed < wanted && free.takeRandom(rng, r, c)) {
+            grid.set(r, c, '*');
+            items.push_back(r);
+            items.push_back(c);
+            placed++;
+        }
+        return placed;
+    }
+
+    // Enemies on 'gameLevel' when 'carried' come over from the level before: one more from
+    // level 3 on, until there are gameLevel / 2 + 1
+    static std::size_t enemiesOnLevel(int gameLevel, std::size_t carried) {
+        return carried + (gameLevel >= 3 && carried < static_cast<std::size_t>(gameLevel / 2) + 1 ? 1 : 0);
+    }
+
+    // The spec of the level after 'spec', as the game will ask for it
+    static LevelSpec followingLevel(const LevelSpec& spec) {
+        LevelSpec next = spec;
+        next.level++;
+        next.enemies = enemiesOnLevel(spec.level, spec.enemies);
+        return next;
+    }
+
+    // Everything after the first level, built from its spec alone, so the same level comes out
+    // whether it is built here on the spot or ahead of time on the pipeline's thread: a fresh
+    // layout, then every carried enemy and the level's new one (if any) on random free
+    // squares, then the items, then the par. The player starts on (1, 1).
+    static void buildLevel(const LevelSpec& spec, MazeGrid& grid, FreeCellIndex& free,
+                           std::vector<std::int32_t>& items, LevelSetup& setup, LevelSolver& levelSolver,
+                           MazeGeneratorScratch& generatorBuffers) {
+        const std::uint64_t seedOfLevel = levelSeedFor(spec.seed, spec.level);
+        const int exit = spec.dimension - 2;
+        setup.spec = spec;
+        setup.rejectedLayouts = generateLayout(grid, levelSolver, generatorBuffers, spec.dimension, spec.algorithm, seedOfLevel);
+        SplitMix64 rng(mix64(seedOfLevel + 1));
+        items.clear();
+        free.rebuild(grid);
+        free.erase(1, 1);
+        dropUnreachableSquares(free, grid, levelSolver.getReachability());
+
+        // Enemies: a random free square each; with none left, the previous enemy's square
+        // (or the start's neighbour), counted as a shortfall
+        setup.placementShortfall = 0;
+        const std::size_t enemyCount = enemiesOnLevel(spec.level, spec.enemies);
+        setup.enemyXs.resize(enemyCount);
+        setup.enemyYs.resize(enemyCount);
+        for (std::size_t i = 0; i < enemyCount; i++) {
+            int x, y;
+            if (!free.takeRandom(rng, x, y)) {
+                setup.placementShortfall++;
+                if (i > 0) { x = setup.enemyXs[i - 1]; y = setup.enemyYs[i - 1]; }
+                else if (grid.at(1, 2) == ' ') { x = 1; y = 2; }
+                else { x = 2; y = 1; }
+                free.erase(x, y);
+            }
+            setup.enemyXs[i] = x;
+            setup.enemyYs[i] = y;
+        }
+
+        const int wanted = spec.level + 2;
+        setup.collectibles = placeItems(grid, free, rng, wanted, items);
+        setup.placementShortfall += wanted - setup.collectibles;
+        setup.parMoves = grid.cellCount() > PAR_MAX_CELLS ? -1 : levelSolver.solve(grid, 1, 1, items, exit, exit).parMoves;
+        setup.rngState = rng.getState();
+    }
+
+    // Switch the game over to a level whose board, free squares and items already sit in
+    // maze / freeCells / itemSquares
+    void applyLevelSetup(const LevelSetup& setup) {
+        player.setPosition(1, 1);
+        exitX = exitY = dimension - 2;
+        for (std::size_t i = 0; i < setup.enemyXs.size(); i++) {
+            const int x = setup.enemyXs[i], y = setup.enemyYs[i];
+            if (i < enemies.size()) {
+                // Moved, not released: the old square belongs to the previous board
+                enemies.setPosition(i, x, y);
+                occupancy.relocate(static_cast<int>(i), x, y);
+            } else {
+                addEnemy(x, y);
+            }
+        }
+        collectibles = setup.collectibles;
+        placementShortfall = setup.placementShortfall;
+        rejectedLayouts += setup.rejectedLayouts;
+        parMoves = setup.parMoves;
+        levelStartMoves = moves;
+        levelRng.setState(setup.rngState);
+        refreshChaseField(); // New walls
+    }
+
+    // Start recording the coming step (when history is kept): note what its deltas are taken against
+    bool beginRecord() {
+        if (history.getCapacity() == 0) return false;
+        pendingRecord.fromX = player.getX();
+        pendingRecord.fromY = player.getY();
+        pendingRecord.itemX = pendingRecord.itemY = -1;
+        pendingRecord.scoreBefore = score;
+        pendingRecord.levelJump.reset();
+        stepStartXs.assign(enemies.xData(), enemies.xData() + enemies.size());
+        stepStartYs.assign(enemies.yData(), enemies.yData() + enemies.size());
+        recording = true;
+        return true;
+    }
+
+    // Where the step left the player and the enemies. Called just before the next level is
+    // set up when the step finishes one (the level's own snapshot takes over from there).
+    void captureStepEnd() {
+        pendingRecord.toX = player.getX();
+        pendingRecord.toY = player.getY();
+        UndoHistory::encodeEnemyMoves(stepStartXs.data(), stepStartYs.data(), enemies.xData(), enemies.yData(),
+                                      stepStartXs.size(), pendingRecord.enemyMoves);
+    }
+
+    // Push the recorded step onto the history (dropping anything that could be redone)
+    void finishRecord(std::uint8_t flags) {
+        recording = false;
+        if (pendingRecord.levelJump) pendingRecord.levelJump->after = snapshot();
+        else captureStepEnd();
+        pendingRecord.scoreAfter = score;
+        pendingRecord.flags = static_cast<std::uint8_t>(flags | (gameOver ? UNDO_CAUGHT : 0));
+        std::swap(history.push(), pendingRecord); // The slot's old buffers come back for the next step
+    }
+
+    // Re-check whether (x, y) is free once the entities around it have been put back
+    void refreshSquare(int x, int y) {
+        if (maze.get(x, y) == ' ' && !occupancy.occupied(x, y) && !(x == player.getX() && y == player.getY()))
+            freeCells.insert(x, y);
+        else
+            freeCells.erase(x, y);
+    }
+
+    // Play a recorded step backwards or forwards within one level: enemies, item, player and
+    // counters, then the free squares they touched. O(enemies), whatever the board size.
+    void applyRecord(const UndoRecord& r, bool forward) {
+        const int sign = forward ? 1 : -1;
+        const std::size_t n = enemies.size() < r.enemyMoves.size() * 2 ? enemies.size() : r.enemyMoves.size() * 2;
+        for (std::size_t i = 0; i < n; i++) {
+            const std::uint8_t code = UndoHistory::enemyMove(r.enemyMoves, i);
+            if (code == UndoHistory::ENEMY_STAYED) continue;
+            const int x = enemies.getX(i) + sign * UndoHistory::moveDx(code);
+            const int y = enemies.getY(i) + sign * UndoHistory::moveDy(code);
+            enemies.setPosition(i, x, y);
+            occupancy.relocate(static_cast<int>(i), x, y);
+        }
+        if (r.itemX >= 0) {
+            if (forward) {
+                maze.set(r.itemX, r.itemY, ' ');
+                removeItemSquare(r.itemX, r.itemY);
+                collectibles--;
+            } else {
+                maze.set(r.itemX, r.itemY, '*');
+                itemSquares.push_back(r.itemX);
+                itemSquares.push_back(r.itemY);
+                collectibles++;
+            }
+        }
+        player.setPosition(forward ? r.toX : r.fromX, forward ? r.toY : r.fromY);
+        score = forward ? r.scoreAfter : r.scoreBefore;
+        if (r.flags & UNDO_PLAYER_MOVED) moves += sign;
+        if (r.flags & UNDO_TICKED) tick += sign;
+        gameOver = forward && (r.flags & UNDO_CAUGHT);
+
+        for (std::size_t i = 0; i < n; i++) {
+            const std::uint8_t code = UndoHistory::enemyMove(r.enemyMoves, i);
+            if (code == UndoHistory::ENEMY_STAYED) continue;
+            refreshSquare(enemies.getX(i), enemies.getY(i));
+            refreshSquare(enemies.getX(i) - sign * UndoHistory::moveDx(code), enemies.getY(i) - sign * UndoHistory::moveDy(code));
+        }
+        refreshSquare(r.fromX, r.fromY);
+        refreshSquare(r.toX, r.toY);
+        if (enemyBehavior == ENEMIES_CHASE && (r.flags & UNDO_PLAYER_MOVED)) chaseField.moveSource(maze, player.getX(), player.getY());
+    }
+
+    // MazeGrid::isWall() with the bounds and row stride as constants when FIXED
+    bool wallAt(int x, int y) const {
+        if (!FIXED) return maze.isWall(x, y);
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(H) || static_cast<unsigned>(y) >= static_cast<unsigned>(W)) return true;
+        return (maze.wallRow(0)[x * FIXED_WORDS_PER_ROW + (y >> 6)] >> (y & 63)) & 1;
+    }
+
+    // MazeGrid::at(), unchecked, with the row length as a constant when FIXED
+    char cellAt(int x, int y) const {
+        return FIXED ? maze.atIndex(static_cast<std::size_t>(x) * W + y) : maze.at(x, y);
+    }
+
+    // Spec of the level the game would move to next, as things stand
+    LevelSpec nextLevelSpec() const {
+        return LevelSpec{ seed, level + 1, dimension, algorithm, enemies.size() };
+    }
+
+    // Something a queued level was built from changed (new game, load, algorithm): start over
+    void restartPipeline() {
+        if (pipeline) pipeline->restart(nextLevelSpec());
+    }
+
+    // Drop (x, y) from itemSquares (a handful of entries: swap the last pair into its place)
+    void removeItemSquare(int x, int y) {
+        for (std::size_t i = 0; i < itemSquares.size(); i += 2) {
+            if (itemSquares[i] == x && itemSquares[i + 1] == y) {
+                itemSquares[i] = itemSquares[itemSquares.size() - 2];
+                itemSquares[i + 1] = itemSquares.back();
+                itemSquares.resize(itemSquares.size() - 2);
+                return;
+            }
+        }
+    }
+
+    // Walls changed or the player jumped: rebuild the chase field from scratch
+    void refreshChaseField() {
+        if (enemyBehavior == ENEMIES_CHASE) chaseField.rebuild(maze, player.getX(), player.getY());
+        else chaseField.invalidate();
+    }
+
+    void clearEnemies() {
+        enemies.clear();
+        occupancy.reset(maze.getRows(), maze.getCols());
+    }
+
+public:
+    // Seed defaults to the clock, like the classic game; pass one to get reproducible mazes and enemies.
+    // A fixed-size game ignores 'size'.
+    explicit BasicMazeGame(int size = FIXED ? W : MAZE_DIMENSION,
+                           std::uint64_t gameSeed = static_cast<std::uint64_t>(std::time(0)))
+        : dimension(FIXED ? W : size < MIN_MAZE_DIMENSION ? MIN_MAZE_DIMENSION : size),
+          player(1, 1), score(0), moves(0), level(1), collectibles(0), gameOver(false),
+          seed(gameSeed), tick(0), conflictPolicy(ENEMIES_STACK),
+          enemyBehavior(ENEMIES_WANDER), turnBased(true), algorithm(MAZE_BACKTRACKER), placementShortfall(0),
+          exitX(-1), exitY(-1), parMoves(-1), levelStartMoves(0), rejectedLayouts(0), recording(false) {
+        initializeMaze();
+        occupancy.reset(maze.getRows(), maze.getCols());
+        placeStartingEnemy();
+        addCollectibles();
+        solveLevel();
+    }
+
+    // Owns the enemy arena and the worker pool - not copyable
+    BasicMazeGame(const BasicMazeGame&) = delete;
+    BasicMazeGame& operator=(const BasicMazeGame&) = delete;
+
+    // Spread enemy updates over 'threads' threads (1 = run inline). Results are identical
+    // for every thread count: each enemy's randomness depends only on (seed, tick, id).
+    void setThreadCount(unsigned threads) {
+        if (threads <= 1) pool.reset();
+        else pool.reset(new TaskPool(threads));
+    }
+    unsigned getThreadCount() const { return pool ? pool->size() : 1; }
+
+    // ENEMIES_STACK keeps the classic rules; ENEMIES_EXCLUSIVE allows one enemy per cell
+    void setEnemyConflictPolicy(EnemyConflictPolicy policy) { conflictPolicy = policy; }
+    EnemyConflictPolicy getEnemyConflictPolicy() const { return conflictPolicy; }
+
+    // Switch between random wandering and chasing. Chasing builds the flow field now and then
+    // repairs it incrementally on every player move. Without a chase radius (setChaseRadius)
+    // that update is O(board) per move on a perfect maze, where one step changes every
+    // distance and the field is in effect rebuilt; set a radius for big boards.
+    void setEnemyBehavior(EnemyBehavior behavior) {
+        enemyBehavior = behavior;
+        refreshChaseField();
+    }
+    EnemyBehavior getEnemyBehavior() const { return enemyBehavior; }
+
+    // Enemies farther than 'steps' from the player wander instead of chasing (0 = no limit).
+    // Bounds the per-move field update on big boards.
+    void setChaseRadius(std::uint32_t steps) {
+        chaseField.setRadius(steps);
+        refreshChaseField();
+    }
+    std::uint32_t getChaseRadius() const { return chaseField.getRadius(); }
+    const FlowField& getFlowField() const { return chaseField; }
+
+    // Turn-based (the default): every player move is followed by one enemy step. Otherwise the
+    // player moves alone and the caller drives enemies with tickEnemies() on its own clock
+    // (the real-time loop, RealTimeLoop.h).
+    void setTurnBased(bool enabled) { turnBased = enabled; }
+    bool isTurnBased() const { return turnBased; }
+
+    // Generator for the next level / new game (the current board is kept)
+    void setMazeAlgorithm(MazeAlgorithm mazeAlgorithm) {
+        algorithm = mazeAlgorithm;
+        restartPipeline();
+    }
+    MazeAlgorithm getMazeAlgorithm() const { return algorithm; }
+
+    std::uint64_t getSeed() const { return seed; }
+    std::uint32_t getTick() const { return tick; }
+
+    // Start over from level 1 on a freshly generated board (same size)
+    void newGame() {
+        history.clear();
+        score = 0;
+        moves = 0;
+        level = 1;
+        gameOver = false;
+        placementShortfall = 0;
+        clearEnemies();
+        initializeMaze();
+        placeStartingEnemy();
+        addCollectibles();
+        solveLevel();
+        refreshChaseField();
+        restartPipeline();
+    }
+
+    // Same, under a new seed: a different sequence of levels and enemy moves, reproducible
+    // from 'gameSeed' alone (the enemy tick starts over too)
+    void newGame(std::uint64_t gameSeed) {
+        seed = gameSeed;
+        tick = 0;
+        newGame();
+    }
+
+    // Keep the board (cells and wall plane) in memory the caller owns from now on, e.g. one
+    // slab shared by a batch of games; see MazeGrid::useStorage for the sizes and lifetime.
+    // Later levels are built in place there. False if the current board doesn't fit.
+    bool useBoardStorage(char* cells, std::size_t cellCount, std::uint64_t* walls, std::size_t wallCount) {
+        return maze.useStorage(cells, cellCount, walls, wallCount);
+    }
+
+    // --- Getters ---
+    int getScore() const { return score; }
+    int getMoves() const { return moves; }
+    int getLevel() const { return level; }
+    int getDimension() const { return dimension; }
+    int getPlayerX() const { return player.getX(); }
+    int getPlayerY() const { return player.getY(); }
+    int getCollectiblesRemaining() const { return collectibles; }
+    // x, y pairs of the squares that still hold an item (unordered)
+    const std::vector<std::int32_t>& getItemSquares() const { return itemSquares; }
+    int getParMoves() const { return parMoves; }                   // -1 if the level has no par
+    int getLevelMoves() const { return moves - levelStartMoves; } // Moves spent on this level so far
+    int getRejectedLayouts() const { return rejectedLayouts; }
+    bool isGameOver() const { return gameOver; }
+    const Player& getPlayer() const { return player; }
+    const EnemyStore& getEnemies() const { return enemies; }
+    const OccupancyGrid& getOccupancy() const { return occupancy; }
+    const MazeGrid& getGrid() const { return maze; }
+    char getCell(int x, int y) const {
+        // Bounds-checked: returns wall if out-of-bounds request
+        return maze.get(x, y);
+    }
+    // Is any enemy within 'radius' cells (including diagonals) of the player?
+    bool isEnemyNearPlayer(int radius) const {
+        return occupancy.anyWithin(player.getX(), player.getY(), radius);
+    }
+    // --- End Getters ---
+
+    const FreeCellIndex& getFreeCells() const { return freeCells; }
+    // Items + enemies that did not fit when the current level was set up (0 normally)
+    int getPlacementShortfall() const { return placementShortfall; }
+
+    // Add an enemy at (x, y) and register it in the occupancy index. Returns its id.
+    // Recorded steps can't be undone past a change like this one: call clearHistory() after
+    // adding or moving enemies by hand mid-game.
+    int addEnemy(int x, int y) {
+        int id = static_cast<int>(enemies.add(x, y));
+        occupancy.insert(id, x, y);
+        freeCells.erase(x, y);
+        return id;
+    }
+
+    // Take every enemy off the board (tools, benchmarks)
+    void removeAllEnemies() {
+        history.clear();
+        clearEnemies();
+        rebuildFreeCells();
+        refreshChaseField();
+    }
+
+    // Add 'count' enemies on random free squares (FreeCellIndex::takeRandom each). If there are fewer free squares
+    // than that, nothing is added, 'error' says why and false is returned.
+    bool spawnEnemies(std::size_t count, std::string* error = nullptr) {
+        if (count > freeCells.size()) {
+            if (error) *error = "Only " + std::to_string(freeCells.size()) + " free squares for " +
+                                std::to_string(count) + " enemies.";
+            return false;
+        }
+        history.clear();
+        int x, y;
+        for (std::size_t i = 0; i < count && freeCells.takeRandom(levelRng, x, y); i++) addEnemy(x, y);
+        return true;
+    }
+
+    // Move an existing enemy without a random step (level reset, loading, tools)
+    void setEnemyPosition(int id, int x, int y) {
+        const int oldX = enemies.getX(id), oldY = enemies.getY(id);
+        enemies.setPosition(id, x, y);
+        occupancy.relocate(id, x, y);
+        releaseSquare(oldX, oldY);
+        freeCells.erase(x, y);
+    }
+
+    // Advance the simulation by one player action. Returns a mask of SimEvent flags.
+    // Once the player has been caught every further step is a no-op (EVENT_NONE).
+    unsigned step(SimAction action) {
+        if (gameOver || action == ACTION_NONE) return EVENT_NONE;
+        const bool record = beginRecord();
+        unsigned events = movePlayer(action);
+        if (events & EVENT_MOVED) {
+            events |= checkGameState();
+        }
+        if (record) {
+            recording = false;
+            if (events & EVENT_MOVED) finishRecord(UNDO_PLAYER_MOVED | (turnBased ? UNDO_TICKED : 0));
+        }
+        return events;
+    }
+
+    // One enemy step without a player move (real-time mode). Returns EVENT_CAUGHT if an enemy
+    // landed on the player, else EVENT_NONE; a no-op once the game is over.
+    unsigned tickEnemies() {
+        if (gameOver) return EVENT_NONE;
+        const bool record = beginRecord();
+        moveEnemies();
+        if (occupancy.occupied(player.getX(), player.getY())) gameOver = true;
+        if (record) finishRecord(UNDO_TICKED);
+        return gameOver ? EVENT_CAUGHT : EVENT_NONE;
+    }
+
+    // Batch version of step(): runs actions[0..count) back to back and stops early on game over.
+    // If 'events' is non-null, events[i] receives the mask for actions[i].
+    // Returns how many actions were actually consumed.
+    std::size_t step_n(const SimAction* actions, std::size_t count, unsigned* events = nullptr) {
+        std::size_t i = 0;
+        for (; i < count && !gameOver; i++) {
+            unsigned e = step(actions[i]);
+            if (events) events[i] = e;
+        }
+        return i;
+    }
+
+    unsigned movePlayer(SimAction action) {
+        MAZE_TIMED_SCOPE(STAGE_MOVE_PLAYER);
+        int dx = 0, dy = 0;
+        switch (action) {
+            case ACTION_UP: dx = -1; break;
+            case ACTION_DOWN: dx = 1; break;
+            case ACTION_LEFT: dy = -1; break;
+            case ACTION_RIGHT: dy = 1; break;
+            default: return EVENT_NONE;
+        }
+
+        int newX = player.getX() + dx;
+        int newY = player.getY() + dy;
+
+        // wallAt() checks bounds and reads the wall bitmap (out-of-bounds counts as a wall)
+        if (!wallAt(newX, newY)) {
+            unsigned events = EVENT_MOVED;
+            if (cellAt(newX, newY) == '*') {
+                if (recording) {
+                    pendingRecord.itemX = newX;
+                    pendingRecord.itemY = newY;
+                }
+                score += 10;
+                collectibles--;
+                maze.set(newX, newY, ' '); // Clear collectible
+                removeItemSquare(newX, newY);
+                events |= EVENT_COLLECTED;
+            }
+            player.move(dx, dy);
+            moves++;
+            releaseSquare(newX - dx, newY - dy);
+            freeCells.erase(newX, newY);
+            if (enemyBehavior == ENEMIES_CHASE) chaseField.moveSource(maze, newX, newY); // Incremental repair
+            // It might make more sense to move enemies *before* checking game state,
+            // but we'll keep original logic for now.
+            if (turnBased) moveEnemies();
+            return events;
+        }
+        return EVENT_BLOCKED;
+    }
+
+    // One step for every enemy: random (diagonals allowed) or, when chasing, downhill on the
+    // flow field. Walls and the exit are off limits. Runs as batched, optionally multi-threaded phases over the SoA store - see EnemyStore::moveAll.
+    // Fixed-size boards with classic wandering enemies take the single-pass kernel instead
+    // (EnemyStore::wanderFixed), which moves them the same way.
+    void moveEnemies() {
+        MAZE_TIMED_SCOPE(STAGE_MOVE_ENEMIES);
+        bool moved = false;
+        if constexpr (FIXED) {
+            // wanderFixed() has the exit at (H - 2, W - 2) built in; a loaded board may have it elsewhere
+            if (conflictPolicy == ENEMIES_STACK && enemyBehavior == ENEMIES_WANDER && !pool && exitX == H - 2 && exitY == W - 2) {
+                enemies.template wanderFixed<H, W>(maze, occupancy, seed, tick, &freeCells);
+                moved = true;
+            }
+        }
+        if (!moved) {
+            enemies.moveAll(maze, exitX, exitY, occupancy, seed, tick, pool.get(), conflictPolicy,
+                            enemyBehavior == ENEMIES_CHASE ? &chaseField : nullptr, &freeCells);
+        }
+        freeCells.erase(player.getX(), player.getY()); // In case an enemy just left the player's square
+        tick++;
+    }
+
+    // Resolve collisions / exit after a move. Returns EVENT_CAUGHT, EVENT_LEVEL_COMPLETE,
+    // EVENT_EXIT_LOCKED or EVENT_NONE. A completed level is replaced immediately.
+    unsigned checkGameState() {
+        MAZE_TIMED_SCOPE(STAGE_CHECK_STATE);
+        // Check for collision with player - one index lookup instead of scanning every enemy
+        if (occupancy.occupied(player.getX(), player.getY())) {
+            gameOver = true;
+            return EVENT_CAUGHT; // Game over
+        }
+
+        // Check for reaching the exit
+        // Use dimension-2 to correctly identify exit location defined in initializeMaze
+        if (player.getX() == exitX && player.getY() == exitY) { // Never true without an exit (-1, -1)
+             if (collectibles == 0) {
+                if (recording) {
+                    // The board is about to be replaced: keep the finished level whole
+                    captureStepEnd();
+                    pendingRecord.levelJump.reset(new LevelJump());
+                    pendingRecord.levelJump->before = snapshot();
+                }
+                unsigned events = EVENT_LEVEL_COMPLETE;
+                if (parMoves >= 0 && getLevelMoves() <= parMoves) {
+                    score += PAR_BONUS;
+                    events |= EVENT_PAR;
+                }
+                level++;
+                resetLevel();
+                return events; // Continue playing (next level)
+             } else {
+                 // Player is at exit, but hasn't collected everything
+                 return EVENT_EXIT_LOCKED; // Continue playing (still on current level)
+             }
+        }
+        return EVENT_NONE; // Continue playing (no game-ending event occurred)
+    }
+
+    // New walls and exit for the current level; the player goes back to the start square.
+    // Items and enemies are placed by the caller, once the free-cell index is ready.
+    // A layout whose exit can't be reached from the start is rejected and the level is
+    // generated again from the next seed in line; squares the start can't reach are left out
+    // of the free-cell index, so every item placed afterwards is reachable too.
+    // Public, like the other level steps, so they can be timed on their own (MazeBench suite);
+    // game code goes through resetLevel() / newGame().
+    void initializeMaze() {
+        player.setPosition(1, 1);
+        exitX = exitY = dimension - 2; // Use dimension - 2 for exit position
+        rejectedLayouts += generateLayout(maze, solver, generatorScratch, dimension, algorithm, levelSeed());
+        levelRng.setState(mix64(levelSeed() + 1));
+        itemSquares.clear();
+        rebuildFreeCells();
+        dropUnreachableSquares(freeCells, maze, solver.getReachability());
+    }
+
+    // Check the finished level (items and enemies placed) and work out its par: the fewest
+    // moves that collect every item and end on the exit. Exact up to
+    // LevelSolver::EXACT_ITEM_LIMIT items, a 2-opt route beyond; none on boards over
+    // PAR_MAX_CELLS squares. Starts the level's move count.
+    void solveLevel() {
+        MAZE_TIMED_SCOPE(STAGE_SOLVE_LEVEL);
+        levelStartMoves = moves;
+        parMoves = -1;
+        if (maze.cellCount() > PAR_MAX_CELLS) return;
+        parMoves = solver.solve(maze, player.getX(), player.getY(), itemSquares, exitX, exitY).parMoves;
+    }
+
+    // level + 2 items on random free squares (FreeCellIndex::takeRandom each). If the board runs out of room the
+    // level simply has fewer items (counted in placementShortfall) instead of looping forever.
+    void addCollectibles() {
+        const int wanted = level + 2;
+        collectibles = placeItems(maze, freeCells, levelRng, wanted, itemSquares);
+        placementShortfall += wanted - collectibles;
+    }
+
+    // Move on to the current 'level' (already bumped). With pregeneration on, the level is
+    // normally waiting in the pipeline and this is a few swaps; otherwise (or when the
+    // pipeline guessed wrong) it is built here, straight into the live board, and the
+    // pipeline starts over from the level after it. Either way the level is the same one.
+    void resetLevel() {
+        MAZE_TIMED_SCOPE(STAGE_NEXT_LEVEL);
+        const LevelSpec spec = { seed, level, dimension, algorithm, enemies.size() };
+        std::unique_ptr<PreparedLevel> prepared;
+        if (pipeline) prepared = pipeline->take(spec);
+        if (prepared) {
+            maze.swap(prepared->maze);
+            freeCells.swap(prepared->freeCells);
+            itemSquares.swap(prepared->itemSquares);
+            applyLevelSetup(prepared->setup);
+            pipeline->recycle(std::move(prepared)); // The old level's buffers go back to the worker
+            return;
+        }
+        buildLevel(spec, maze, freeCells, itemSquares, setupScratch, solver, generatorScratch);
+        applyLevelSetup(setupScratch);
+        restartPipeline();
+        // moves = 0; // Optional: Reset moves per level? Currently cumulative.
+    }
+
+    // Build up to 'levels' upcoming levels on a background thread while the current one is
+    // played, so finishing a level doesn't stall on generating the next (0 = off, the
+    // default). Levels come out the same either way.
+    void setPregenerateDepth(std::size_t levels) {
+        pipeline.reset();
+        if (levels == 0) return;
+        pipeline.reset(new LevelPipeline(
+            [](const LevelSpec& spec, PreparedLevel& out, LevelSolver& levelSolver, MazeGeneratorScratch& generatorBuffers) {
+                buildLevel(spec, out.maze, out.freeCells, out.itemSquares, out.setup, levelSolver, generatorBuffers);
+            },
+            &BasicMazeGame::followingLevel, levels));
+        restartPipeline();
+    }
+    std::size_t getPregenerateDepth() const { return pipeline ? pipeline->getDepth() : 0; }
+    const LevelPipeline* getPipeline() const { return pipeline.get(); } // null when off
+
+    // Keep the last 'steps' steps (player moves with the enemies' turn, and enemy ticks)
+    // undoable; 0 = no history, the default. Each step is stored as a small delta: the
+    // player's move, the item it took, the score and one nibble per enemy, about
+    // 40 + enemies / 2 bytes. A step that finished a level also keeps a snapshot of each side
+    // (O(items + enemies); the wall planes are shared with the boards copy-on-write).
+    // Loading, a new game or spawning / removing enemies clears the history.
+    void setUndoDepth(std::size_t steps) {
+        recording = false;
+        history.setCapacity(steps);
+    }
+    std::size_t getUndoDepth() const { return history.getCapacity(); }
+    bool canUndo() const { return history.canUndo(); }
+    bool canRedo() const { return history.canRedo(); }
+    void clearHistory() { history.clear(); }
+    const UndoHistory& getHistory() const { return history; }
+
+    // Take back the last recorded step; false if there is none. O(enemies) within a level;
+    // undoing the step that finished a level puts the old board back from its snapshot
+    // (O(board)). A caught player is alive again after undoing the step that caught them.
+    bool undo() {
+        const UndoRecord* r = history.stepBack();
+        if (!r) return false;
+        if (r->levelJump) restoreSnapshot(r->levelJump->before, nullptr);
+        applyRecord(*r, false);
+        return true;
+    }
+
+    // Play the last undone step again, exactly as it went the first time; false if there is
+    // none (or a new step was taken since the undo). Same cost as undo().
+    bool redo() {
+        const UndoRecord* r = history.stepForward();
+        if (!r) return false;
+        if (r->levelJump) restoreSnapshot(r->levelJump->after, nullptr);
+        else applyRecord(*r, true);
+        return true;
+    }
+
+    // Capture the whole game for saving. Costs O(items + enemies), not O(board): the wall
+    // plane is shared with the grid copy-on-write, so this is safe to call every few moves
+    // on a huge maze and hand to a background writer (see AutoSave.h).
+    SaveSnapshot snapshot() const {
+        SaveSnapshot snap;
+        std::memset(&snap.header, 0, sizeof(snap.header));
+        snap.header.rows = maze.getRows();
+        snap.header.cols = maze.getCols();
+        snap.header.level = level;
+        snap.header.score = score;
+        snap.header.moves = moves;
+        snap.header.collectibles = collectibles;
+        snap.header.playerX = player.getX();
+        snap.header.playerY = player.getY();
+        snap.header.exitX = exitX;
+        snap.header.exitY = exitY;
+        snap.header.seed = seed;
+        snap.header.tick = tick;
+        snap.header.levelRngState = levelRng.getState();
+        snap.header.parMoves = parMoves;
+        snap.header.levelStartMoves = levelStartMoves;
+        snap.walls = maze.shareWallPlane();
+        snap.items = itemSquares;
+        snap.enemyXs.assign(enemies.xData(), enemies.xData() + enemies.size());
+        snap.enemyYs.assign(enemies.yData(), enemies.yData() + enemies.size());
+        return snap;
+    }
+
+    // Write the game state in the binary format (MazeSave.h): header, wall plane, item list,
+    // enemy arrays and a CRC-32, replacing 'filename' atomically. Returns false (and fills
+    // 'error') if the file can't be written.
+    bool saveGame(const std::string& filename, std::string* error = nullptr) const {
+        return writeSaveFile(snapshot(), filename, error);
+    }
+
+    // Write the game state in the classic text format (one maze row per line). Slower and
+    // bigger than saveGame(), but readable and loadable by older versions of the game.
+    bool saveGameText(const std::string& filename, std::string* error = nullptr) const {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            if (error) *error = "Could not open file " + filename + " for saving!";
+            return false;
+        }
+        file << level << " " << score << " " << moves << " " << collectibles << "\n";
+        file << player.getX() << " " << player.getY() << "\n";
+        file << enemies.size() << "\n";
+        for (std::size_t i = 0; i < enemies.size(); i++) {
+            file << enemies.getX(i) << " " << enemies.getY(i) << "\n";
+        }
+        // One line per row, written straight from the grid's row buffer
+        for (int i = 0; i < maze.getRows(); i++) {
+            file.write(maze.row(i), maze.getCols());
+            file << '\n';
+        }
+        return true;
+    }
+
+    // Load a save in either format; binary files are recognised by their magic, anything
+    // else is parsed as text. On any error nothing is changed, 'error' describes the problem
+    // and false is returned.
+    bool loadGame(const std::string& filename, std::string* error = nullptr) {
+        MappedFile file;
+        if (!file.open(filename)) {
+            if (error) *error = "Could not open file " + filename + " for loading!";
+            return false;
+        }
+        if (hasSaveMagic(file.data(), file.size())) return loadSaveData(file.data(), file.size(), error);
+        file.close();
+        return loadText(filename, error);
+    }
+
+    // Parse a binary save held in memory (a mapped file, or a state embedded in a replay log).
+    // The wall plane is copied once, into the new grid; nothing changes unless the whole
+    // save checks out.
+    bool loadSaveData(const unsigned char* data, std::size_t bytes, std::string* error = nullptr) {
+        SaveHeader header;
+        std::memset(&header, 0, sizeof(header));
+        if (bytes < SAVE_HEADER_BYTES_V1) { if (error) *error = "Save file is truncated (no complete header)."; return false; }
+        std::memcpy(&header, data, SAVE_HEADER_BYTES_V1);
+        if (header.byteOrder != SAVE_BYTE_ORDER) { if (error) *error = "Save file was written with a different byte order."; return false; }
+        if (header.version < 1 || header.version > SAVE_VERSION) {
+            if (error) *error = "Unsupported save file version " + std::to_string(header.version) + ".";
+            return false;
+        }
+        const std::size_t headerBytes = header.version == 1 ? SAVE_HEADER_BYTES_V1
+                                        : header.version == 2 ? SAVE_HEADER_BYTES_V2 : sizeof(SaveHeader);
+        if (header.headerBytes != headerBytes || header.fileBytes != bytes) {
+            if (error) *error = "Save file is truncated or has trailing data.";
+            return false;
+        }
+        std::memcpy(&header, data, headerBytes);
+        const std::uint32_t storedCrc = header.crc;
+        header.crc = 0;
+        std::uint32_t crc = Crc32::update(0, &header, headerBytes);
+        crc = Crc32::update(crc, data + headerBytes, bytes - headerBytes);
+        if (crc != storedCrc) { if (error) *error = "Save file is corrupt (checksum mismatch)."; return false; }
+
+        // The CRC only proves the file is what was written; the layout still has to make sense
+        const int rows = header.rows, cols = header.cols;
+        if (rows < MIN_MAZE_DIMENSION || rows != cols) { if (error) *error = "Save file has an invalid board size."; return false; }
+        const std::uint64_t wordsPerRow = (static_cast<std::uint64_t>(cols) + 63) / 64;
+        const std::uint64_t wallBytes = static_cast<std::uint64_t>(rows) * wordsPerRow * sizeof(std::uint64_t);
+        const std::uint64_t limit = bytes;
+        if (header.wallOffset % 8 != 0 || header.wallOffset > limit || wallBytes > limit - header.wallOffset ||
+            header.itemOffset % 4 != 0 || header.itemOffset > limit || header.itemCount > (limit - header.itemOffset) / 8 ||
+            header.enemyOffset % 4 != 0 || header.enemyOffset > limit || header.enemyCount > (limit - header.enemyOffset) / 8) {
+            if (error) *error = "Save file sections do not fit in the file.";
+            return false;
+        }
+
+        SaveSnapshot snap;
+        snap.header = header;
+        if (header.version == 1) snap.header.levelRngState = mix64(levelSeedFor(header.seed, header.level) + 1);
+        if (header.version < 3) {
+            snap.header.parMoves = -1; // Par was not saved: the level continues without one
+            snap.header.levelStartMoves = header.moves;
+        }
+        std::shared_ptr<std::uint64_t[]> walls(new std::uint64_t[static_cast<std::size_t>(wallBytes / sizeof(std::uint64_t))]);
+        if (wallBytes) std::memcpy(walls.get(), data + header.wallOffset, static_cast<std::size_t>(wallBytes));
+        snap.walls = walls;
+        snap.items.resize(static_cast<std::size_t>(header.itemCount) * 2);
+        if (header.itemCount) std::memcpy(snap.items.data(), data + header.itemOffset, snap.items.size() * sizeof(std::int32_t));
+        const std::size_t enemyCount = static_cast<std::size_t>(header.enemyCount);
+        snap.enemyXs.resize(enemyCount);
+        snap.enemyYs.resize(enemyCount);
+        if (enemyCount) {
+            std::memcpy(snap.enemyXs.data(), data + header.enemyOffset, enemyCount * sizeof(std::int32_t));
+            std::memcpy(snap.enemyYs.data(), data + header.enemyOffset + enemyCount * sizeof(std::int32_t),
+                        enemyCount * sizeof(std::int32_t));
+        }
+        return restore(snap, error);
+    }
+
+    // Put the game back exactly as it was when 'snap' was taken (replay keyframes, loading).
+    // The wall plane is adopted copy-on-write, not copied. Positions are checked first (on
+    // the board, off the walls); on error nothing changes and false is returned. Clears the
+    // undo history.
+    bool restore(const SaveSnapshot& snap, std::string* error = nullptr) {
+        if (!restoreSnapshot(snap, error)) return false;
+        history.clear();
+        return true;
+    }
+
+private:
+    // restore() without touching the undo history (undo / redo across a level change)
+    bool restoreSnapshot(const SaveSnapshot& snap, std::string* error) {
+        const SaveHeader& header = snap.header;
+        const int rows = header.rows, cols = header.cols;
+        if (rows < MIN_MAZE_DIMENSION || rows != cols || !snap.walls || snap.enemyXs.size() != snap.enemyYs.size()) {
+            if (error) *error = "Save file has an invalid board size.";
+            return false;
+        }
+        if (FIXED && rows != H) {
+            if (error) *error = "Save file has a " + std::to_string(rows) + "x" + std::to_string(cols) +
+                                " board; this game plays " + std::to_string(H) + "x" + std::to_string(W) + ".";
+            return false;
+        }
+        MazeGrid loaded;
+        loaded.assignWallPlane(rows, cols, snap.walls);
+        const std::vector<std::int32_t>& items = snap.items;
+        for (std::size_t i = 0; i + 1 < items.size(); i += 2) {
+            if (!loaded.inBounds(items[i], items[i + 1]) || loaded.isWall(items[i], items[i + 1])) {
+                if (error) *error = "Save file has an item outside the open squares.";
+                return false;
+            }
+            loaded.set(items[i], items[i + 1], '*');
+        }
+        if (header.exitX != -1 || header.exitY != -1) {
+            // isWall() is also true off the board; set() would quietly clear a wall under the exit
+            if (loaded.isWall(header.exitX, header.exitY)) { if (error) *error = "Save file has an invalid exit."; return false; }
+            loaded.set(header.exitX, header.exitY, 'E');
+        }
+        if (loaded.isWall(header.playerX, header.playerY)) { if (error) *error = "Save file has an invalid player position."; return false; }
+        const std::size_t enemyCount = snap.enemyXs.size();
+        for (std::size_t i = 0; i < enemyCount; i++) {
+            if (loaded.isWall(snap.enemyXs[i], snap.enemyYs[i])) {
+                if (error) *error = "Save file has an enemy outside the open squares.";
+                return false;
+            }
+        }
+
+        // --- Everything checked, apply changes ---
+        std::vector<std::int32_t> itemList(items.begin(), items.end());
+        applyLoadedGame(loaded, header.level, header.score, header.moves, header.collectibles,
+                        header.playerX, header.playerY, itemList, header.exitX, header.exitY);
+        seed = header.seed;
+        tick = header.tick;
+        levelRng.setState(header.levelRngState);
+        parMoves = header.parMoves;
+        levelStartMoves = header.levelStartMoves;
+        enemies.reserve(enemyCount);
+        for (std::size_t i = 0; i < enemyCount; i++) addEnemy(snap.enemyXs[i], snap.enemyYs[i]);
+        refreshChaseField();
+        restartPipeline();
+        return true;
+    }
+
+    // Parse a text save. Two layouts are accepted: the current one (level score moves
+    // collectibles / player / enemy count + positions / grid) and the original one, which
+    // has only "level score moves", the player and the grid. The original layout has no
+    // enemies, and its item count is taken from the grid.
+    bool loadText(const std::string& filename, std::string* error) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            if (error) *error = "Could not open file " + filename + " for loading!";
+            return false;
+        }
+        // Temporary variables for reading
+        int loadedLevel, loadedScore, loadedMoves, loadedCollectibles = -1;
+        int px, py;
+        std::size_t enemyCount = 0;
+
+        // Read stats: the number of values on the first line tells the layouts apart
+        std::string line;
+        std::getline(file, line);
+        std::istringstream stats(line);
+        stats >> loadedLevel >> loadedScore >> loadedMoves;
+        if (stats.fail()) { if (error) *error = "Error reading game stats from save file."; return false; }
+        const bool legacy = !(stats >> loadedCollectibles);
+
+        // Read player position
+        file >> px >> py;
+        if (file.fail()) { if (error) *error = "Error reading player position from save file."; return false; }
+
+        // Read enemy count
+        if (!legacy) {
+            file >> enemyCount;
+            if (file.fail()) { if (error) *error = "Error reading enemy count from save file."; return false; }
+        }
+
+        std::vector<std::pair<int, int>> enemyPositions;
+        for (std::size_t i = 0; i < enemyCount; ++i) {
+            int ex, ey;
+            file >> ex >> ey;
+            if (file.fail()) {
+                if (error) *error = "Error reading enemy " + std::to_string(i) + " position from save file.";
+                return false; // Abort load
+            }
+            enemyPositions.push_back(std::make_pair(ex, ey));
+        }
+
+        // Read maze grid. The board size is not stored explicitly (older saves are 10x10),
+        // so it is taken from the grid itself: every row must be as long as the first one.
+        std::getline(file, line); // Consume the rest of the line after the last numbers
+        std::vector<std::string> rows;
+        while (std::getline(file, line)) {
+             if (!line.empty() && line.back() == '\r') line.pop_back(); // Tolerate CRLF saves
+             if (line.empty()) break;
+             if (!rows.empty() && line.length() != rows[0].length()) {
+                 if (error) *error = "Error reading maze grid line " + std::to_string(rows.size()) + ": row length mismatch in save file.";
+                 return false; // Abort load
+             }
+             rows.push_back(line);
+        }
+        if (rows.size() < static_cast<std::size_t>(MIN_MAZE_DIMENSION) || rows.size() != rows[0].length()) {
+             if (error) *error = "Error reading maze grid from save file (expected a square grid).";
+             return false; // Abort load
+        }
+        if (FIXED && rows.size() != static_cast<std::size_t>(H)) {
+             if (error) *error = "Save file has a " + std::to_string(rows.size()) + "x" + std::to_string(rows.size()) +
+                                 " board; this game plays " + std::to_string(H) + "x" + std::to_string(W) + ".";
+             return false; // Abort load
+        }
+        MazeGrid loaded(static_cast<int>(rows.size()), static_cast<int>(rows[0].length()));
+        std::vector<std::int32_t> items;
+        int loadedExitX = -1, loadedExitY = -1;
+        for (int i = 0; i < loaded.getRows(); i++) {
+            loaded.setRow(i, rows[i].data());
+            for (int j = 0; j < loaded.getCols(); j++) {
+                if (rows[i][j] == '*') {
+                    items.push_back(i);
+                    items.push_back(j);
+                } else if (rows[i][j] == 'E' && loadedExitX < 0) {
+                    loadedExitX = i;
+                    loadedExitY = j;
+                }
+            }
+        }
+        if (legacy) loadedCollectibles = static_cast<int>(items.size() / 2);
+        // Nobody may stand on a wall (isWall() is also true off the board)
+        if (loaded.isWall(px, py)) { if (error) *error = "Save file has an invalid player position."; return false; }
+        for (const auto& pos : enemyPositions) {
+            if (loaded.isWall(pos.first, pos.second)) {
+                if (error) *error = "Save file has an enemy outside the open squares.";
+                return false; // Abort load
+            }
+        }
+
+        // --- All reads succeeded, apply changes ---
+        history.clear();
+        applyLoadedGame(loaded, loadedLevel, loadedScore, loadedMoves, loadedCollectibles, px, py,
+                        items, loadedExitX, loadedExitY);
+        levelRng.setState(mix64(levelSeed() + 1));
+        for (const auto& pos : enemyPositions) {
+            addEnemy(pos.first, pos.second);
+        }
+        refreshChaseField();
+        restartPipeline();
+        return true;
+    }
+
+    // Shared tail of both loaders: take over the parsed board and stats, drop the enemies.
+    // The caller adds the loaded enemies and refreshes the chase field.
+    void applyLoadedGame(MazeGrid& loaded, int loadedLevel, int loadedScore, int loadedMoves,
+                         int loadedCollectibles, int px, int py, std::vector<std::int32_t>& items,
+                         int loadedExitX, int loadedExitY) {
+        maze.swap(loaded);
+        itemSquares.swap(items);
+        exitX = loadedExitX;
+        exitY = loadedExitY;
+        dimension = maze.getRows();
+        level = loadedLevel;
+        score = loadedScore;
+        moves = loadedMoves;
+        collectibles = loadedCollectibles;
+        gameOver = false;
+        placementShortfall = 0;
+        parMoves = -1; // Text saves have no par; binary loads set it afterwards
+        levelStartMoves = moves;
+        player.setPosition(px, py);
+        clearEnemies(); // Also re-dimensions the occupancy index for the loaded board
+        rebuildFreeCells();
+    }
+};
+
+// The game on a board of any size, chosen when it is constructed
+typedef BasicMazeGame<DYNAMIC_BOARD, DYNAMIC_BOARD> MazeSim;
+
+// The classic MAZE_DIMENSION x MAZE_DIMENSION board with every bound known at compile time,
+// for bulk simulation of standard games (plays exactly like MazeSim(MAZE_DIMENSION, seed))
+typedef BasicMazeGame<MAZE_DIMENSION, MAZE_DIMENSION> ClassicMazeSim;
+
+#endif // MAZE_SIM_H
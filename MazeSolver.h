@@ -0,0 +1,463 @@
+// MazeSolver.h
+#ifndef MAZE_SOLVER_H // Start of include guard
+#define MAZE_SOLVER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "MazeGrid.h" // Wall bitmap the solver works on
+
+// Level solver: can every item and the exit be reached, and what is the shortest route that
+// collects everything and then leaves? Three layers, each reusable on its own:
+//   ReachabilityMap    - flood fill on the wall bitmap 64 squares at a time
+//   pairwiseDistances  - shortest path lengths between the start, the items and the exit,
+//                        one multi-source BFS for up to 64 of them at once
+//   routeExact / routeHeuristic - the order to collect the items in: bitmask DP (optimal)
+//                        for up to EXACT_ITEM_LIMIT items, nearest neighbour + 2-opt beyond
+// MazeSim uses it to reject levels it cannot finish and to set each level's par.
+// Squares are (x, y) = (row, column) like everywhere else; only walls block (items, the exit
+// and enemies are all walkable).
+
+// Index of the lowest set bit (v > 0)
+inline unsigned lowestBitIndex(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#else
+    unsigned bit = 0;
+    while (!(v & 1)) { v >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+// Bit set of the squares reachable from one start square.
+// The fill works on the wall plane's 64-bit words: a word is closed along its row in one
+// go (occluded fill: six shift/and steps each way), and only words that gained squares are
+// revisited, pushing new squares into the words above, below and beside them.
+class ReachabilityMap {
+private:
+    int rows, cols;
+    std::size_t wordsPerRow;
+    std::vector<std::uint64_t> bits; // Same layout as the wall plane, bit set = reached
+    std::vector<std::uint32_t> work; // Word indices that gained squares and wait to be spread
+    std::size_t reachedCount;
+
+    // Spread 'g' towards higher / lower bits through the set bits of 'p' (g must be inside p)
+    static std::uint64_t fillUp(std::uint64_t g, std::uint64_t p) {
+        g |= p & (g << 1);  p &= p << 1;
+        g |= p & (g << 2);  p &= p << 2;
+        g |= p & (g << 4);  p &= p << 4;
+        g |= p & (g << 8);  p &= p << 8;
+        g |= p & (g << 16); p &= p << 16;
+        return g | (p & (g << 32));
+    }
+    static std::uint64_t fillDown(std::uint64_t g, std::uint64_t p) {
+        g |= p & (g >> 1);  p &= p >> 1;
+        g |= p & (g >> 2);  p &= p >> 2;
+        g |= p & (g >> 4);  p &= p >> 4;
+        g |= p & (g >> 8);  p &= p >> 8;
+        g |= p & (g >> 16); p &= p >> 16;
+        return g | (p & (g >> 32));
+    }
+
+    static int popcount(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(v);
+#else
+        int n = 0;
+        for (; v; v &= v - 1) n++;
+        return n;
+#endif
+    }
+
+    // Open squares of one wall-plane word (padding bits past the last column count as walls)
+    std::uint64_t openWord(const MazeGrid& maze, int x, std::size_t w) const {
+        std::uint64_t open = ~maze.wallRow(x)[w];
+        if (w + 1 == wordsPerRow && (cols & 63)) open &= (std::uint64_t(1) << (cols & 63)) - 1;
+        return open;
+    }
+
+    // Add 'squares' (already known to be open) to word (x, w); queue it if anything was new
+    void add(int x, std::size_t w, std::uint64_t squares) {
+        const std::size_t index = static_cast<std::size_t>(x) * wordsPerRow + w;
+        squares &= ~bits[index];
+        if (!squares) return;
+        bits[index] |= squares;
+        work.push_back(static_cast<std::uint32_t>(index));
+    }
+
+public:
+    ReachabilityMap() : rows(0), cols(0), wordsPerRow(0), reachedCount(0) {}
+
+    // Everything reachable from (x, y) through non-wall squares. Nothing is reached if the
+    // start itself is a wall or off the board. Returns the number of squares reached.
+    std::size_t flood(const MazeGrid& maze, int x, int y) {
+        rows = maze.getRows();
+        cols = maze.getCols();
+        wordsPerRow = maze.getWordsPerRow();
+        bits.assign(static_cast<std::size_t>(rows) * wordsPerRow, 0);
+        work.clear();
+        reachedCount = 0;
+        if (maze.isWall(x, y)) return 0;
+        add(x, static_cast<std::size_t>(y) >> 6, std::uint64_t(1) << (y & 63));
+
+        while (!work.empty()) {
+            const std::uint32_t index = work.back();
+            work.pop_back();
+            const int r = static_cast<int>(index / wordsPerRow);
+            const std::size_t w = index % wordsPerRow;
+            const std::uint64_t open = openWord(maze, r, w);
+            const std::uint64_t filled = fillDown(fillUp(bits[index], open), open);
+            bits[index] = filled;
+            // Runs that touch the word's edges continue in the neighbouring words
+            if ((filled >> 63) && w + 1 < wordsPerRow) add(r, w + 1, openWord(maze, r, w + 1) & 1);
+            if ((filled & 1) && w > 0) add(r, w - 1, openWord(maze, r, w - 1) & (std::uint64_t(1) << 63));
+            if (r > 0) add(r - 1, w, filled & openWord(maze, r - 1, w));
+            if (r + 1 < rows) add(r + 1, w, filled & openWord(maze, r + 1, w));
+        }
+        for (std::uint64_t word : bits) reachedCount += popcount(word);
+        return reachedCount;
+    }
+
+    bool reached(int x, int y) const {
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(rows) || static_cast<unsigned>(y) >= static_cast<unsigned>(cols)) return false;
+        return (bits[static_cast<std::size_t>(x) * wordsPerRow + (y >> 6)] >> (y & 63)) & 1;
+    }
+
+    std::size_t count() const { return reachedCount; }
+    std::size_t getWordsPerRow() const { return wordsPerRow; }
+    const std::uint64_t* row(int x) const { return &bits[static_cast<std::size_t>(x) * wordsPerRow]; }
+};
+
+// What the solver found out about a level
+struct LevelSolution {
+    bool exitReachable;
+    int unreachableItems;
+    int parMoves;           // Fewest moves that collect every item and end on the exit (-1 = unsolvable)
+    bool exact;             // parMoves is optimal (DP); otherwise a heuristic upper bound
+    std::vector<int> route; // Item indices in collection order
+
+    LevelSolution() : exitReachable(false), unreachableItems(0), parMoves(-1), exact(false) {}
+    bool solvable() const { return exitReachable && unreachableItems == 0; }
+};
+
+class LevelSolver {
+public:
+    static constexpr std::uint32_t UNREACHABLE = 0xFFFFFFFFu;
+    static constexpr int EXACT_ITEM_LIMIT = 12; // 2^12 * 12 DP states; beyond this, heuristic
+
+    // Working memory of the route searches, for callers that run many of them
+    struct RouteScratch {
+        std::vector<std::uint32_t> best;   // routeExact: best[mask * n + last]
+        std::vector<std::int8_t> previous; // routeExact: item visited before 'last'
+        std::vector<std::size_t> order;    // routeHeuristic: point indices, start .. exit
+        std::vector<std::uint8_t> used;    // routeHeuristic: point already on the route
+    };
+
+private:
+    ReachabilityMap reach;
+
+    // Multi-source BFS scratch, reused between levels
+    std::vector<std::uint8_t> moves;  // Per square: MOVE_* bits for open neighbours, POINT_HERE if a point sits on it
+    std::vector<std::uint64_t> seen;  // Per square: which sources have reached it
+    std::vector<std::uint32_t> slot;  // Per square: its entry in 'next' this level (NO_SLOT if none)
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> frontier, next; // (square, sources arriving)
+    std::vector<std::uint32_t> distances; // count x count, row-major
+    std::vector<std::size_t> needed;      // Per source: points it still has to find
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pointsAt; // (square, point) sorted by square
+    std::vector<std::pair<int, int>> points; // solve(): start, items, exit
+    RouteScratch routeScratch;
+    LevelSolution solution;                  // solve()'s result, route buffer reused
+
+    static constexpr std::uint32_t NO_SLOT = 0xFFFFFFFFu;
+    static constexpr std::uint8_t MOVE_UP = 1, MOVE_DOWN = 2, MOVE_LEFT = 4, MOVE_RIGHT = 8, POINT_HERE = 16;
+
+    // Neighbour masks for every square, built a wall-plane word at a time, so the BFS below
+    // steps with cell +- 1 / +- cols and never divides or bounds-checks
+    void buildMoves(const MazeGrid& maze) {
+        const int rows = maze.getRows(), cols = maze.getCols();
+        const std::size_t words = maze.getWordsPerRow();
+        moves.assign(static_cast<std::size_t>(rows) * cols, 0);
+        for (int x = 0; x < rows; x++) {
+            const std::uint64_t* here = maze.wallRow(x);
+            const std::uint64_t* above = x > 0 ? maze.wallRow(x - 1) : nullptr;
+            const std::uint64_t* below = x + 1 < rows ? maze.wallRow(x + 1) : nullptr;
+            std::uint8_t* out = &moves[static_cast<std::size_t>(x) * cols];
+            for (std::size_t w = 0; w < words; w++) {
+                const std::uint64_t open = ~here[w];
+                if (!open) continue;
+                const std::uint64_t up = above ? open & ~above[w] : 0;
+                const std::uint64_t down = below ? open & ~below[w] : 0;
+                // Left / right neighbours, including the squares across the word boundary
+                std::uint64_t left = open & ~(here[w] << 1);
+                if (w == 0) left &= ~std::uint64_t(1);
+                else left &= ~((here[w - 1] >> 63) & 1) | ~std::uint64_t(1);
+                std::uint64_t right = open & ~(here[w] >> 1);
+                if (w + 1 < words) right &= ~((here[w + 1] & 1) << 63) | ~(std::uint64_t(1) << 63);
+                else right &= ~(std::uint64_t(1) << 63);
+                const int begin = static_cast<int>(w * 64);
+                const int end = begin + 64 < cols ? begin + 64 : cols;
+                for (int y = begin; y < end; y++) {
+                    const unsigned b = static_cast<unsigned>(y - begin);
+                    out[y] = static_cast<std::uint8_t>(((up >> b) & 1) | (((down >> b) & 1) << 1) |
+                                                       (((left >> b) & 1) << 2) | (((right >> b) & 1) << 3));
+                }
+                // The last column's right neighbour is off the board
+                if (end == cols) out[cols - 1] &= static_cast<std::uint8_t>(~MOVE_RIGHT);
+            }
+        }
+    }
+
+    // One multi-source BFS for points[first .. first + n), n <= 64. All sources advance
+    // together, one bit each: a square is expanded once per level at which any source first
+    // gets there, carrying all of those sources at once. Distances are symmetric, so a source
+    // only looks for the points after it and drops out once it has found them all.
+    void bfsBatch(const std::vector<std::pair<int, int>>& points, std::size_t first, std::size_t n, int cols) {
+        const std::size_t count = points.size();
+        std::fill(seen.begin(), seen.end(), 0);
+        frontier.clear();
+        std::uint64_t active = 0; // Sources still searching
+        for (std::size_t i = 0; i < n; i++) {
+            needed[first + i] = count - (first + i) - 1;
+            if (needed[first + i]) active |= std::uint64_t(1) << i;
+        }
+
+        // Record 'sources' reaching the points on 'cell' at distance 'level'
+        auto arrive = [&](std::uint32_t cell, std::uint64_t sources, std::uint32_t level) {
+            auto at = std::lower_bound(pointsAt.begin(), pointsAt.end(), std::make_pair(cell, std::uint32_t(0)));
+            for (; at != pointsAt.end() && at->first == cell; ++at) {
+                const std::uint32_t p = at->second;
+                for (std::uint64_t s = sources; s; s &= s - 1) {
+                    const std::size_t source = first + lowestBitIndex(s);
+                    if (p <= source) continue;
+                    distances[source * count + p] = level;
+                    if (--needed[source] == 0) active &= ~(std::uint64_t(1) << (source - first));
+                }
+            }
+        };
+
+        for (std::size_t i = 0; i < n; i++) {
+            const std::uint32_t cell = static_cast<std::uint32_t>(points[first + i].first) * cols + points[first + i].second;
+            if (!seen[cell]) frontier.push_back(std::make_pair(cell, std::uint64_t(0)));
+            seen[cell] |= std::uint64_t(1) << i;
+        }
+        for (auto& entry : frontier) {
+            entry.second = seen[entry.first];
+            arrive(entry.first, entry.second, 0);
+        }
+
+        const std::int64_t steps[4] = { -static_cast<std::int64_t>(cols), cols, -1, 1 }; // MOVE_UP .. MOVE_RIGHT
+        for (std::uint32_t level = 1; !frontier.empty() && active; level++) {
+            next.clear();
+            for (const auto& entry : frontier) {
+                const std::uint64_t carried = entry.second & active;
+                if (!carried) continue;
+                const unsigned open = moves[entry.first] & 15u;
+                for (int k = 0; k < 4; k++) {
+                    if (!(open & (1u << k))) continue;
+                    const std::uint32_t cell = static_cast<std::uint32_t>(entry.first + steps[k]);
+                    const std::uint64_t fresh = carried & ~seen[cell];
+                    if (!fresh) continue;
+                    seen[cell] |= fresh;
+                    if (slot[cell] == NO_SLOT) {
+                        slot[cell] = static_cast<std::uint32_t>(next.size());
+                        next.push_back(std::make_pair(cell, fresh));
+                    } else {
+                        next[slot[cell]].second |= fresh;
+                    }
+                }
+            }
+            for (const auto& entry : next) {
+                slot[entry.first] = NO_SLOT;
+                if (moves[entry.first] & POINT_HERE) arrive(entry.first, entry.second, level);
+            }
+            frontier.swap(next);
+        }
+    }
+
+public:
+    // Flood from (x, y); the map stays valid until the next flood or solve
+    const ReachabilityMap& flood(const MazeGrid& maze, int x, int y) {
+        reach.flood(maze, x, y);
+        return reach;
+    }
+    const ReachabilityMap& getReachability() const { return reach; }
+
+    // Shortest path lengths (in moves) between every pair of points, as a points.size()^2
+    // row-major matrix; UNREACHABLE where there is no path. Points must be inside the board.
+    const std::vector<std::uint32_t>& pairwiseDistances(const MazeGrid& maze, const std::vector<std::pair<int, int>>& points) {
+        const std::size_t count = points.size();
+        const int cols = maze.getCols();
+        const std::size_t cells = static_cast<std::size_t>(maze.getRows()) * cols;
+        distances.assign(count * count, UNREACHABLE);
+        needed.assign(count, 0);
+        if (seen.size() != cells) {
+            seen.assign(cells, 0);
+            slot.assign(cells, NO_SLOT);
+        }
+        buildMoves(maze);
+        pointsAt.clear();
+        for (std::size_t i = 0; i < count; i++) {
+            const std::uint32_t cell = static_cast<std::uint32_t>(points[i].first) * cols + points[i].second;
+            pointsAt.push_back(std::make_pair(cell, static_cast<std::uint32_t>(i)));
+            moves[cell] |= POINT_HERE;
+        }
+        std::sort(pointsAt.begin(), pointsAt.end());
+        for (std::size_t first = 0; first < count; first += 64) {
+            bfsBatch(points, first, std::min<std::size_t>(64, count - first), cols);
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            distances[i * count + i] = 0;
+            for (std::size_t j = 0; j < i; j++) distances[i * count + j] = distances[j * count + i];
+        }
+        return distances;
+    }
+
+    // Optimal order for a route that starts at point 0, visits points 1 .. count-2 and ends at
+    // point count-1, given the distance matrix. Held-Karp DP over subsets: O(2^n * n^2) for n
+    // items. Returns the route length (UNREACHABLE if any leg is missing) and fills 'route'
+    // with item indices (0-based, i.e. point index - 1).
+    static std::uint32_t routeExact(const std::vector<std::uint32_t>& dist, std::size_t count, std::vector<int>& route) {
+        RouteScratch scratch;
+        return routeExact(dist, count, route, scratch);
+    }
+    static std::uint32_t routeExact(const std::vector<std::uint32_t>& dist, std::size_t count, std::vector<int>& route,
+                                    RouteScratch& scratch) {
+        route.clear();
+        const std::size_t exit = count - 1;
+        const int n = static_cast<int>(count) - 2;
+        if (n <= 0) return dist[exit];
+        const std::size_t states = std::size_t(1) << n;
+        std::vector<std::uint32_t>& best = scratch.best; // best[mask * n + last]
+        std::vector<std::int8_t>& previous = scratch.previous;
+        best.assign(states * n, UNREACHABLE);
+        previous.assign(states * n, -1);
+        for (int i = 0; i < n; i++) best[(std::size_t(1) << i) * n + i] = dist[i + 1];
+        for (std::size_t mask = 1; mask < states; mask++) {
+            for (int last = 0; last < n; last++) {
+                const std::uint32_t here = best[mask * n + last];
+                if (here == UNREACHABLE || !(mask & (std::size_t(1) << last))) continue;
+                for (int to = 0; to < n; to++) {
+                    if (mask & (std::size_t(1) << to)) continue;
+                    const std::uint32_t leg = dist[(last + 1) * count + to + 1];
+                    if (leg == UNREACHABLE) continue;
+                    const std::size_t into = (mask | (std::size_t(1) << to)) * n + to;
+                    if (here + leg < best[into]) {
+                        best[into] = here + leg;
+                        previous[into] = static_cast<std::int8_t>(last);
+                    }
+                }
+            }
+        }
+        std::uint32_t total = UNREACHABLE;
+        int last = -1;
+        for (int i = 0; i < n; i++) {
+            const std::uint32_t here = best[(states - 1) * n + i];
+            const std::uint32_t leg = dist[(i + 1) * count + exit];
+            if (here == UNREACHABLE || leg == UNREACHABLE) continue;
+            if (here + leg < total) {
+                total = here + leg;
+                last = i;
+            }
+        }
+        if (last < 0) return UNREACHABLE;
+        for (std::size_t mask = states - 1; last >= 0;) {
+            route.push_back(last);
+            const int before = previous[mask * n + last];
+            mask &= ~(std::size_t(1) << last);
+            last = before;
+        }
+        std::reverse(route.begin(), route.end());
+        return total;
+    }
+
+    // Same contract as routeExact for any number of items, without the optimality: greedy
+    // nearest-neighbour order, then 2-opt (reverse a stretch of the route whenever that makes
+    // it shorter) until no reversal helps or 'maxPasses' sweeps have run.
+    static std::uint32_t routeHeuristic(const std::vector<std::uint32_t>& dist, std::size_t count, std::vector<int>& route,
+                                        int maxPasses = 50) {
+        RouteScratch scratch;
+        return routeHeuristic(dist, count, route, scratch, maxPasses);
+    }
+    static std::uint32_t routeHeuristic(const std::vector<std::uint32_t>& dist, std::size_t count, std::vector<int>& route,
+                                        RouteScratch& scratch, int maxPasses = 50) {
+        route.clear();
+        const std::size_t exit = count - 1;
+        const int n = static_cast<int>(count) - 2;
+        if (n <= 0) return dist[exit];
+        std::vector<std::size_t>& order = scratch.order; // Point indices: start, items..., exit
+        order.clear();
+        order.push_back(0);
+        std::vector<std::uint8_t>& used = scratch.used;
+        used.assign(count, 0);
+        for (int k = 0; k < n; k++) {
+            const std::size_t from = order.back();
+            std::size_t pick = 0;
+            std::uint32_t nearest = UNREACHABLE;
+            for (std::size_t p = 1; p < exit; p++) {
+                if (!used[p] && dist[from * count + p] < nearest) {
+                    nearest = dist[from * count + p];
+                    pick = p;
+                }
+            }
+            if (nearest == UNREACHABLE) return UNREACHABLE;
+            used[pick] = 1;
+            order.push_back(pick);
+        }
+        order.push_back(exit);
+        if (dist[order[n] * count + exit] == UNREACHABLE) return UNREACHABLE;
+
+        auto d = [&](std::size_t a, std::size_t b) { return static_cast<std::int64_t>(dist[order[a] * count + order[b]]); };
+        bool improved = true;
+        for (int pass = 0; improved && pass < maxPasses; pass++) {
+            improved = false;
+            for (int i = 1; i < n; i++) {
+                for (int j = i + 1; j <= n; j++) {
+                    // Reverse order[i..j]: legs (i-1, i) and (j, j+1) become (i-1, j) and (i, j+1)
+                    if (d(i - 1, j) + d(i, j + 1) < d(i - 1, i) + d(j, j + 1)) {
+                        std::reverse(order.begin() + i, order.begin() + j + 1);
+                        improved = true;
+                    }
+                }
+            }
+        }
+        std::uint32_t total = 0;
+        for (std::size_t k = 0; k + 1 < order.size(); k++) total += dist[order[k] * count + order[k + 1]];
+        for (int k = 1; k <= n; k++) route.push_back(static_cast<int>(order[k]) - 1);
+        return total;
+    }
+
+    // Check a level and find its par. 'items' holds (x, y) pairs like MazeSim's item list;
+    // exitX < 0 means the board has no exit (never solvable). The result stays valid until the
+    // next solve; once the buffers have grown to the level's size, solving allocates nothing.
+    const LevelSolution& solve(const MazeGrid& maze, int startX, int startY, const std::vector<std::int32_t>& items,
+                               int exitX, int exitY) {
+        solution.exitReachable = false; // Field by field, so the route keeps its buffer
+        solution.unreachableItems = 0;
+        solution.parMoves = -1;
+        solution.exact = false;
+        solution.route.clear();
+        reach.flood(maze, startX, startY);
+        solution.exitReachable = exitX >= 0 && reach.reached(exitX, exitY);
+        for (std::size_t i = 0; i + 1 < items.size(); i += 2) {
+            if (!reach.reached(items[i], items[i + 1])) solution.unreachableItems++;
+        }
+        if (!solution.solvable()) return solution;
+
+        points.clear();
+        points.push_back(std::make_pair(startX, startY));
+        for (std::size_t i = 0; i + 1 < items.size(); i += 2) points.push_back(std::make_pair(items[i], items[i + 1]));
+        points.push_back(std::make_pair(exitX, exitY));
+        const std::vector<std::uint32_t>& dist = pairwiseDistances(maze, points);
+
+        solution.exact = points.size() - 2 <= static_cast<std::size_t>(EXACT_ITEM_LIMIT);
+        const std::uint32_t length = solution.exact ? routeExact(dist, points.size(), solution.route, routeScratch)
+                                                    : routeHeuristic(dist, points.size(), solution.route, routeScratch);
+        solution.parMoves = length == UNREACHABLE ? -1 : static_cast<int>(length);
+        return solution;
+    }
+};
+
+#endif // MAZE_SOLVER_H
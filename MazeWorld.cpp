@@ -0,0 +1,256 @@
+// MazeWorld.cpp
+// Worlds larger than memory (POSIX):
+//
+//   MazeWorld create [file] [size] [seed] [itemEvery]   - stream a size x size world to disk
+//   MazeWorld play [file] [cacheTiles]                  - walk a world in the console (w a s d, q quits)
+//   MazeWorld bench [sizes] [steps] [cacheTiles] [jumpEvery]
+//                        - step latency, resident memory and page faults as the world grows
+//
+// 'sizes' is a comma-separated list (default 1001,8001,32001; 100001 makes a 2.5 GB file).
+// bench writes each world next to the binary (maze_world_bench.dat, removed afterwards),
+// drops it from the page cache so the run starts cold, then walks it with a wall follower
+// that fast-travels to a random square every 'jumpEvery' steps, landing in tiles that were
+// never loaded.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "WorldSim.h"        // Game on a tiled, memory-mapped world
+#include "Console.h"         // _getch() for play mode
+#include "Instrumentation.h" // LatencyHistogram
+
+using namespace std;
+
+static size_t procStatusKb(const char* field) {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    size_t kb = 0;
+    const size_t length = strlen(field);
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, field, length) == 0 && line[length] == ':') {
+            sscanf(line + length + 1, "%zu", &kb);
+            break;
+        }
+    }
+    fclose(f);
+    return kb;
+}
+
+struct FaultCounts {
+    long minor, major;
+};
+
+static FaultCounts faultCounts() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return FaultCounts{ usage.ru_minflt, usage.ru_majflt };
+}
+
+// Flush 'filename' and evict it from the page cache, so the next run reads it from disk
+static void dropPageCache(const string& filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static int runCreate(const string& filename, int size, uint64_t seed, int itemEvery) {
+    string error;
+    auto start = chrono::steady_clock::now();
+    if (!createWorldFile(filename, size, size, seed, itemEvery, &error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ChunkedWorld world;
+    if (!world.open(filename, &error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    printf("%s: %d x %d, %zu tiles, %.1f MB, %llu items, written in %.2f s (%.0f M squares/s)\n", filename.c_str(), size,
+           size, world.getTileCount(), world.getFileBytes() / (1024.0 * 1024.0),
+           static_cast<unsigned long long>(world.getItemCount()), seconds, static_cast<double>(size) * size / seconds / 1e6);
+    return 0;
+}
+
+static int runPlay(const string& filename, size_t cacheTiles) {
+    WorldSim sim;
+    string error;
+    if (!sim.open(filename, cacheTiles, &error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    FrameRenderer renderer;
+    string message;
+    for (;;) {
+        drawWorldFrame(renderer, sim);
+        if (!message.empty()) renderer.text(renderer.getHeight() - 1, 0, message, 12);
+        renderer.present(stdoutSink);
+        const char key = static_cast<char>(_getch());
+        if (key == 'q' || key == 'Q') break;
+        message.clear();
+        if (sim.isGameOver()) sim.revive(); // Any key continues
+        if (sim.step(actionFromKey(key)) & EVENT_CAUGHT) message = "--- Caught! --- Press any key to continue.";
+    }
+    cout << "Score: " << sim.getScore() << ", " << sim.getMoves() << " moves" << endl;
+    return 0;
+}
+
+// Left-hand wall follower: in a perfect maze it keeps walking new corridors
+struct WallFollower {
+    int heading = 3; // Index into UP, RIGHT, DOWN, LEFT (clockwise)
+
+    SimAction next(const WorldSim& sim) {
+        static const SimAction ACTIONS[4] = { ACTION_UP, ACTION_RIGHT, ACTION_DOWN, ACTION_LEFT };
+        static const int DX[4] = { -1, 0, 1, 0 };
+        static const int DY[4] = { 0, 1, 0, -1 };
+        const int x = sim.getPlayerX(), y = sim.getPlayerY();
+        for (int turn = 3; turn < 7; turn++) { // Left, straight, right, back
+            const int h = (heading + turn) % 4;
+            if (sim.getCell(x + DX[h], y + DY[h]) != '#') {
+                heading = h;
+                return ACTIONS[h];
+            }
+        }
+        return ACTION_NONE;
+    }
+};
+
+static void printLatency(const char* name, const LatencyHistogram& h) {
+    printf("  %-11s: p50 %.2f  p99 %.2f  p99.9 %.2f  max %.1f  mean %.2f us (%llu samples)\n", name,
+           h.percentile(0.5) / 1000.0, h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0, h.max() / 1000.0,
+           h.mean() / 1000.0, static_cast<unsigned long long>(h.count()));
+}
+
+static int runBench(const vector<int>& sizes, size_t steps, size_t cacheTiles, size_t jumpEvery) {
+    const string filename = "maze_world_bench.dat";
+    for (int size : sizes) {
+        string error;
+        auto start = chrono::steady_clock::now();
+        if (!createWorldFile(filename, size, size, 2024, 64, &error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        const double createSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        dropPageCache(filename);
+
+        const size_t rssBefore = procStatusKb("VmRSS");
+        WorldSim sim;
+        if (!sim.open(filename, cacheTiles, &error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        printf("world %d x %d: %.1f MB file, written in %.2f s\n", size, size,
+               sim.getWorld().getFileBytes() / (1024.0 * 1024.0), createSeconds);
+
+        LatencyHistogram stepNs, frameNs;
+        FrameRenderer renderer;
+        WallFollower walker;
+        mt19937 gen(7);
+        size_t jumps = 0, caught = 0, peakRss = 0;
+        const FaultCounts faultsBefore = faultCounts();
+        start = chrono::steady_clock::now();
+        for (size_t i = 1; i <= steps; i++) {
+            if (jumpEvery && i % jumpEvery == 0) {
+                // Cells of the maze lattice sit on odd squares, all open
+                const int x = 1 + 2 * static_cast<int>(gen() % static_cast<unsigned>((size - 1) / 2));
+                const int y = 1 + 2 * static_cast<int>(gen() % static_cast<unsigned>((size - 1) / 2));
+                auto t = chrono::steady_clock::now();
+                sim.teleport(x, y);
+                stepNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t).count()));
+                jumps++;
+                continue;
+            }
+            const SimAction action = walker.next(sim);
+            auto t = chrono::steady_clock::now();
+            const unsigned events = sim.step(action);
+            stepNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t).count()));
+            if (events & EVENT_CAUGHT) {
+                caught++;
+                sim.revive();
+            }
+            if (i % 16 == 0) {
+                t = chrono::steady_clock::now();
+                drawWorldFrame(renderer, sim);
+                renderer.present(nullSink);
+                frameNs.record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t).count()));
+            }
+            if (i % 4096 == 0) {
+                const size_t rss = procStatusKb("VmRSS");
+                if (rss > peakRss) peakRss = rss;
+            }
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        const FaultCounts faultsAfter = faultCounts();
+        const size_t rssAfter = procStatusKb("VmRSS");
+        if (rssAfter > peakRss) peakRss = rssAfter;
+        const ChunkedWorld& world = sim.getWorld();
+
+        printf("  steps      : %zu in %.2f s (%.0f steps/s), %zu jumps to random squares\n", steps, seconds, steps / seconds, jumps);
+        printLatency("step", stepNs);
+        printLatency("frame", frameNs);
+        printf("  tiles      : %zu resident of %zu (cache %zu = %.1f MB), %llu loaded, %llu evicted\n",
+               world.residentTiles(), world.getTileCount(), world.getCacheTiles(),
+               world.getCacheTiles() * WORLD_TILE_BYTES / (1024.0 * 1024.0),
+               static_cast<unsigned long long>(world.getTileLoads()), static_cast<unsigned long long>(world.getTileEvictions()));
+        printf("  memory     : RSS %.1f MB after the run, peak %.1f MB (%.1f MB before opening the world)\n",
+               rssAfter / 1024.0, peakRss / 1024.0, rssBefore / 1024.0);
+        printf("  page faults: %.2f minor, %.2f major per 1000 steps\n",
+               1000.0 * (faultsAfter.minor - faultsBefore.minor) / steps, 1000.0 * (faultsAfter.major - faultsBefore.major) / steps);
+        printf("  enemies    : %zu created, %.1f moving per step, %llu catch-up moves; caught %zu times, %d items\n",
+               sim.enemyCount(), static_cast<double>(sim.getEnemyMoves()) / steps,
+               static_cast<unsigned long long>(sim.getCatchUpMoves()), caught, sim.getCollected());
+    }
+    remove(filename.c_str());
+    return 0;
+}
+
+static void printUsage() {
+    cerr << "Usage:\n"
+         << "  MazeWorld create [file] [size] [seed] [itemEvery]\n"
+         << "  MazeWorld play [file] [cacheTiles]\n"
+         << "  MazeWorld bench [size,size,...] [steps] [cacheTiles] [jumpEvery]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    string mode = argv[1];
+    if (mode == "create") {
+        string file = argc > 2 ? argv[2] : "maze_world.dat";
+        int size = argc > 3 ? atoi(argv[3]) : 10001;
+        uint64_t seed = argc > 4 ? strtoull(argv[4], nullptr, 10) : static_cast<uint64_t>(time(0));
+        int itemEvery = argc > 5 ? atoi(argv[5]) : 64;
+        return runCreate(file, size, seed, itemEvery);
+    }
+    if (mode == "play") {
+        string file = argc > 2 ? argv[2] : "maze_world.dat";
+        size_t cacheTiles = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1024;
+        return runPlay(file, cacheTiles);
+    }
+    if (mode == "bench") {
+        vector<int> sizes;
+        stringstream list(argc > 2 ? argv[2] : "1001,8001,32001");
+        string item;
+        while (getline(list, item, ',')) {
+            if (atoi(item.c_str()) >= 3) sizes.push_back(atoi(item.c_str()));
+        }
+        size_t steps = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+        size_t cacheTiles = argc > 4 ? strtoull(argv[4], nullptr, 10) : 256;
+        size_t jumpEvery = argc > 5 ? strtoull(argv[5], nullptr, 10) : 20000;
+        return runBench(sizes, steps < 1 ? 1 : steps, cacheTiles, jumpEvery);
+    }
+    printUsage();
+    return 1;
+}
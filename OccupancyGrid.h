@@ -0,0 +1,237 @@
+// OccupancyGrid.h
+#ifndef OCCUPANCY_GRID_H // Start of include guard
+#define OCCUPANCY_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Spatial index answering "who is at (x, y)?" in O(1).
+// Each occupied cell holds the head of an intrusive doubly-linked list of the entity ids
+// standing on it; stacked entities are simply chained. Entity ids are small dense integers
+// chosen by the owner (MazeSim uses the enemy's id in its EnemyStore).
+// Two storage modes, picked from the board size and how many entities it holds:
+//  - DENSE: one int per cell. Fastest (a move is a handful of array writes), used on small
+//    boards (up to SMALL_BOARD_CELLS cells) and once entities are dense enough that the
+//    array costs no more than the hash table would: one entity per DENSE_RATIO cells, and
+//    never past DENSE_CELL_LIMIT cells.
+//  - HASHED: only occupied cells, in an open-addressing hash table keyed by cell index, so
+//    memory follows the number of entities rather than the board (a few dozen enemies on a
+//    4001 x 4001 board take kilobytes instead of a 61 MB array).
+// reset() starts a large board HASHED; insert() switches it to DENSE in one O(cells) pass
+// when the entity count crosses the ratio. It stays DENSE until the next reset().
+class OccupancyGrid {
+private:
+    static constexpr std::uint64_t EMPTY_KEY = ~std::uint64_t(0);
+    static constexpr int NONE = -1;
+    static constexpr std::uint64_t DENSE_CELL_LIMIT = 1u << 24;  // 16M cells = 64 MB of heads
+    static constexpr std::uint64_t SMALL_BOARD_CELLS = 1u << 20; // 4 MB of heads (1024 x 1024): always dense
+    static constexpr std::uint64_t DENSE_RATIO = 16; // 4 B a cell vs ~64 B a hashed entity (load <= 1/2, 16 B slots)
+
+    struct Slot {
+        std::uint64_t key; // Cell index (x * cols + y), EMPTY_KEY when unused
+        int head;          // First entity on the cell
+    };
+
+    int rows, cols;
+    std::vector<int> dense;            // DENSE mode: head per cell (empty in HASHED mode)
+    std::vector<Slot> table;           // HASHED mode: power-of-two sized, linear probing
+    std::size_t mask;
+    std::size_t used;                  // Occupied cells
+    std::vector<int> next, prev;       // Per-entity links within a cell's list
+    std::vector<std::uint64_t> cellOf; // Per-entity current cell, EMPTY_KEY if not placed
+
+    bool isDense() const { return !dense.empty(); }
+
+    std::uint64_t cellCount() const { return static_cast<std::uint64_t>(rows) * cols; }
+
+    // Should a board holding 'entities' ids use the dense array?
+    bool wantsDense(std::size_t entities) const {
+        const std::uint64_t cells = cellCount();
+        return cells <= SMALL_BOARD_CELLS || (cells <= DENSE_CELL_LIMIT && entities * DENSE_RATIO >= cells);
+    }
+
+    // HASHED -> DENSE: move every occupied cell's list head into the array (the lists stay as they are)
+    void makeDense() {
+        dense.assign(static_cast<std::size_t>(cellCount()), NONE);
+        for (const Slot& s : table) {
+            if (s.key != EMPTY_KEY) dense[s.key] = s.head;
+        }
+        table.clear();
+        table.shrink_to_fit();
+    }
+
+    std::size_t home(std::uint64_t key) const {
+        // Fibonacci hashing spreads neighbouring cells across the table
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 20) & mask;
+    }
+
+    std::size_t find(std::uint64_t key) const {
+        std::size_t i = home(key);
+        while (table[i].key != EMPTY_KEY) {
+            if (table[i].key == key) return i;
+            i = (i + 1) & mask;
+        }
+        return i; // Empty slot where 'key' would go
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(table);
+        table.assign(old.empty() ? 64 : old.size() * 2, Slot{ EMPTY_KEY, NONE });
+        mask = table.size() - 1;
+        for (const Slot& s : old) {
+            if (s.key != EMPTY_KEY) table[find(s.key)] = s;
+        }
+    }
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    void eraseSlot(std::size_t i) {
+        std::size_t j = i;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (table[j].key == EMPTY_KEY) break;
+            std::size_t k = home(table[j].key);
+            bool movable = (j > i) ? (k <= i || k > j) : (k <= i && k > j);
+            if (movable) {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i] = Slot{ EMPTY_KEY, NONE };
+    }
+
+    int headOf(std::uint64_t key) const {
+        if (isDense()) return dense[key];
+        std::size_t i = find(key);
+        return table[i].key == EMPTY_KEY ? NONE : table[i].head;
+    }
+
+    void link(int id, std::uint64_t key) {
+        int* head;
+        if (isDense()) {
+            head = &dense[key];
+            if (*head == NONE) used++;
+        } else {
+            if (2 * (used + 1) > table.size()) grow();
+            std::size_t i = find(key);
+            if (table[i].key == EMPTY_KEY) {
+                table[i] = Slot{ key, NONE };
+                used++;
+            }
+            head = &table[i].head;
+        }
+        next[id] = *head;
+        prev[id] = NONE;
+        if (*head != NONE) prev[*head] = id;
+        *head = id;
+        cellOf[id] = key;
+    }
+
+    void unlink(int id) {
+        std::uint64_t key = cellOf[id];
+        if (prev[id] != NONE) {
+            next[prev[id]] = next[id];
+        } else if (isDense()) {
+            dense[key] = next[id];
+            if (next[id] == NONE) used--;
+        } else {
+            std::size_t i = find(key);
+            table[i].head = next[id];
+            if (next[id] == NONE) {
+                eraseSlot(i);
+                used--;
+            }
+        }
+        if (next[id] != NONE) prev[next[id]] = prev[id];
+        cellOf[id] = EMPTY_KEY;
+    }
+
+public:
+    OccupancyGrid() : rows(0), cols(0), mask(0), used(0) { grow(); }
+
+    // Drop everything and index a numRows x numCols board
+    void reset(int numRows, int numCols) {
+        rows = numRows;
+        cols = numCols;
+        used = 0;
+        if (wantsDense(0)) {
+            dense.assign(static_cast<std::size_t>(cellCount()), NONE);
+            table.clear();
+            table.shrink_to_fit();
+        } else {
+            dense.clear();
+            dense.shrink_to_fit();
+            table.clear();
+            grow();
+        }
+        next.clear();
+        prev.clear();
+        cellOf.clear();
+    }
+
+    void insert(int id, int x, int y) {
+        if (static_cast<std::size_t>(id) >= cellOf.size()) {
+            next.resize(id + 1, NONE);
+            prev.resize(id + 1, NONE);
+            cellOf.resize(id + 1, EMPTY_KEY);
+            if (!isDense() && wantsDense(cellOf.size())) makeDense();
+        }
+        if (cellOf[id] != EMPTY_KEY) unlink(id);
+        link(id, static_cast<std::uint64_t>(x) * cols + y);
+    }
+
+    void erase(int id) {
+        if (static_cast<std::size_t>(id) < cellOf.size() && cellOf[id] != EMPTY_KEY) unlink(id);
+    }
+
+    // Move an already indexed entity; a no-op when it stays on the same cell
+    void relocate(int id, int x, int y) {
+        std::uint64_t key = static_cast<std::uint64_t>(x) * cols + y;
+        if (cellOf[id] == key) return;
+        unlink(id);
+        link(id, key);
+    }
+
+    // First entity on (x, y), or -1. Walk the rest with nextAt().
+    int firstAt(int x, int y) const {
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(rows) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(cols)) return NONE;
+        return headOf(static_cast<std::uint64_t>(x) * cols + y);
+    }
+    int nextAt(int id) const { return next[id]; }
+
+    bool occupied(int x, int y) const { return firstAt(x, y) != NONE; }
+
+    // Cell-index forms (x * cols + y), for callers tracking cells rather than coordinates
+    std::uint64_t cellKeyOf(int id) const { return cellOf[id]; }
+    bool occupiedCell(std::uint64_t key) const { return headOf(key) != NONE; }
+
+    int countAt(int x, int y) const {
+        int n = 0;
+        for (int id = firstAt(x, y); id != NONE; id = next[id]) n++;
+        return n;
+    }
+
+    // Any entity within Chebyshev distance r of (x, y)? Cost is (2r+1)^2 lookups,
+    // independent of how many entities exist. Returns the id found, or -1.
+    int findWithin(int x, int y, int r) const {
+        if (used == 0) return NONE;
+        for (int i = x - r; i <= x + r; i++) {
+            for (int j = y - r; j <= y + r; j++) {
+                int id = firstAt(i, j);
+                if (id != NONE) return id;
+            }
+        }
+        return NONE;
+    }
+    bool anyWithin(int x, int y, int r) const { return findWithin(x, y, r) != NONE; }
+
+    std::size_t occupiedCells() const { return used; }
+    std::size_t memoryBytes() const {
+        return dense.capacity() * sizeof(int) + table.capacity() * sizeof(Slot) +
+               (next.capacity() + prev.capacity()) * sizeof(int) + cellOf.capacity() * sizeof(std::uint64_t);
+    }
+};
+
+#endif // OCCUPANCY_GRID_H
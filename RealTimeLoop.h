@@ -0,0 +1,295 @@
+// RealTimeLoop.h
+#ifndef REAL_TIME_LOOP_H // Start of include guard
+#define REAL_TIME_LOOP_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MazeRenderer.h" // FrameRenderer the render thread presents through
+#include "Instrumentation.h" // Display stage timer
+
+// Real-time play. Instead of one loop blocked on the keyboard, three threads:
+//   input thread  - whoever calls pushInput() (the console game's main thread, sitting in
+//                   GETCH). Keys travel through a lock-free single-producer/single-consumer
+//                   queue, so the keyboard never waits on the game.
+//   sim thread    - fixed timestep: every 1/tickHz seconds it drains the queue, applies the
+//                   keys and, every tickHz/enemyHz ticks, moves the enemies.
+//   render thread - at renderHz, draws the visible window into the renderer's back frame
+//                   under the state lock (microseconds) and presents it outside the lock.
+// A slow terminal therefore drops frames instead of delaying ticks, and enemies move on
+// their own clock whether or not a key is pressed.
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Head and tail live on separate cache lines, each next to the owning side's cached copy of
+// the other index, so a push or pop normally touches no line the other thread is writing.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+private:
+    alignas(64) std::atomic<std::size_t> tail; // Next slot to write (producer)
+    std::size_t cachedHead;                    // Producer's last look at 'head'
+    alignas(64) std::atomic<std::size_t> head; // Next slot to read (consumer)
+    std::size_t cachedTail;                    // Consumer's last look at 'tail'
+    alignas(64) T slots[Capacity];
+
+public:
+    SpscQueue() : tail(0), cachedHead(0), head(0), cachedTail(0), slots() {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only. False if the queue is full (the item is not queued).
+    bool tryPush(const T& item) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) return false;
+        }
+        slots[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release); // Publishes the slot
+        return true;
+    }
+
+    // Consumer only. False if the queue is empty.
+    bool tryPop(T& item) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        item = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release); // Hands the slot back to the producer
+        return true;
+    }
+};
+
+// Timing samples in milliseconds, summarised after a run. Count, mean and max cover every
+// sample; percentiles use the first MAX_SAMPLES (about 4.6 hours of 60 Hz ticks).
+class TimingStats {
+private:
+    static constexpr std::size_t MAX_SAMPLES = 1 << 20;
+    std::vector<double> samples;
+    std::uint64_t total;
+    double sum, largest;
+
+public:
+    TimingStats() : total(0), sum(0), largest(0) {}
+
+    void add(double ms) {
+        if (samples.size() < MAX_SAMPLES) samples.push_back(ms);
+        total++;
+        sum += ms;
+        if (ms > largest) largest = ms;
+    }
+
+    std::uint64_t count() const { return total; }
+    double mean() const { return total ? sum / static_cast<double>(total) : 0.0; }
+    double max() const { return largest; }
+
+    // p in [0, 1], e.g. 0.99
+    double percentile(double p) const {
+        if (samples.empty()) return 0.0;
+        std::vector<double> sorted(samples);
+        const std::size_t k = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+        return sorted[k];
+    }
+};
+
+class RealTimeLoop {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<bool(char)> KeyHandler;            // Sim thread, one call per key; false ends the game
+    typedef std::function<bool()> EnemyHandler;              // Sim thread, one call per enemy step; false ends the game
+    typedef std::function<void(FrameRenderer&)> DrawHandler; // Render thread, state lock held: fill the back frame
+
+    struct Stats {
+        std::uint64_t ticks;        // Sim ticks run
+        std::uint64_t lateTicks;    // Ticks that started a full period or more behind schedule
+        std::uint64_t skippedTicks; // Ticks abandoned after falling too far behind
+        std::uint64_t enemySteps;
+        std::uint64_t keys;         // Keys applied by the sim thread
+        std::uint64_t keysDropped;  // Keys lost to a full queue
+        std::uint64_t frames;       // Frames presented
+        std::uint64_t framesDropped; // Render deadlines missed because the previous frame ran over
+        TimingStats tickJitter;     // How late each tick started against its schedule
+        TimingStats tickWork;       // Time spent inside each tick
+        TimingStats frameWork;      // Draw + present time per frame
+        TimingStats inputLatency;   // Key pressed -> the first frame showing its effect presented
+    };
+
+private:
+    struct TimedKey {
+        char key;
+        Clock::time_point pressed;
+    };
+
+    static constexpr int MAX_TICKS_BEHIND = 5; // Catch up at most this many ticks; beyond that, skip ahead
+
+    Clock::duration tickPeriod, framePeriod;
+    int ticksPerEnemyStep;
+    SpscQueue<TimedKey, 256> input;
+    std::atomic<std::uint64_t> keysDropped;
+
+    KeyHandler onKey;
+    EnemyHandler onEnemyStep;
+    DrawHandler onDraw;
+    FrameRenderer* renderer;
+    FrameRenderer::Sink sink;
+
+    std::mutex stateLock;                     // Held by a tick and by a draw, never across I/O
+    std::uint64_t version;                    // Bumped whenever a tick changed something (under stateLock)
+    std::vector<Clock::time_point> unrendered; // Keys applied since the last draw (under stateLock)
+    std::atomic<bool> over;                   // A handler ended the game
+    std::atomic<bool> stopping;
+    std::thread simThread, renderThread;
+    Stats stats;
+
+    static double millis(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+    void simLoop() {
+        Clock::time_point next = Clock::now();
+        std::uint64_t tick = 0;
+        while (!stopping.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_until(next);
+            const Clock::time_point start = Clock::now();
+            stats.tickJitter.add(millis(start - next));
+            if (start - next >= tickPeriod) stats.lateTicks++;
+
+            bool running = true;
+            {
+                std::lock_guard<std::mutex> guard(stateLock);
+                bool changed = false;
+                TimedKey key;
+                while (running && input.tryPop(key)) {
+                    running = onKey(key.key);
+                    unrendered.push_back(key.pressed);
+                    stats.keys++;
+                    changed = true;
+                }
+                if (running && ++tick % ticksPerEnemyStep == 0) {
+                    running = onEnemyStep();
+                    stats.enemySteps++;
+                    changed = true;
+                }
+                if (changed) version++;
+            }
+            stats.ticks++;
+            stats.tickWork.add(millis(Clock::now() - start));
+            if (!running) {
+                over.store(true);
+                break;
+            }
+
+            next += tickPeriod;
+            const Clock::time_point now = Clock::now();
+            if (now - next > MAX_TICKS_BEHIND * tickPeriod) {
+                // Hopelessly behind (the machine was suspended, say): drop the backlog
+                // instead of fast-forwarding through it
+                const std::uint64_t behind = static_cast<std::uint64_t>((now - next) / tickPeriod);
+                stats.skippedTicks += behind;
+                next += behind * tickPeriod;
+            }
+        }
+    }
+
+    void renderLoop() {
+        Clock::time_point next = Clock::now();
+        std::uint64_t drawn = ~std::uint64_t(0);
+        std::vector<Clock::time_point> shown;
+        for (;;) {
+            const bool last = over.load() || stopping.load(std::memory_order_relaxed); // One final frame after the game ends
+            std::this_thread::sleep_until(next);
+            bool draw;
+            {
+                std::lock_guard<std::mutex> guard(stateLock);
+                draw = version != drawn;
+            }
+            if (draw) {
+                const Clock::time_point start = Clock::now();
+                {
+                    MAZE_TIMED_SCOPE(STAGE_DISPLAY);
+                    {
+                        std::lock_guard<std::mutex> guard(stateLock);
+                        onDraw(*renderer);
+                        drawn = version;
+                        shown.swap(unrendered);
+                    }
+                    renderer->present(sink);
+                }
+                const Clock::time_point presented = Clock::now();
+                for (const Clock::time_point& pressed : shown) stats.inputLatency.add(millis(presented - pressed));
+                shown.clear();
+                stats.frames++;
+                stats.frameWork.add(millis(presented - start));
+            }
+            if (last) break;
+
+            next += framePeriod;
+            const Clock::time_point now = Clock::now();
+            if (now > next) {
+                // Deadlines that passed while this frame was being drawn are lost, not queued up
+                const std::uint64_t missed = static_cast<std::uint64_t>((now - next) / framePeriod) + 1;
+                stats.framesDropped += missed;
+                next += missed * framePeriod;
+            }
+        }
+    }
+
+public:
+    // Enemies step enemyHz times a second on a tickHz sim clock (rounded to whole ticks);
+    // frames are presented at up to renderHz.
+    explicit RealTimeLoop(double tickHz = 60.0, double enemyHz = 4.0, double renderHz = 60.0)
+        : tickPeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tickHz))),
+          framePeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / renderHz))),
+          ticksPerEnemyStep(std::max(1, static_cast<int>(tickHz / enemyHz + 0.5))),
+          keysDropped(0), renderer(nullptr), version(0), over(false), stopping(false), stats() {}
+
+    ~RealTimeLoop() { stop(); }
+    RealTimeLoop(const RealTimeLoop&) = delete;
+    RealTimeLoop& operator=(const RealTimeLoop&) = delete;
+
+    // Start the sim and render threads. The handlers run on those threads, serialised by the
+    // loop's state lock, so they may share the game without locking of their own.
+    void start(KeyHandler keyHandler, EnemyHandler enemyHandler, DrawHandler drawHandler,
+               FrameRenderer& frameRenderer, FrameRenderer::Sink frameSink) {
+        onKey = keyHandler;
+        onEnemyStep = enemyHandler;
+        onDraw = drawHandler;
+        renderer = &frameRenderer;
+        sink = frameSink;
+        version = 1; // Draw the first frame straight away
+        simThread = std::thread(&RealTimeLoop::simLoop, this);
+        renderThread = std::thread(&RealTimeLoop::renderLoop, this);
+    }
+
+    // Input thread only. Never blocks; false if the queue was full and the key was dropped.
+    bool pushInput(char key) {
+        if (input.tryPush(TimedKey{ key, Clock::now() })) return true;
+        keysDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // True once a handler has ended the game (the final frame follows shortly)
+    bool finished() const { return over.load(); }
+
+    // Stop both threads (idempotent). Stats are complete once this returns.
+    void stop() {
+        stopping.store(true);
+        if (simThread.joinable()) simThread.join();
+        if (renderThread.joinable()) renderThread.join();
+        stats.keysDropped = keysDropped.load();
+    }
+
+    int getTicksPerEnemyStep() const { return ticksPerEnemyStep; }
+    const Stats& getStats() const { return stats; }
+};
+
+#endif // REAL_TIME_LOOP_H
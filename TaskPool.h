@@ -0,0 +1,145 @@
+// TaskPool.h
+#ifndef TASK_POOL_H // Start of include guard
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool for data-parallel loops.
+// parallelFor() cuts [0, count) into chunks and deals them out in contiguous blocks, one
+// deque per worker. A worker takes chunks from the FRONT of its own deque (good locality:
+// neighbouring chunks touch neighbouring memory) and, once empty, steals from the BACK of
+// another worker's deque. Chunks are uneven in practice (enemies stuck behind walls finish
+// early, blocked ones retry), so stealing keeps every core busy until the loop is done.
+// The calling thread works too, so TaskPool(1) runs everything inline with no threads.
+class TaskPool {
+public:
+    typedef std::function<void(std::size_t, std::size_t)> RangeFn; // Called as fn(begin, end)
+
+private:
+    struct Chunk {
+        std::size_t begin, end;
+        const RangeFn* fn;
+    };
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Chunk> chunks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues; // queues[0] belongs to the calling thread
+    std::vector<std::thread> workers;
+    std::mutex stateLock;
+    std::condition_variable wake, finished;
+    std::uint64_t generation;            // Bumped for every parallelFor() call
+    std::atomic<std::size_t> remaining;  // Chunks not yet completed in the current call
+    bool stopping;
+
+    bool popOwn(std::size_t w, Chunk& out) {
+        WorkQueue& q = *queues[w];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.chunks.empty()) return false;
+        out = q.chunks.front();
+        q.chunks.pop_front();
+        return true;
+    }
+
+    bool steal(std::size_t thief, Chunk& out) {
+        for (std::size_t k = 1; k < queues.size(); k++) {
+            WorkQueue& q = *queues[(thief + k) % queues.size()];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (!q.chunks.empty()) {
+                out = q.chunks.back();
+                q.chunks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Run chunks until there is nothing left to take anywhere
+    void drain(std::size_t w) {
+        Chunk c;
+        while (popOwn(w, c) || steal(w, c)) {
+            (*c.fn)(c.begin, c.end);
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> guard(stateLock);
+                finished.notify_all();
+            }
+        }
+    }
+
+    void workerLoop(std::size_t w) {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(stateLock);
+                wake.wait(guard, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            drain(w);
+        }
+    }
+
+public:
+    // 'threads' includes the calling thread; 0 means one per hardware thread
+    explicit TaskPool(unsigned threads = 0) : generation(0), remaining(0), stopping(false) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; i++) queues.emplace_back(new WorkQueue());
+        for (unsigned i = 1; i < threads; i++) workers.emplace_back(&TaskPool::workerLoop, this, i);
+    }
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> guard(stateLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Call fn(begin, end) over [0, count) in chunks of 'chunkSize'; returns when all are done
+    void parallelFor(std::size_t count, std::size_t chunkSize, const RangeFn& fn) {
+        if (count == 0) return;
+        if (chunkSize == 0) chunkSize = 1;
+        const std::size_t numChunks = (count + chunkSize - 1) / chunkSize;
+        if (queues.size() == 1 || numChunks == 1) {
+            fn(0, count);
+            return;
+        }
+        remaining.store(numChunks);
+        // Deal contiguous blocks of chunks to each worker's deque
+        const std::size_t perQueue = (numChunks + queues.size() - 1) / queues.size();
+        for (std::size_t c = 0; c < numChunks; c++) {
+            std::size_t begin = c * chunkSize;
+            std::size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+            WorkQueue& q = *queues[c / perQueue];
+            std::lock_guard<std::mutex> guard(q.lock);
+            q.chunks.push_back(Chunk{ begin, end, &fn });
+        }
+        {
+            std::lock_guard<std::mutex> guard(stateLock);
+            generation++;
+        }
+        wake.notify_all();
+        drain(0);
+        std::unique_lock<std::mutex> guard(stateLock);
+        finished.wait(guard, [&] { return remaining.load() == 0; });
+    }
+};
+
+#endif // TASK_POOL_H
@@ -0,0 +1,138 @@
+// UndoHistory.h
+#ifndef UNDO_HISTORY_H // Start of include guard
+#define UNDO_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "MazeSave.h" // SaveSnapshot, for steps that change level
+
+// Both sides of a step that finished a level: the board changes wholesale there, so those
+// steps keep whole snapshots (O(items + enemies) each, wall planes shared copy-on-write)
+struct LevelJump {
+    SaveSnapshot before; // At the exit, after the enemies' turn, before the next level is set up
+    SaveSnapshot after;  // The new level, as the step left it
+};
+
+// One change to the game (a player move with the enemies' turn, or an enemy tick on its
+// own), stored as a delta that can be applied in either direction. Everything else the
+// step touches follows from these fields.
+struct UndoRecord {
+    std::int32_t fromX, fromY, toX, toY; // Player before / after (equal for an enemy tick)
+    std::int32_t itemX, itemY;           // Item the move collected (-1, -1 = none)
+    std::int32_t scoreBefore, scoreAfter; // Score before the step / after it (level par bonus included)
+    std::uint8_t flags;                  // UNDO_* below
+    std::vector<std::uint8_t> enemyMoves; // One nibble per enemy (UndoHistory::encodeEnemyMoves); capacity reused
+    std::unique_ptr<LevelJump> levelJump; // Set when the step finished a level
+
+    UndoRecord()
+        : fromX(0), fromY(0), toX(0), toY(0), itemX(-1), itemY(-1), scoreBefore(0), scoreAfter(0), flags(0) {}
+};
+
+const std::uint8_t UNDO_PLAYER_MOVED = 1 << 0; // 'moves' went up by one
+const std::uint8_t UNDO_TICKED       = 1 << 1; // Enemies took a turn ('tick' went up by one)
+const std::uint8_t UNDO_CAUGHT       = 1 << 2; // The step ended the game
+
+// Bounded undo / redo history: a ring of the last 'capacity' records plus a cursor.
+// Records behind the cursor are applied (undo walks back over them), records in front of it
+// were undone (redo walks forward); recording a new change drops everything in front.
+// Undo and redo each cost one record, whatever the board size, so thousands of steps stay
+// cheap. Ring slots are reused in place, so once the ring has filled, recording allocates
+// nothing unless a step moves more enemies than the slot it lands in has ever held.
+class UndoHistory {
+private:
+    std::vector<UndoRecord> ring;
+    std::size_t first;   // Slot of the oldest record
+    std::size_t count;   // Records held
+    std::size_t applied; // Records behind the cursor (<= count)
+
+    UndoRecord& slot(std::size_t i) { return ring[(first + i) % ring.size()]; }
+
+public:
+    // Nibble meaning "stayed put"; any other value is (dx + 1) * 3 + (dy + 1)
+    static constexpr std::uint8_t ENEMY_STAYED = 4;
+
+    explicit UndoHistory(std::size_t capacity = 0) : first(0), count(0), applied(0) { setCapacity(capacity); }
+
+    // Keep up to 'capacity' records (0 = keep none); drops everything recorded so far
+    void setCapacity(std::size_t capacity) {
+        ring.clear();
+        ring.resize(capacity);
+        clear();
+    }
+    std::size_t getCapacity() const { return ring.size(); }
+
+    // Forget every record (a load or new game broke the chain); the slots are kept
+    void clear() {
+        for (UndoRecord& r : ring) r.levelJump.reset();
+        first = count = applied = 0;
+    }
+
+    bool canUndo() const { return applied > 0; }
+    bool canRedo() const { return applied < count; }
+    std::size_t undoCount() const { return applied; }
+    std::size_t redoCount() const { return count - applied; }
+
+    // Slot for a new record at the cursor: drops the redo records and, when full, the oldest
+    // one. Fields are the caller's to fill; enemyMoves keeps its capacity.
+    UndoRecord& push() {
+        count = applied;
+        if (count == ring.size()) {
+            first = (first + 1) % ring.size();
+            count--;
+        }
+        UndoRecord& r = slot(count);
+        r.levelJump.reset();
+        count++;
+        applied = count;
+        return r;
+    }
+
+    // The record undo() / redo() would apply, moving the cursor past it; null if there is none
+    const UndoRecord* stepBack() { return applied ? &slot(--applied) : nullptr; }
+    const UndoRecord* stepForward() { return applied < count ? &slot(applied++) : nullptr; }
+
+    // Bytes held by the records, level snapshots included (shared wall planes counted in full)
+    std::size_t memoryBytes() const {
+        std::size_t bytes = ring.capacity() * sizeof(UndoRecord);
+        for (const UndoRecord& r : ring) {
+            bytes += r.enemyMoves.capacity();
+            if (r.levelJump) {
+                const SaveSnapshot* sides[2] = { &r.levelJump->before, &r.levelJump->after };
+                bytes += sizeof(LevelJump);
+                for (const SaveSnapshot* s : sides) {
+                    bytes += (s->items.capacity() + s->enemyXs.capacity() + s->enemyYs.capacity()) * sizeof(std::int32_t) +
+                             static_cast<std::size_t>(s->header.rows) * ((static_cast<std::size_t>(s->header.cols) + 63) / 64) *
+                                 sizeof(std::uint64_t);
+                }
+            }
+        }
+        return bytes;
+    }
+
+    // Pack each enemy's move (old -> new position, one square at most) into 4 bits, two
+    // enemies per byte. 'out' is resized, not reallocated, when it is big enough.
+    static void encodeEnemyMoves(const std::int32_t* oldXs, const std::int32_t* oldYs, const std::int32_t* newXs,
+                                 const std::int32_t* newYs, std::size_t n, std::vector<std::uint8_t>& out) {
+        out.resize((n + 1) / 2);
+        for (std::size_t i = 0; i < n; i += 2) {
+            std::uint8_t byte = static_cast<std::uint8_t>((newXs[i] - oldXs[i] + 1) * 3 + (newYs[i] - oldYs[i] + 1));
+            if (i + 1 < n)
+                byte |= static_cast<std::uint8_t>(((newXs[i + 1] - oldXs[i + 1] + 1) * 3 + (newYs[i + 1] - oldYs[i + 1] + 1)) << 4);
+            else
+                byte |= ENEMY_STAYED << 4;
+            out[i / 2] = byte;
+        }
+    }
+
+    // Nibble of enemy i, and the move it stands for
+    static std::uint8_t enemyMove(const std::vector<std::uint8_t>& moves, std::size_t i) {
+        return (moves[i / 2] >> ((i & 1) * 4)) & 0xF;
+    }
+    static int moveDx(std::uint8_t code) { return code / 3 - 1; }
+    static int moveDy(std::uint8_t code) { return code % 3 - 1; }
+};
+
+#endif // UNDO_HISTORY_H
@@ -0,0 +1,220 @@
+// VecEnv.h
+#ifndef VEC_ENV_H // Start of include guard
+#define VEC_ENV_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "MazeSim.h"  // Headless game core
+#include "TaskPool.h" // Worker threads for stepping environments in parallel
+
+// Batched environments for bots and training: N independent games stepped by one call.
+//
+//   VecEnv envs(256, 11, seed, threads);
+//   envs.reset(obs);                                  // obs: envs.observationWords() * 256 words
+//   envs.step(actions, obs, rewards, dones);          // one action per game, all games advance
+//
+// The MazeSim objects sit side by side in one array, with the per-game episode counters in
+// plain arrays next to it, and every game's board (wall plane, then cells) sits in one slab,
+// game after game. The free-cell and occupancy indexes, enemy store and flow field are still
+// each game's own heap buffers. Nothing allocates once the buffers have grown: a step on the
+// same level doesn't, and neither does a finished level or a restart (newGame()), which
+// rebuilds the board in its slab and reuses the generator and solver scratch.
+// With one thread this runs at about the speed of a loop over separately allocated games,
+// which reuse their buffers the same way (MazeBench vecenv: between 2% behind and 15% ahead
+// from run to run); what the batching buys is the thread pool, reproducible per-episode seeds
+// and one observation buffer.
+//
+// Each game's observation is written straight into the caller's buffer as OBS_PLANES
+// bit-planes laid out like the wall plane (rows x getWordsPerRow() words, bit y of word
+// y / 64 is column y): walls, items, enemies, player. Game i's planes start at
+// observations + i * observationWords().
+//
+// A game that ends is restarted inside the same step(): the returned reward and done code are
+// the ones that ended it, the observation is already the first one of the next episode. Every
+// episode's seed comes from (seed, game, episode number), so a run is reproducible and gives
+// identical results on any number of threads.
+//
+// With several threads, games are dealt out in chunks through a TaskPool; a game is only ever
+// touched by one thread per step and writes only its own slots of the output arrays.
+
+// dones[i] after a step
+enum EnvDone : unsigned char {
+    ENV_RUNNING   = 0,
+    ENV_CAUGHT    = 1, // An enemy caught the player: the game is over
+    ENV_TRUNCATED = 2  // Hit the episode step limit (setMaxEpisodeSteps) while still alive
+};
+
+// Observation planes, in buffer order
+enum ObsPlane {
+    OBS_WALLS,
+    OBS_ITEMS,
+    OBS_ENEMIES,
+    OBS_PLAYER,
+    OBS_PLANES
+};
+
+class VecEnv {
+private:
+    MazeSim* games;            // count games, constructed in place in one allocation
+    std::size_t count;
+    std::uint64_t seed;
+    std::uint32_t maxEpisodeSteps;          // 0 = episodes only end when the player is caught
+    std::vector<std::uint32_t> episodeSteps; // Steps taken in each game's current episode
+    std::vector<std::uint32_t> episodeIndex; // Episodes each game has started (seeds the next one)
+    std::uint64_t totalSteps;
+    std::uint64_t totalEpisodes;            // Episodes finished (caught or truncated)
+    std::unique_ptr<TaskPool> pool;         // null = step on the calling thread
+    std::size_t planeWordCount;             // rows * wordsPerRow
+    std::vector<std::uint64_t> boards;      // Every game's wall plane and cells, game after game
+
+    std::uint64_t episodeSeed(std::size_t game, std::uint32_t episode) const {
+        return mix64(mix64(seed ^ (static_cast<std::uint64_t>(game) * 0x9E3779B97F4A7C15ull)) + episode);
+    }
+
+    static void setBit(std::uint64_t* plane, std::size_t wordsPerRow, int x, int y) {
+        plane[x * wordsPerRow + (y >> 6)] |= std::uint64_t(1) << (y & 63);
+    }
+
+    // Step one game and fill in its slots of the output arrays. Returns 1 if it finished.
+    std::uint64_t stepGame(std::size_t i, SimAction action, std::uint64_t* observations, std::int32_t* rewards,
+                           unsigned char* dones, unsigned* events) {
+        MazeSim& sim = games[i];
+        const int scoreBefore = sim.getScore();
+        const unsigned e = sim.step(action);
+        const std::int32_t reward = sim.getScore() - scoreBefore;
+        unsigned char done = ENV_RUNNING;
+        if (sim.isGameOver()) done = ENV_CAUGHT;
+        else if (++episodeSteps[i] >= maxEpisodeSteps && maxEpisodeSteps) done = ENV_TRUNCATED;
+        if (done != ENV_RUNNING) startEpisode(i);
+        if (rewards) rewards[i] = reward;
+        if (dones) dones[i] = done;
+        if (events) events[i] = e;
+        if (observations) writeObservation(sim, observations + i * observationWords());
+        return done != ENV_RUNNING;
+    }
+
+    void startEpisode(std::size_t i) {
+        episodeSteps[i] = 0;
+        games[i].newGame(episodeSeed(i, ++episodeIndex[i]));
+    }
+
+    // Run fn(begin, end) over every game, on the pool when there is one
+    void forEachGame(const TaskPool::RangeFn& fn) {
+        if (!pool) {
+            fn(0, count);
+            return;
+        }
+        // A few chunks per thread so stealing can even out games that hit a level reset
+        pool->parallelFor(count, count / (pool->size() * 4) + 1, fn);
+    }
+
+public:
+    // 'numGames' games on boardSize x boardSize boards. 'threads' as for TaskPool, except that
+    // 1 (the default) steps everything on the calling thread.
+    VecEnv(std::size_t numGames, int boardSize, std::uint64_t baseSeed, unsigned threads = 1)
+        : games(nullptr), count(numGames), seed(baseSeed), maxEpisodeSteps(0),
+          episodeSteps(numGames, 0), episodeIndex(numGames, 0), totalSteps(0), totalEpisodes(0), planeWordCount(0) {
+        games = static_cast<MazeSim*>(::operator new(count * sizeof(MazeSim), std::align_val_t(alignof(MazeSim))));
+        for (std::size_t i = 0; i < count; i++) new (&games[i]) MazeSim(boardSize, episodeSeed(i, 0));
+        if (count) planeWordCount = static_cast<std::size_t>(games[0].getGrid().getRows()) * games[0].getGrid().getWordsPerRow();
+        // One slab for all boards: game i's wall plane, then its cells rounded up to whole words
+        const std::size_t cells = count ? games[0].getGrid().cellCount() : 0;
+        const std::size_t stride = planeWordCount + (cells + 7) / 8;
+        boards.assign(count * stride, 0);
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint64_t* board = &boards[i * stride];
+            games[i].useBoardStorage(reinterpret_cast<char*>(board + planeWordCount), cells, board, planeWordCount);
+        }
+        setThreadCount(threads);
+    }
+
+    ~VecEnv() {
+        for (std::size_t i = 0; i < count; i++) games[i].~MazeSim();
+        ::operator delete(games, std::align_val_t(alignof(MazeSim)));
+    }
+
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    void setThreadCount(unsigned threads) {
+#if defined(MAZE_INSTRUMENT) && MAZE_INSTRUMENT
+        threads = 1; // Stage histograms are recorded without locks (see Instrumentation.h)
+#endif
+        if (threads == 1) pool.reset();
+        else pool.reset(new TaskPool(threads));
+    }
+    unsigned getThreadCount() const { return pool ? pool->size() : 1; }
+
+    // Cut episodes off after 'steps' steps (ENV_TRUNCATED); 0 = no limit. Takes effect from
+    // the next step, counting the steps already taken in the current episodes.
+    void setMaxEpisodeSteps(std::uint32_t steps) { maxEpisodeSteps = steps; }
+    std::uint32_t getMaxEpisodeSteps() const { return maxEpisodeSteps; }
+
+    std::size_t size() const { return count; }
+    std::size_t planeWords() const { return planeWordCount; }
+    std::size_t observationWords() const { return OBS_PLANES * planeWordCount; } // Per game
+    std::uint64_t getTotalSteps() const { return totalSteps; }
+    std::uint64_t getTotalEpisodes() const { return totalEpisodes; }
+
+    // Direct access, e.g. to switch enemy behavior before a run. Settings survive the
+    // automatic restarts; don't change the board size.
+    MazeSim& game(std::size_t i) { return games[i]; }
+    const MazeSim& game(std::size_t i) const { return games[i]; }
+
+    // Write 'sim' as OBS_PLANES bit-planes to 'out' (OBS_PLANES * rows * wordsPerRow words)
+    static void writeObservation(const MazeSim& sim, std::uint64_t* out) {
+        const MazeGrid& grid = sim.getGrid();
+        const std::size_t wordsPerRow = grid.getWordsPerRow();
+        const std::size_t plane = static_cast<std::size_t>(grid.getRows()) * wordsPerRow;
+        // The wall plane is one contiguous block with exactly this layout
+        std::memcpy(out + OBS_WALLS * plane, grid.wallRow(0), plane * sizeof(std::uint64_t));
+        std::memset(out + OBS_ITEMS * plane, 0, (OBS_PLANES - OBS_ITEMS) * plane * sizeof(std::uint64_t));
+        const std::vector<std::int32_t>& items = sim.getItemSquares();
+        for (std::size_t k = 0; k < items.size(); k += 2) setBit(out + OBS_ITEMS * plane, wordsPerRow, items[k], items[k + 1]);
+        const EnemyStore& enemies = sim.getEnemies();
+        const std::int32_t* xs = enemies.xData();
+        const std::int32_t* ys = enemies.yData();
+        for (std::size_t e = 0; e < enemies.size(); e++) setBit(out + OBS_ENEMIES * plane, wordsPerRow, xs[e], ys[e]);
+        setBit(out + OBS_PLAYER * plane, wordsPerRow, sim.getPlayerX(), sim.getPlayerY());
+    }
+
+    // Start a new episode in every game and write the first observations (if non-null)
+    void reset(std::uint64_t* observations) {
+        forEachGame([&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                startEpisode(i);
+                if (observations) writeObservation(games[i], observations + i * observationWords());
+            }
+        });
+    }
+
+    // Current observations without stepping
+    void observe(std::uint64_t* observations) const {
+        for (std::size_t i = 0; i < count; i++) writeObservation(games[i], observations + i * observationWords());
+    }
+
+    // Advance every game by actions[i]. Any output pointer may be null:
+    //   observations - size() * observationWords() words, the state after the step
+    //   rewards      - score gained by the step (items, level par bonus)
+    //   dones        - EnvDone; a finished game has already been restarted
+    //   events       - the SimEvent mask MazeSim::step returned
+    void step(const SimAction* actions, std::uint64_t* observations, std::int32_t* rewards = nullptr,
+              unsigned char* dones = nullptr, unsigned* events = nullptr) {
+        std::atomic<std::uint64_t> finished(0);
+        forEachGame([&](std::size_t begin, std::size_t end) {
+            std::uint64_t ended = 0;
+            for (std::size_t i = begin; i < end; i++) ended += stepGame(i, actions[i], observations, rewards, dones, events);
+            finished.fetch_add(ended, std::memory_order_relaxed);
+        });
+        totalSteps += count;
+        totalEpisodes += finished.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // VEC_ENV_H
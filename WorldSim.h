@@ -0,0 +1,324 @@
+// WorldSim.h
+#ifndef WORLD_SIM_H // Start of include guard
+#define WORLD_SIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChunkedWorld.h" // Tiled, memory-mapped maze
+#include "MazeSim.h"      // SimAction / SimEvent, Player
+#include "MazeRenderer.h" // FrameRenderer + the game's colors for drawWorldFrame()
+
+// The game on a ChunkedWorld: one endless level with items to collect and enemies to avoid,
+// on a maze far larger than memory (POSIX only, like ChunkedWorld.h). Same actions, events
+// and turn-based rules as MazeSim, but nothing here is O(world): no grid copy, no free-cell
+// index, no flow field. Every square the rules look at is fetched through the world's tile
+// cache.
+//
+// Enemies are simulated lazily. The ACTIVE WINDOW is the player's tile and the tiles within
+// 'activeRadius' of it; only enemies inside it move every turn. A tile's enemies are created
+// the first time it enters the window (deterministically, from the seed and the tile), so an
+// unvisited world costs nothing. An enemy outside the window is dormant and keeps the tick
+// of its last move; when its tile comes back into the window it catches up on the turns it
+// slept, at one move per DORMANT_PERIOD of them and at most MAX_CATCH_UP moves. Far away
+// enemies therefore cost nothing per turn, and their tiles are never paged in for them.
+// Enemies are bucketed by tile, so finding the ones in the window is a few map lookups.
+
+const int DORMANT_PERIOD = 8; // A dormant enemy makes up one move per this many turns asleep
+const int MAX_CATCH_UP = 16;  // Moves an enemy makes up at most when it wakes
+
+class WorldSim {
+private:
+    ChunkedWorld world;
+    Player player;
+    int score;
+    int moves;
+    int collected;
+    bool gameOver;
+    std::uint64_t seed;
+    std::uint32_t seedKey; // Digest of 'seed' for counterRandom32
+    std::uint32_t tick;
+    int activeRadius;      // Window half-size, in tiles
+    int enemiesPerTile;
+
+    // Enemies, struct-of-arrays like EnemyStore; ids are indices
+    std::vector<std::int32_t> xs, ys;
+    std::vector<std::uint32_t> lastMove;   // Tick of each enemy's last move
+    std::vector<std::uint32_t> bucketSlot; // Index in its tile's bucket
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> tileEnemies; // Only tiles that have been active
+    std::vector<std::uint64_t> spawned;    // Bit per tile: enemies created
+    std::vector<std::uint32_t> windowTiles; // Tiles of the active window
+    std::vector<std::uint32_t> moving;      // Scratch: ids moving this turn
+    int windowTileX, windowTileY;           // Player tile the window was built around
+    std::uint64_t enemyMoves, catchUpMoves;
+
+    std::uint32_t tileCols() const { return static_cast<std::uint32_t>((world.getCols() + WORLD_TILE - 1) / WORLD_TILE); }
+    std::uint32_t tileOf(int x, int y) const {
+        return static_cast<std::uint32_t>(x / WORLD_TILE) * tileCols() + static_cast<std::uint32_t>(y / WORLD_TILE);
+    }
+
+    void bucketInsert(std::uint32_t id, std::uint32_t tile) {
+        std::vector<std::uint32_t>& bucket = tileEnemies[tile];
+        bucketSlot[id] = static_cast<std::uint32_t>(bucket.size());
+        bucket.push_back(id);
+    }
+
+    void bucketErase(std::uint32_t id, std::uint32_t tile) {
+        std::vector<std::uint32_t>& bucket = tileEnemies[tile];
+        const std::uint32_t slot = bucketSlot[id];
+        bucket[slot] = bucket.back(); // Swap-remove
+        bucketSlot[bucket[slot]] = slot;
+        bucket.pop_back();
+    }
+
+    // One random step for enemy 'id' on turn 'turn': the EnemyStore rule (up to 10 random
+    // directions of the 8, 3 bits each, first open one wins), walls read through the cache
+    void stepEnemy(std::uint32_t id, std::uint32_t turn) {
+        const std::uint32_t h = counterRandom32(seedKey, turn, id);
+        static const int DX[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+        static const int DY[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+        for (int a = 0; a < 10; a++) {
+            const int code = (h >> (3 * a)) & 7;
+            const int nx = xs[id] + DX[code], ny = ys[id] + DY[code];
+            if (world.isWall(nx, ny)) continue;
+            const std::uint32_t from = tileOf(xs[id], ys[id]), to = tileOf(nx, ny);
+            if (from != to) {
+                bucketErase(id, from);
+                bucketInsert(id, to);
+            }
+            xs[id] = nx;
+            ys[id] = ny;
+            return;
+        }
+    }
+
+    // First visit of a tile: its enemies on random open squares, none within 3 of the player
+    void spawnTile(std::uint32_t tile) {
+        spawned[tile / 64] |= std::uint64_t(1) << (tile % 64);
+        const int top = static_cast<int>(tile / tileCols()) * WORLD_TILE;
+        const int left = static_cast<int>(tile % tileCols()) * WORLD_TILE;
+        SplitMix64 rng(mix64(seed ^ (static_cast<std::uint64_t>(tile) * 0x9E3779B97F4A7C15ull)));
+        for (int e = 0; e < enemiesPerTile; e++) {
+            for (int attempt = 0; attempt < 32; attempt++) { // Roughly half the squares are open
+                const int x = top + static_cast<int>(rng.below(WORLD_TILE));
+                const int y = left + static_cast<int>(rng.below(WORLD_TILE));
+                const int dx = x - player.getX(), dy = y - player.getY();
+                if (world.isWall(x, y) || (dx >= -3 && dx <= 3 && dy >= -3 && dy <= 3)) continue;
+                const std::uint32_t id = static_cast<std::uint32_t>(xs.size());
+                xs.push_back(x);
+                ys.push_back(y);
+                lastMove.push_back(tick);
+                bucketSlot.push_back(0);
+                bucketInsert(id, tile);
+                break;
+            }
+        }
+    }
+
+    // Rebuild the window around the player's tile: create enemies of tiles seen for the first
+    // time, wake the dormant ones, and prefetch the tiles the window covers
+    void updateWindow(bool force) {
+        const int tx = player.getX() / WORLD_TILE, ty = player.getY() / WORLD_TILE;
+        if (!force && tx == windowTileX && ty == windowTileY) return;
+        windowTileX = tx;
+        windowTileY = ty;
+        world.prefetch(player.getX(), player.getY(), activeRadius);
+        windowTiles.clear();
+        const int tileRows = (world.getRows() + WORLD_TILE - 1) / WORLD_TILE;
+        for (int i = tx - activeRadius; i <= tx + activeRadius; i++) {
+            for (int j = ty - activeRadius; j <= ty + activeRadius; j++) {
+                if (i < 0 || j < 0 || i >= tileRows || j >= static_cast<int>(tileCols())) continue;
+                const std::uint32_t tile = static_cast<std::uint32_t>(i) * tileCols() + static_cast<std::uint32_t>(j);
+                windowTiles.push_back(tile);
+                if (!((spawned[tile / 64] >> (tile % 64)) & 1)) spawnTile(tile);
+            }
+        }
+        // Catch up whoever slept: ids gathered first, since a move can change buckets
+        moving.clear();
+        for (std::uint32_t tile : windowTiles) {
+            auto found = tileEnemies.find(tile);
+            if (found != tileEnemies.end()) moving.insert(moving.end(), found->second.begin(), found->second.end());
+        }
+        for (std::uint32_t id : moving) {
+            const std::uint32_t slept = tick - lastMove[id];
+            if (slept <= 1) continue;
+            std::uint32_t owed = slept / DORMANT_PERIOD;
+            if (owed > MAX_CATCH_UP) owed = MAX_CATCH_UP;
+            for (std::uint32_t k = 0; k < owed; k++) stepEnemy(id, lastMove[id] + (k + 1) * DORMANT_PERIOD);
+            catchUpMoves += owed;
+            lastMove[id] = tick;
+        }
+    }
+
+    bool enemyAt(int x, int y) const {
+        auto found = tileEnemies.find(tileOf(x, y));
+        if (found == tileEnemies.end()) return false;
+        for (std::uint32_t id : found->second) {
+            if (xs[id] == x && ys[id] == y) return true;
+        }
+        return false;
+    }
+
+    // Every enemy in the window moves once
+    void moveEnemies() {
+        tick++;
+        moving.clear();
+        for (std::uint32_t tile : windowTiles) {
+            auto found = tileEnemies.find(tile);
+            if (found != tileEnemies.end()) moving.insert(moving.end(), found->second.begin(), found->second.end());
+        }
+        for (std::uint32_t id : moving) {
+            stepEnemy(id, tick);
+            lastMove[id] = tick;
+            if (xs[id] == player.getX() && ys[id] == player.getY()) gameOver = true;
+        }
+        enemyMoves += moving.size();
+    }
+
+public:
+    WorldSim()
+        : player(1, 1), score(0), moves(0), collected(0), gameOver(false), seed(0), seedKey(0), tick(0),
+          activeRadius(1), enemiesPerTile(4), windowTileX(-1), windowTileY(-1), enemyMoves(0), catchUpMoves(0) {}
+
+    WorldSim(const WorldSim&) = delete;
+    WorldSim& operator=(const WorldSim&) = delete;
+
+    // Open a world file (createWorldFile) and start at (1, 1). 'cacheTiles' bounds resident
+    // memory at cacheTiles * 4 KB of maze; it is raised to fit the active window twice over.
+    bool open(const std::string& filename, std::size_t cacheTiles = 1024, std::string* error = nullptr) {
+        if (!world.open(filename, error)) return false;
+        const std::size_t windowSize = static_cast<std::size_t>(2 * activeRadius + 1) * (2 * activeRadius + 1);
+        world.setCacheTiles(cacheTiles < 2 * windowSize ? 2 * windowSize : cacheTiles);
+        seed = world.getSeed();
+        seedKey = seedKey32(seed);
+        player.setPosition(1, 1);
+        score = moves = collected = 0;
+        gameOver = false;
+        tick = 0;
+        xs.clear();
+        ys.clear();
+        lastMove.clear();
+        bucketSlot.clear();
+        tileEnemies.clear();
+        spawned.assign((world.getTileCount() + 63) / 64, 0);
+        enemyMoves = catchUpMoves = 0;
+        updateWindow(true);
+        return true;
+    }
+
+    // Enemies created per tile (before the first open(); default 4)
+    void setEnemiesPerTile(int count) { enemiesPerTile = count < 0 ? 0 : count; }
+    // Window half-size in tiles (before the first open(); default 1, i.e. 3 x 3 tiles)
+    void setActiveRadius(int tiles) { activeRadius = tiles < 0 ? 0 : tiles; }
+
+    // Advance by one player action, turn-based like MazeSim. Returns SimEvent flags.
+    unsigned step(SimAction action) {
+        if (gameOver) return EVENT_NONE;
+        int dx = 0, dy = 0;
+        switch (action) {
+            case ACTION_UP: dx = -1; break;
+            case ACTION_DOWN: dx = 1; break;
+            case ACTION_LEFT: dy = -1; break;
+            case ACTION_RIGHT: dy = 1; break;
+            default: return EVENT_NONE;
+        }
+        const int nx = player.getX() + dx, ny = player.getY() + dy;
+        if (world.isWall(nx, ny)) return EVENT_BLOCKED;
+        unsigned events = EVENT_MOVED;
+        player.setPosition(nx, ny);
+        moves++;
+        if (world.takeItem(nx, ny)) {
+            score += 10;
+            collected++;
+            events |= EVENT_COLLECTED;
+        }
+        updateWindow(false);
+        if (enemyAt(nx, ny)) gameOver = true;
+        else moveEnemies();
+        if (gameOver) events |= EVENT_CAUGHT;
+        return events;
+    }
+
+    // Carry on after being caught, score and moves kept (the console's "continue", benchmarks)
+    void revive() { gameOver = false; }
+
+    // Put the player on (x, y) if it is open (tools, benchmarks: fast travel to cold tiles)
+    bool teleport(int x, int y) {
+        if (world.isWall(x, y)) return false;
+        player.setPosition(x, y);
+        updateWindow(false);
+        return true;
+    }
+
+    // --- Getters ---
+    const ChunkedWorld& getWorld() const { return world; }
+    char getCell(int x, int y) const { return world.getCell(x, y); }
+    int getRows() const { return world.getRows(); }
+    int getCols() const { return world.getCols(); }
+    int getPlayerX() const { return player.getX(); }
+    int getPlayerY() const { return player.getY(); }
+    const Player& getPlayer() const { return player; }
+    int getScore() const { return score; }
+    int getMoves() const { return moves; }
+    int getCollected() const { return collected; }
+    bool isGameOver() const { return gameOver; }
+    std::uint32_t getTick() const { return tick; }
+    std::size_t enemyCount() const { return xs.size(); }     // Created so far
+    std::size_t windowTileCount() const { return windowTiles.size(); }
+    std::uint64_t getEnemyMoves() const { return enemyMoves; }     // Moves made in the window
+    std::uint64_t getCatchUpMoves() const { return catchUpMoves; } // Moves made up on waking
+
+    // fn(x, y) for every enemy in 'tile' (drawing)
+    template <typename Fn>
+    void forEachEnemyInTile(std::uint32_t tile, Fn fn) const {
+        auto found = tileEnemies.find(tile);
+        if (found == tileEnemies.end()) return;
+        for (std::uint32_t id : found->second) fn(xs[id], ys[id]);
+    }
+    // --- End Getters ---
+};
+
+// Draw the view around the player, like drawMazeFrame: the squares come through the tile
+// cache and the enemies from the buckets of the tiles the view overlaps
+inline void drawWorldFrame(FrameRenderer& renderer, const WorldSim& sim, int viewRows = DEFAULT_VIEW_ROWS,
+                           int viewCols = DEFAULT_VIEW_COLS) {
+    const int rows = sim.getRows() < viewRows ? sim.getRows() : viewRows;
+    const int cols = sim.getCols() < viewCols ? sim.getCols() : viewCols;
+    int top = sim.getPlayerX() - rows / 2;
+    int left = sim.getPlayerY() - cols / 2;
+    if (top > sim.getRows() - rows) top = sim.getRows() - rows;
+    if (left > sim.getCols() - cols) left = sim.getCols() - cols;
+    if (top < 0) top = 0;
+    if (left < 0) left = 0;
+
+    const ChunkedWorld& world = sim.getWorld();
+    std::string status = "Score: " + std::to_string(sim.getScore()) + " | Moves: " + std::to_string(sim.getMoves()) +
+                         " | (" + std::to_string(sim.getPlayerX()) + ", " + std::to_string(sim.getPlayerY()) +
+                         ") | Tiles: " + std::to_string(world.residentTiles()) + "/" + std::to_string(world.getCacheTiles());
+    int width = cols * 2;
+    if (static_cast<int>(status.size()) > width) width = static_cast<int>(status.size());
+    renderer.beginFrame(width, rows + 2);
+    renderer.text(0, 0, "--- Maze World --- " + std::to_string(sim.getRows()) + " x " + std::to_string(sim.getCols()) + " ---");
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            const char cell = world.getCell(top + i, left + j);
+            renderer.put(1 + i, j * 2, cell, cell == '#' ? COLOR_WALL : cell == '*' ? COLOR_ITEM : COLOR_DEFAULT);
+        }
+    }
+    const std::uint32_t tileCols = static_cast<std::uint32_t>((sim.getCols() + WORLD_TILE - 1) / WORLD_TILE);
+    for (int tx = top / WORLD_TILE; tx <= (top + rows - 1) / WORLD_TILE; tx++) {
+        for (int ty = left / WORLD_TILE; ty <= (left + cols - 1) / WORLD_TILE; ty++) {
+            sim.forEachEnemyInTile(static_cast<std::uint32_t>(tx) * tileCols + static_cast<std::uint32_t>(ty), [&](int x, int y) {
+                if (x >= top && x < top + rows && y >= left && y < left + cols) renderer.put(1 + x - top, (y - left) * 2, ENEMY_SYMBOL, COLOR_ENEMY);
+            });
+        }
+    }
+    renderer.put(1 + sim.getPlayerX() - top, (sim.getPlayerY() - left) * 2, sim.getPlayer().getSymbol(), COLOR_PLAYER);
+    renderer.text(rows + 1, 0, status);
+}
+
+#endif // WORLD_SIM_H